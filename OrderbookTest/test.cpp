@@ -1,12 +1,42 @@
 #include "pch.h"
 
 #include "../src/include/OrderBook.hpp"
+#include "../src/include/BinaryProtocol.hpp"
+#include "../src/include/CommandLog.hpp"
+#include "../src/include/Journal.hpp"
+#include "../src/include/MarketByOrderBook.hpp"
+#include "../src/include/MatchingEngine.hpp"
+#include "../src/include/OrderBookManager.hpp"
 #include "../src/include/PooledShared.hpp"
 #include "../src/include/MemoryPool.hpp"
+#include <atomic>
 #include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <random>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace googletest = ::testing;
 
+// Every global operator new in the test binary is counted, so a test can
+// assert that a stretch of book calls did not touch the heap
+static std::atomic<std::size_t> heap_allocations{ 0 };
+
+void* operator new(std::size_t size)
+{
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc{};
+}
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
 enum class ActionType
 {
     Add,
@@ -39,6 +69,8 @@ using Results = std::vector<Result>;
 struct InputHandler
 {
 private:
+    TickSize tick_size_{};
+
     std::uint32_t ToNumber(const std::string_view& str) const
     {
         std::int64_t value{};
@@ -137,7 +169,7 @@ private:
         if (str.empty())
             throw std::logic_error("Unknown Price");
 
-        return ToNumber(str);
+        return tick_size_.to_ticks(str);
     }
 
     Quantity ParseQuantity(const std::string_view& str) const
@@ -157,6 +189,8 @@ private:
     }
 
 public:
+    const TickSize& GetTickSize() const { return tick_size_; }
+
     std::tuple<Informations, Result> GetInformations(const std::filesystem::path& path) const
     {
         Informations actions;
@@ -210,79 +244,1711 @@ private:
     const static inline std::filesystem::path TestFolder{ "TestFiles" };
 public:
     const static inline std::filesystem::path TestFolderPath{ Root / TestFolder };
+
+protected:
+    // Replays the scenario file against a book built from config.
+    // config.tick_size_ is taken from the InputHandler that parsed the prices.
+    void RunScenario(OrderBookConfig config)
+    {
+        // Arrange
+        const auto file = OrderbookTestsFixture::TestFolderPath / GetParam();
+
+        InputHandler handler;
+        const auto [actions, result] = handler.GetInformations(file);
+
+        auto GetOrder = [](const Information& action)
+        {
+            static MemoryPool<Order> order_pool; // local pool for test-created orders
+            return make_intrusive_pooled_order(
+                &order_pool,
+                action.orderType_,
+                action.side_,
+                action.orderId_,
+                action.price_,
+                action.quantity_);
+        };
+
+        config.tick_size_ = handler.GetTickSize();
+        OrderBook orderbook{ config };
+        auto GetOrderModify = [&orderbook](const Information& action)
+        {
+            static MemoryPool<Order> order_pool; // pool for modified orders
+            return OrderModify(
+                &order_pool,
+                orderbook.get_order_by_id(action.orderId_)->get_order_type(),
+                action.side_,
+                action.orderId_,
+                action.price_,
+                action.quantity_);
+        };
+
+        // Act
+        for (const auto& action : actions)
+        {
+            switch (action.type_)
+            {
+            case ActionType::Add:
+            {
+                const auto& trades = orderbook.add_order(GetOrder(action));
+            }
+            break;
+            case ActionType::Modify:
+            {
+                const auto& trades = orderbook.modify_order(GetOrderModify(action));
+            }
+            break;
+            case ActionType::Cancel:
+            {
+                orderbook.cancel_order(action.orderId_);
+            }
+            break;
+            default:
+                throw std::logic_error("Unsupported Action.");
+            }
+        }
+
+        // Assert
+        const auto& orderbookInfos = orderbook.get_order_book();
+        ASSERT_EQ(orderbook.Size(), result.allCount_);
+        ASSERT_EQ(orderbookInfos.get_bids().size(), result.bidCount_);
+        ASSERT_EQ(orderbookInfos.get_asks().size(), result.askCount_);
+    }
 };
 
 TEST_P(OrderbookTestsFixture, OrderbookTestSuite)
 {
-    // Arrange
-    const auto file = OrderbookTestsFixture::TestFolderPath / GetParam();
+    RunScenario(OrderBookConfig{});
+}
+
+TEST_P(OrderbookTestsFixture, OrderbookDenseLadderTestSuite)
+{
+    // Band covers 95.00-104.99 so the scenarios exercise both the dense
+    // array and the out-of-band map fallback (e.g. Match_Market's 105-109).
+    OrderBookConfig config;
+    config.ladder_base_price_ = 9'500;
+    config.ladder_levels_ = 1'000;
+    RunScenario(config);
+}
+
+TEST_P(OrderbookTestsFixture, OrderbookDirectIndexTestSuite)
+{
+    // Ids in the scenario files start at 1; base 1 keeps them all in the paged table
+    OrderBookConfig config;
+    config.order_index_mode_ = OrderIndexMode::Direct;
+    config.order_index_base_id_ = 1;
+    RunScenario(config);
+}
+
+TEST_P(OrderbookTestsFixture, OrderbookLazyGrowthTestSuite)
+{
+    // Nothing pre-sized: order table and level arena grow from empty
+    OrderBookConfig config;
+    config.growth_policy_ = GrowthPolicy::Lazy;
+    config.expected_orders_ = 0;
+    config.expected_levels_ = 0;
+    RunScenario(config);
+}
+
+INSTANTIATE_TEST_CASE_P(Tests, OrderbookTestsFixture, googletest::ValuesIn({
+    "Match_GoodTillCancel.txt",
+    "Match_FillAndKill.txt",
+    "Match_FillOrKill_Hit.txt",
+    "Match_FillOrKill_Miss.txt",
+    "Cancel_Success.txt",
+    "Modify_Side.txt",
+    "Match_Market.txt"
+}));
+
+TEST(TickSizeTests, ParsesExactDecimalsOnly)
+{
+    const TickSize tick_size{};
+    ASSERT_EQ(tick_size.to_ticks("0.50"), 50);
+    ASSERT_EQ(tick_size.to_ticks("12"), 1200);
+    ASSERT_THROW(tick_size.to_ticks("0.505"), std::invalid_argument);
+    ASSERT_THROW(tick_size.to_ticks("-0.50"), std::invalid_argument); // not +0.50
+    ASSERT_THROW(tick_size.to_ticks("-1.00"), std::invalid_argument);
+    ASSERT_THROW(tick_size.to_ticks("+0.50"), std::invalid_argument);
+    ASSERT_THROW(tick_size.to_ticks(".50"), std::invalid_argument);
+    ASSERT_THROW(TickSize::from_string("-0.01"), std::invalid_argument);
+    ASSERT_EQ(TickSize::from_string("0.0005").get_tick_nanos(), 500'000);
+}
+
+TEST(OrderbookDepthTests, AvailableLiquidityMatchesLevels)
+{
+    // Map-only, and a band that leaves levels on both sides of it in the map fallback
+    OrderBookConfig map_config;
+    OrderBookConfig ladder_config;
+    ladder_config.ladder_base_price_ = 95;
+    ladder_config.ladder_levels_ = 10;
+
+    for (const auto& config : { map_config, ladder_config })
+    {
+        static MemoryPool<Order> order_pool;
+        OrderBook orderbook{ config };
+        OrderId id = 0;
+        for (Price price = 80; price < 100; ++price)
+            orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Buy, ++id, price, static_cast<Quantity>(price)));
+        for (Price price = 100; price < 120; ++price)
+            orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, ++id, price, static_cast<Quantity>(price)));
+        orderbook.cancel_order(10); // bid level 89 drops out
+        orderbook.cancel_order(25); // ask level 104 drops out
+
+        const auto levels = orderbook.get_order_book();
+        for (Price limit = 70; limit < 130; ++limit)
+        {
+            std::int64_t asks_through = 0, bids_through = 0;
+            for (const auto& [price, level] : levels.get_asks())
+                if (price <= limit) asks_through += level.quantity_;
+            for (const auto& [price, level] : levels.get_bids())
+                if (price >= limit) bids_through += level.quantity_;
+
+            ASSERT_EQ(orderbook.available_liquidity(OrderSide::Buy, limit), asks_through);
+            ASSERT_EQ(orderbook.available_liquidity(OrderSide::Sell, limit), bids_through);
+        }
+    }
+}
+
+TEST(OrderbookDepthTests, DeepSweepsUpdateEachLevelOnce)
+{
+    // Asks 100-109, five orders each; the band covers 100-104, the rest are map levels
+    OrderBookConfig map_config;
+    OrderBookConfig ladder_config;
+    ladder_config.ladder_base_price_ = 100;
+    ladder_config.ladder_levels_ = 5;
+
+    for (const auto& config : { map_config, ladder_config })
+    {
+        static MemoryPool<Order> order_pool;
+        OrderBook orderbook{ config };
+        OrderId id = 0;
+        for (Price price = 100; price < 110; ++price)
+            for (int i = 0; i < 5; ++i)
+                orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, ++id, price, 10));
+
+        // Seven whole levels and two orders into 107
+        auto trades = orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Buy, ++id, 107, 370)).trades_made_;
+        ASSERT_EQ(trades.size(), 37u);
+        auto levels = orderbook.get_order_book();
+        ASSERT_TRUE(levels.get_bids().empty());
+        ASSERT_EQ(levels.get_asks().size(), 3u);
+        ASSERT_EQ(levels.get_asks().at(107).quantity_, 30);
+        ASSERT_EQ(levels.get_asks().at(107).count_, 3);
+        ASSERT_EQ(orderbook.available_liquidity(OrderSide::Buy, 109), 130);
+        ASSERT_EQ(orderbook.get_order_by_id(38)->get_quantity(), 10);
+
+        // The sweep path: the rest of 107, all of 108 and two orders into 109
+        trades = orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::Market, OrderSide::Buy, ++id, Constants::InvalidPrice, 100)).trades_made_;
+        ASSERT_EQ(trades.size(), 10u);
+        ASSERT_EQ(trades.back().get_trade_price(), 109);
+        levels = orderbook.get_order_book();
+        ASSERT_EQ(levels.get_asks().size(), 1u);
+        ASSERT_EQ(levels.get_asks().at(109).quantity_, 30);
+        ASSERT_EQ(levels.get_asks().at(109).count_, 3);
+        ASSERT_EQ(orderbook.available_liquidity(OrderSide::Buy, 109), 30);
+        ASSERT_EQ(orderbook.Size(), 3u);
+    }
+}
+
+TEST(OrderbookSnapshotTests, SnapshotMatchesTopOfBook)
+{
+    static MemoryPool<Order> order_pool;
+    OrderBookConfig config;
+    config.snapshot_depth_ = 3;
+    OrderBook orderbook{ config };
+
+    BookSnapshot snapshot{ config.snapshot_depth_ };
+    orderbook.read_snapshot(snapshot);
+    ASSERT_EQ(snapshot.sequence_, 0u);
+
+    OrderId id = 0;
+    for (Price price = 90; price < 100; ++price)
+        orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Buy, ++id, price, 10));
+    for (Price price = 101; price < 103; ++price)
+        orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, ++id, price, 10));
+    orderbook.cancel_order(10); // best bid 99 drops out
+    orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Buy, ++id, 101, 4)); // trades
+
+    orderbook.read_snapshot(snapshot);
+    ASSERT_EQ(snapshot.sequence_, orderbook.snapshot_sequence());
+    ASSERT_EQ(snapshot.sequence_, 14u);
+
+    const auto levels = orderbook.get_order_book();
+    ASSERT_EQ(snapshot.bid_count_, 3u);
+    ASSERT_EQ(snapshot.ask_count_, 2u);
+    auto bid = levels.get_bids().begin();
+    for (std::size_t slot = 0; slot < snapshot.bid_count_; ++slot, ++bid)
+    {
+        ASSERT_EQ(snapshot.bids_[slot].price_, bid->second.price_);
+        ASSERT_EQ(snapshot.bids_[slot].quantity_, bid->second.quantity_);
+        ASSERT_EQ(snapshot.bids_[slot].count_, bid->second.count_);
+    }
+    auto ask = levels.get_asks().begin();
+    for (std::size_t slot = 0; slot < snapshot.ask_count_; ++slot, ++ask)
+    {
+        ASSERT_EQ(snapshot.asks_[slot].price_, ask->second.price_);
+        ASSERT_EQ(snapshot.asks_[slot].quantity_, ask->second.quantity_);
+    }
+    ASSERT_EQ(snapshot.asks_[0].quantity_, 6);
 
-    InputHandler handler;
-    const auto [actions, result] = handler.GetInformations(file);
+    // Behind the published top 3: nothing visible changes, nothing is published
+    orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Buy, ++id, 80, 10));
+    ASSERT_EQ(orderbook.snapshot_sequence(), 14u);
+    orderbook.cancel_order(9); // bid level 98, inside the top 3
+    ASSERT_EQ(orderbook.snapshot_sequence(), 15u);
+}
+
+TEST(OrderbookSnapshotTests, ConcurrentReadersSeeConsistentBooks)
+{
+    // Each published book is uncrossed with strictly ordered levels; a torn
+    // read would mix levels from two publications and break that
+    static MemoryPool<Order> order_pool;
+    OrderBookConfig config;
+    config.snapshot_depth_ = 8;
+    OrderBook orderbook{ config };
 
-    auto GetOrder = [](const Information& action)
+    std::atomic<bool> done{ false };
+    std::atomic<bool> consistent{ true };
+    std::vector<std::thread> readers;
+    for (int reader = 0; reader < 2; ++reader)
+    {
+        readers.emplace_back([&]() {
+            BookSnapshot snapshot{ config.snapshot_depth_ };
+            std::uint64_t last_sequence = 0;
+            while (!done.load(std::memory_order_acquire))
+            {
+                orderbook.read_snapshot(snapshot);
+                bool ok = snapshot.sequence_ >= last_sequence;
+                for (std::size_t slot = 1; slot < snapshot.bid_count_; ++slot)
+                    ok = ok && snapshot.bids_[slot].price_ < snapshot.bids_[slot - 1].price_;
+                for (std::size_t slot = 1; slot < snapshot.ask_count_; ++slot)
+                    ok = ok && snapshot.asks_[slot].price_ > snapshot.asks_[slot - 1].price_;
+                if (snapshot.bid_count_ && snapshot.ask_count_)
+                    ok = ok && snapshot.bids_[0].price_ < snapshot.asks_[0].price_;
+                if (!ok)
+                    consistent.store(false);
+                last_sequence = snapshot.sequence_;
+            }
+        });
+    }
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> price_dist(90, 110);
+    std::uniform_int_distribution<int> side_dist(0, 1);
+    for (OrderId id = 1; id <= 20000; ++id)
+    {
+        auto side = side_dist(rng) ? OrderSide::Buy : OrderSide::Sell;
+        orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, side, id, price_dist(rng), 10));
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& reader : readers)
+        reader.join();
+
+    ASSERT_TRUE(consistent.load());
+}
+
+TEST(OrderbookLevelDeltaTests, DeltasRebuildTheBook)
+{
+    // A consumer applying the deltas to its own copy must end up with exactly
+    // get_order_book(), after flow that crosses, cancels and modifies
+    static MemoryPool<Order> order_pool;
+    OrderBookConfig config;
+    config.level_delta_capacity_ = 64;
+    OrderBook orderbook{ config };
+
+    std::map<Price, LevelInfo> bids, asks;
+    std::uint64_t last_sequence = 0;
+    bool ordered = true, applicable = true;
+    auto apply = [&](const LevelDelta& delta) {
+        ordered = ordered && delta.sequence_ == last_sequence + 1;
+        last_sequence = delta.sequence_;
+        auto& levels = delta.side_ == OrderSide::Buy ? bids : asks;
+        const bool known = levels.contains(delta.price_);
+        switch (delta.action_)
+        {
+        case LevelAction::New:
+            applicable = applicable && !known;
+            levels[delta.price_] = LevelInfo{ delta.price_, delta.quantity_, delta.count_ };
+            break;
+        case LevelAction::Change:
+            applicable = applicable && known;
+            levels[delta.price_] = LevelInfo{ delta.price_, delta.quantity_, delta.count_ };
+            break;
+        case LevelAction::Delete:
+            applicable = applicable && known;
+            levels.erase(delta.price_);
+            break;
+        }
+    };
+
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> price_dist(95, 105);
+    std::uniform_int_distribution<int> action_dist(0, 9);
+    std::uniform_int_distribution<int> side_dist(0, 1);
+    std::uniform_int_distribution<Quantity> quantity_dist(1, 30);
+    OrderId id = 0;
+    for (int i = 0; i < 5000; ++i)
+    {
+        auto side = side_dist(rng) ? OrderSide::Buy : OrderSide::Sell;
+        auto action = action_dist(rng);
+        if (action < 6 || id == 0)
+            orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, side, ++id, price_dist(rng), quantity_dist(rng)));
+        else if (action < 8)
+            orderbook.cancel_order(std::uniform_int_distribution<OrderId>(1, id)(rng));
+        else
+            orderbook.modify_order(OrderModify(&order_pool, OrderType::GoodTillCancel, side, std::uniform_int_distribution<OrderId>(1, id)(rng), price_dist(rng), quantity_dist(rng)));
+        if (i % 7 == 0)
+            orderbook.drain_level_deltas(apply);
+    }
+    orderbook.drain_level_deltas(apply);
+
+    ASSERT_TRUE(ordered);
+    ASSERT_TRUE(applicable);
+    ASSERT_EQ(last_sequence, orderbook.level_delta_sequence());
+    const auto levels = orderbook.get_order_book();
+    ASSERT_EQ(bids.size(), levels.get_bids().size());
+    ASSERT_EQ(asks.size(), levels.get_asks().size());
+    for (const auto& [price, level] : levels.get_bids())
+    {
+        ASSERT_EQ(bids[price].quantity_, level.quantity_);
+        ASSERT_EQ(bids[price].count_, level.count_);
+    }
+    for (const auto& [price, level] : levels.get_asks())
+    {
+        ASSERT_EQ(asks[price].quantity_, level.quantity_);
+        ASSERT_EQ(asks[price].count_, level.count_);
+    }
+}
+
+TEST(OrderbookLevelDeltaTests, CoalescesWithinOneMessage)
+{
+    static MemoryPool<Order> order_pool;
+    OrderBookConfig config;
+    config.level_delta_capacity_ = 16;
+    OrderBook orderbook{ config };
+
+    OrderId id = 0;
+    for (int i = 0; i < 5; ++i)
+        orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, ++id, 100, 10));
+    orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, ++id, 101, 10));
+    std::vector<LevelDelta> deltas;
+    orderbook.drain_level_deltas([&deltas](const LevelDelta& delta) { deltas.push_back(delta); });
+    ASSERT_EQ(deltas.size(), 6u); // New 100, 4 x Change 100, New 101
+    deltas.clear();
+
+    // Fills against all five orders at 100 and one at 101: one delta per level
+    // (the buyer never rests, so its level appears and disappears unseen)
+    orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Buy, ++id, 101, 55), [](const TradeInfo&) {});
+    orderbook.drain_level_deltas([&deltas](const LevelDelta& delta) { deltas.push_back(delta); });
+    ASSERT_EQ(deltas.size(), 2u);
+    ASSERT_EQ(deltas[0].side_, OrderSide::Sell);
+    ASSERT_EQ(deltas[0].price_, 100);
+    ASSERT_EQ(deltas[0].action_, LevelAction::Delete);
+    ASSERT_FALSE(deltas[0].end_of_message_);
+    ASSERT_EQ(deltas[1].price_, 101);
+    ASSERT_EQ(deltas[1].action_, LevelAction::Change);
+    ASSERT_EQ(deltas[1].quantity_, 5);
+    ASSERT_EQ(deltas[1].count_, 1);
+    ASSERT_TRUE(deltas[1].end_of_message_);
+    ASSERT_EQ(deltas[1].sequence_, 8u);
+}
+
+TEST(OrderbookOrderEventTests, BuilderRebuildsTheBook)
+{
+    static MemoryPool<Order> order_pool;
+    OrderBookConfig config;
+    config.order_event_capacity_ = 1 << 16;
+    OrderBook orderbook{ config };
+    MarketByOrderBook rebuilt;
+
+    std::mt19937 rng(9);
+    std::uniform_int_distribution<int> price_dist(95, 105);
+    std::uniform_int_distribution<int> action_dist(0, 9);
+    std::uniform_int_distribution<int> side_dist(0, 1);
+    std::uniform_int_distribution<Quantity> quantity_dist(1, 30);
+    OrderId id = 0;
+    bool consistent = true;
+    OrderEvent event;
+    for (int i = 0; i < 5000; ++i)
+    {
+        auto side = side_dist(rng) ? OrderSide::Buy : OrderSide::Sell;
+        auto action = action_dist(rng);
+        if (action < 6 || id == 0)
+        {
+            auto type = action == 0 ? OrderType::FillAndKill : OrderType::GoodTillCancel;
+            orderbook.add_order(make_intrusive_pooled_order(&order_pool, type, side, ++id, price_dist(rng), quantity_dist(rng)));
+        }
+        else if (action < 8)
+            orderbook.cancel_order(std::uniform_int_distribution<OrderId>(1, id)(rng));
+        else
+            orderbook.modify_order(OrderModify(&order_pool, OrderType::GoodTillCancel, side, std::uniform_int_distribution<OrderId>(1, id)(rng), price_dist(rng), quantity_dist(rng)));
+        while (orderbook.try_poll_order_event(event))
+            consistent = rebuilt.apply(event) && consistent;
+    }
+
+    ASSERT_TRUE(consistent);
+    ASSERT_EQ(orderbook.order_events_dropped(), 0u);
+    ASSERT_EQ(rebuilt.size(), orderbook.Size());
+    const auto levels = orderbook.get_order_book();
+    const auto rebuilt_levels = rebuilt.get_order_book();
+    ASSERT_EQ(rebuilt_levels.get_bids().size(), levels.get_bids().size());
+    ASSERT_EQ(rebuilt_levels.get_asks().size(), levels.get_asks().size());
+    for (const auto& [price, level] : levels.get_bids())
+    {
+        ASSERT_EQ(rebuilt_levels.get_bids().at(price).quantity_, level.quantity_);
+        ASSERT_EQ(rebuilt_levels.get_bids().at(price).count_, level.count_);
+    }
+    for (const auto& [price, level] : levels.get_asks())
+    {
+        ASSERT_EQ(rebuilt_levels.get_asks().at(price).quantity_, level.quantity_);
+        ASSERT_EQ(rebuilt_levels.get_asks().at(price).count_, level.count_);
+    }
+    for (OrderId order_id = 1; order_id <= id; ++order_id)
+    {
+        auto order = orderbook.get_order_by_id(order_id);
+        ASSERT_EQ(rebuilt.leaves(order_id), order ? order->get_quantity() : 0);
+    }
+}
+
+TEST(OrderbookOrderEventTests, ExecutionsKeepQueuePosition)
+{
+    static MemoryPool<Order> order_pool;
+    OrderBookConfig config;
+    config.order_event_capacity_ = 64;
+    OrderBook orderbook{ config };
+    MarketByOrderBook rebuilt;
+
+    for (OrderId id = 1; id <= 3; ++id)
+        orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, id, 100, 10));
+    orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Buy, 4, 100, 15));
+
+    std::vector<OrderEvent> events;
+    OrderEvent event;
+    while (orderbook.try_poll_order_event(event))
+    {
+        events.push_back(event);
+        ASSERT_TRUE(rebuilt.apply(event));
+    }
+    // 3 Added sells, Added buy, then 2 fills with an Executed per side each
+    ASSERT_EQ(events.size(), 8u);
+    ASSERT_EQ(events[4].kind_, OrderEventKind::Executed);
+    ASSERT_EQ(events[4].order_id_, 4);
+    ASSERT_EQ(events[4].contra_id_, 1);
+    ASSERT_EQ(events[4].leaves_, 5);
+    ASSERT_EQ(events[7].kind_, OrderEventKind::Executed);
+    ASSERT_EQ(events[7].order_id_, 2);
+    ASSERT_EQ(events[7].quantity_, 5);
+    ASSERT_EQ(events[7].leaves_, 5);
+
+    ASSERT_EQ(rebuilt.queue_position(1), -1);
+    ASSERT_EQ(rebuilt.queue_position(2), 0);
+    ASSERT_EQ(rebuilt.queue_position(3), 1);
+    ASSERT_EQ(rebuilt.leaves(2), 5);
+
+    orderbook.cancel_order(2);
+    ASSERT_TRUE(orderbook.try_poll_order_event(event));
+    ASSERT_EQ(event.kind_, OrderEventKind::Deleted);
+    ASSERT_EQ(event.quantity_, 5);
+    ASSERT_TRUE(rebuilt.apply(event));
+    ASSERT_EQ(rebuilt.queue_position(3), 0);
+}
+
+TEST(OrderbookOrderEventTests, SweepingOrdersNeverRest)
+{
+    static MemoryPool<Order> order_pool;
+    OrderBookConfig config;
+    config.order_event_capacity_ = 64;
+    config.level_delta_capacity_ = 64;
+    OrderBook orderbook{ config };
+    MarketByOrderBook rebuilt;
+    auto apply_events = [&]() {
+        std::vector<OrderEvent> events;
+        OrderEvent event;
+        while (orderbook.try_poll_order_event(event))
+        {
+            events.push_back(event);
+            EXPECT_TRUE(rebuilt.apply(event));
+        }
+        return events;
+    };
+    orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, 1, 100, 10));
+    orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, 2, 100, 10));
+    orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, 3, 101, 10));
+    apply_events();
+
+    // Walks 100 then 101 at the resting prices; only the resting orders report
+    auto trades = orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::Market, OrderSide::Buy, 10, Constants::InvalidPrice, 25)).trades_made_;
+    ASSERT_EQ(trades.size(), 3u);
+    ASSERT_EQ(trades[2].get_trade_price(), 101);
+    ASSERT_EQ(trades[2].get_quantity(), 5);
+    auto events = apply_events();
+    ASSERT_EQ(events.size(), 3u);
+    for (const auto& executed : events)
+    {
+        ASSERT_EQ(executed.kind_, OrderEventKind::Executed);
+        ASSERT_EQ(executed.contra_id_, 10);
+    }
+    ASSERT_EQ(orderbook.Size(), 1u);
+    ASSERT_EQ(rebuilt.leaves(3), 5);
+    ASSERT_FALSE(orderbook.get_order_by_id(10));
+
+    // A market order larger than the book leaves nothing behind either
+    orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Buy, 11, 99, 20));
+    trades = orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::Market, OrderSide::Sell, 12, Constants::InvalidPrice, 50)).trades_made_;
+    ASSERT_EQ(trades.size(), 1u);
+    ASSERT_EQ(trades[0].get_trade_price(), 99);
+    ASSERT_EQ(orderbook.Size(), 1u);
+    ASSERT_TRUE(orderbook.get_order_book().get_bids().empty());
+
+    // Modified into a FillAndKill: leaves its level, trades, and the rest is dropped
+    orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Buy, 13, 98, 10));
+    apply_events();
+    trades = orderbook.modify_order(OrderModify(&order_pool, OrderType::FillAndKill, OrderSide::Buy, 13, 101, 10)).trades_made_;
+    ASSERT_EQ(trades.size(), 1u);
+    ASSERT_EQ(trades[0].get_quantity(), 5);
+    events = apply_events();
+    ASSERT_EQ(events.size(), 2u);
+    ASSERT_EQ(events[0].kind_, OrderEventKind::Deleted);
+    ASSERT_EQ(events[1].order_id_, 3);
+    ASSERT_EQ(orderbook.Size(), 0u);
+    ASSERT_EQ(rebuilt.size(), 0u);
+    ASSERT_TRUE(orderbook.get_order_book().get_asks().empty());
+    ASSERT_TRUE(orderbook.get_order_book().get_bids().empty());
+}
+
+TEST(OrderbookModifyTests, SizeDownKeepsPriorityAndRepriceReusesTheOrder)
+{
+    static MemoryPool<Order> order_pool;
+    OrderBookConfig config;
+    config.order_event_capacity_ = 64;
+    OrderBook orderbook{ config };
+    MarketByOrderBook rebuilt;
+    auto apply_events = [&]() {
+        std::vector<OrderEvent> events;
+        OrderEvent event;
+        while (orderbook.try_poll_order_event(event))
+        {
+            events.push_back(event);
+            EXPECT_TRUE(rebuilt.apply(event));
+        }
+        return events;
+    };
+    for (OrderId id = 1; id <= 3; ++id)
+        orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, id, 100, 10));
+    apply_events();
+
+    // Cut at the same price: one Reduced event, still first in the queue
+    auto* first = orderbook.get_order_by_id(1).get();
+    orderbook.modify_order(OrderModify(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, 1, 100, 4));
+    auto events = apply_events();
+    ASSERT_EQ(events.size(), 1u);
+    ASSERT_EQ(events[0].kind_, OrderEventKind::Reduced);
+    ASSERT_EQ(events[0].quantity_, 6);
+    ASSERT_EQ(events[0].leaves_, 4);
+    ASSERT_EQ(rebuilt.queue_position(1), 0);
+    ASSERT_EQ(orderbook.get_order_by_id(1).get(), first);
+
+    // The same quantity again: nothing changed, so no event and no level delta
+    std::size_t deltas = 0;
+    orderbook.drain_level_deltas([&deltas](const LevelDelta&) { ++deltas; });
+    orderbook.modify_order(OrderModify(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, 1, 100, 4));
+    ASSERT_TRUE(apply_events().empty());
+    orderbook.drain_level_deltas([&deltas](const LevelDelta&) { ++deltas; });
+    ASSERT_EQ(deltas, 0u);
+    ASSERT_EQ(rebuilt.queue_position(1), 0);
+
+    // Larger, or at another price: to the back of the level, same Order object
+    orderbook.modify_order(OrderModify(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, 2, 100, 12));
+    auto* third = orderbook.get_order_by_id(3).get();
+    orderbook.modify_order(OrderModify(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, 3, 101, 10));
+    ASSERT_EQ(orderbook.get_order_by_id(3).get(), third);
+    apply_events();
+    ASSERT_EQ(rebuilt.queue_position(2), 1);
+    ASSERT_EQ(rebuilt.queue_position(3), 0);
+
+    const auto trades = orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Buy, 4, 101, 20));
+    ASSERT_EQ(trades.trades_made_.size(), 3u);
+    ASSERT_EQ(trades.trades_made_[0].get_sell().id_, 1);
+    ASSERT_EQ(trades.trades_made_[0].get_quantity(), 4);
+    ASSERT_EQ(trades.trades_made_[1].get_sell().id_, 2);
+    ASSERT_EQ(trades.trades_made_[1].get_quantity(), 12);
+    ASSERT_EQ(trades.trades_made_[2].get_sell().id_, 3);
+    ASSERT_EQ(trades.trades_made_[2].get_quantity(), 4);
+    ASSERT_EQ(orderbook.Size(), 1u);
+}
+
+TEST(OrderbookBatchTests, BatchMatchesPerMessageCalls)
+{
+    static MemoryPool<Order> order_pool;
+    std::mt19937 rng(23);
+    std::vector<OrderCommand> commands;
+    OrderId id = 0;
+    for (int i = 0; i < 4'000; ++i)
+    {
+        OrderCommand command;
+        const int kind = std::uniform_int_distribution<int>(0, 9)(rng);
+        command.side_ = kind % 2 ? OrderSide::Buy : OrderSide::Sell;
+        command.price_ = 10'000 + std::uniform_int_distribution<Price>(-20, 20)(rng);
+        command.quantity_ = std::uniform_int_distribution<Quantity>(1, 50)(rng);
+        if (kind == 0 && id > 0)
+        {
+            command.command_ = CommandType::Cancel;
+            command.order_id_ = std::uniform_int_distribution<OrderId>(1, id)(rng);
+        }
+        else if (kind == 1 && id > 0)
+        {
+            command.command_ = CommandType::Modify;
+            command.order_id_ = std::uniform_int_distribution<OrderId>(1, id)(rng);
+        }
+        else if (i == 3'000)
+            command.command_ = CommandType::MassCancel;
+        else
+        {
+            command.order_type_ = kind == 2 ? OrderType::FillAndKill : OrderType::GoodTillCancel;
+            command.order_id_ = ++id;
+        }
+        commands.push_back(command);
+    }
+
+    // One call per command, recording what apply_batch should report
+    OrderBook single;
+    std::vector<TradeInfo> single_trades;
+    std::vector<CommandResult> expected(commands.size());
+    for (std::size_t i = 0; i < commands.size(); ++i)
+    {
+        const auto& command = commands[i];
+        const auto size_before = single.Size();
+        const bool resting = single.get_order_by_id(command.order_id_) != nullptr;
+        auto record = [&](const TradeInfo& trade)
+        {
+            ++expected[i].trades_;
+            expected[i].filled_ += trade.get_quantity();
+            single_trades.push_back(trade);
+        };
+        if (command.command_ == CommandType::Add)
+        {
+            single.add_order(make_intrusive_pooled_order(&order_pool, command.order_type_, command.side_, command.order_id_, command.price_, command.quantity_), record);
+            expected[i].accepted_ = command.order_type_ == OrderType::GoodTillCancel || expected[i].trades_ != 0 || single.Size() != size_before;
+        }
+        else if (command.command_ == CommandType::Cancel)
+        {
+            single.cancel_order(command.order_id_);
+            expected[i].accepted_ = resting;
+        }
+        else if (command.command_ == CommandType::Modify)
+        {
+            single.modify_order(OrderModify(&order_pool, command.order_type_, command.side_, command.order_id_, command.price_, command.quantity_), record);
+            expected[i].accepted_ = resting;
+        }
+        else
+        {
+            single.mass_cancel(command.side_);
+            expected[i].accepted_ = true;
+        }
+    }
+
+    // The same commands in bursts of 64: one published snapshot per burst
+    OrderBookConfig config;
+    config.snapshot_depth_ = 5;
+    OrderBook batched{ config };
+    std::vector<TradeInfo> batched_trades;
+    std::vector<CommandResult> results(commands.size());
+    std::size_t bursts = 0;
+    for (std::size_t begin = 0; begin < commands.size(); begin += 64, ++bursts)
+    {
+        const auto count = std::min<std::size_t>(64, commands.size() - begin);
+        batched.apply_batch(std::span(commands).subspan(begin, count), order_pool,
+                            std::span(results).subspan(begin, count),
+                            [&](const TradeInfo& trade) { batched_trades.push_back(trade); });
+    }
+    ASSERT_LE(batched.snapshot_sequence(), bursts);
+
+    ASSERT_EQ(book_checksum(batched), book_checksum(single));
+    ASSERT_EQ(batched_trades.size(), single_trades.size());
+    ASSERT_GT(batched_trades.size(), 0u);
+    for (std::size_t i = 0; i < batched_trades.size(); ++i)
+    {
+        ASSERT_EQ(batched_trades[i].get_buy().id_, single_trades[i].get_buy().id_);
+        ASSERT_EQ(batched_trades[i].get_sell().id_, single_trades[i].get_sell().id_);
+        ASSERT_EQ(batched_trades[i].get_quantity(), single_trades[i].get_quantity());
+    }
+    for (std::size_t i = 0; i < commands.size(); ++i)
     {
-        static MemoryPool<Order> order_pool; // local pool for test-created orders
-        return make_intrusive_pooled_order(
-            &order_pool,
-            action.orderType_,
-            action.side_,
-            action.orderId_,
-            action.price_,
-            action.quantity_);
+        ASSERT_EQ(results[i].accepted_, expected[i].accepted_) << i;
+        ASSERT_EQ(results[i].trades_, expected[i].trades_) << i;
+        ASSERT_EQ(results[i].filled_, expected[i].filled_) << i;
+    }
+}
+
+TEST(OrderbookBatchTests, RejectsTooFewResults)
+{
+    static MemoryPool<Order> order_pool;
+    OrderBook book;
+    OrderCommand commands[2];
+    commands[0].order_id_ = 1;
+    commands[0].price_ = 100;
+    commands[0].quantity_ = 10;
+    commands[1] = commands[0];
+    commands[1].order_id_ = 2;
+    CommandResult results[2];
+    auto no_trades = [](const TradeInfo&) {};
+
+    ASSERT_THROW(book.apply_batch(commands, order_pool, std::span(results, 1), no_trades), std::invalid_argument);
+    ASSERT_EQ(book.Size(), 0u);
+    book.apply_batch(commands, order_pool, results, no_trades);
+    ASSERT_EQ(book.Size(), 2u);
+    ASSERT_TRUE(results[0].accepted_ && results[1].accepted_);
+}
+
+TEST(BinaryProtocolTests, DecodesBatchesAndKeepsPartialMessages)
+{
+    OrderCommand add;
+    add.order_type_ = OrderType::FillAndKill;
+    add.side_ = OrderSide::Sell;
+    add.symbol_ = 3;
+    add.order_id_ = 42;
+    add.price_ = 10'050;
+    add.quantity_ = 7;
+    OrderCommand cancel;
+    cancel.command_ = CommandType::Cancel;
+    cancel.symbol_ = 3;
+    cancel.order_id_ = 42;
+    OrderCommand modify = add;
+    modify.command_ = CommandType::Modify;
+    modify.price_ = 10'040;
+
+    std::vector<std::byte> stream(4 * wire::MaxMessageSize);
+    std::size_t bytes = 0;
+    for (const auto& command : { add, cancel, modify })
+        bytes += wire::encode(command, stream.data() + bytes);
+    wire::MassCancelMessage mass;
+    mass.symbol_ = 3;
+    std::memcpy(stream.data() + bytes, &mass, sizeof(mass));
+    bytes += sizeof(mass);
+    ASSERT_EQ(bytes, 24u + 12u + 24u + 8u);
+
+    // Cut inside the modify: add and cancel decode, the modify waits
+    std::vector<OrderCommand> out(8);
+    auto result = wire::decode_batch(std::span<const std::byte>(stream.data(), 40), out);
+    ASSERT_FALSE(result.malformed_);
+    ASSERT_EQ(result.commands_, 2u);
+    ASSERT_EQ(result.bytes_, 36u);
+    ASSERT_EQ(out[0].command_, CommandType::Add);
+    ASSERT_EQ(out[0].order_type_, OrderType::FillAndKill);
+    ASSERT_EQ(out[0].side_, OrderSide::Sell);
+    ASSERT_EQ(out[0].symbol_, 3u);
+    ASSERT_EQ(out[0].order_id_, 42);
+    ASSERT_EQ(out[0].price_, 10'050);
+    ASSERT_EQ(out[0].quantity_, 7);
+    ASSERT_EQ(out[1].command_, CommandType::Cancel);
+    ASSERT_EQ(out[1].order_id_, 42);
+
+    // The rest: the modify, then a both-sides mass cancel as two commands
+    result = wire::decode_batch(std::span<const std::byte>(stream.data() + 36, bytes - 36), out);
+    ASSERT_EQ(result.commands_, 3u);
+    ASSERT_EQ(result.bytes_, bytes - 36);
+    ASSERT_EQ(out[0].command_, CommandType::Modify);
+    ASSERT_EQ(out[0].price_, 10'040);
+    ASSERT_EQ(out[1].command_, CommandType::MassCancel);
+    ASSERT_EQ(out[1].side_, OrderSide::Buy);
+    ASSERT_EQ(out[2].command_, CommandType::MassCancel);
+    ASSERT_EQ(out[2].side_, OrderSide::Sell);
+
+    // Output full: stops before the message, nothing is lost
+    result = wire::decode_batch(std::span<const std::byte>(stream.data(), bytes), std::span<OrderCommand>(out.data(), 1));
+    ASSERT_EQ(result.commands_, 1u);
+    ASSERT_EQ(result.bytes_, 24u);
+
+    stream[0] = std::byte{ 'Z' };
+    result = wire::decode_batch(std::span<const std::byte>(stream.data(), bytes), out);
+    ASSERT_TRUE(result.malformed_);
+    ASSERT_EQ(result.commands_, 0u);
+}
+
+TEST(BinaryProtocolTests, RejectsFieldsOutsideTheEngineRange)
+{
+    auto add_frame = [](std::uint32_t order_id, std::uint32_t quantity, std::int64_t price) {
+        wire::AddMessage add;
+        add.order_type_ = static_cast<std::uint8_t>(OrderType::GoodTillCancel);
+        add.order_id_ = order_id;
+        add.quantity_ = quantity;
+        add.price_ = price;
+        std::vector<std::byte> frame(sizeof(add));
+        std::memcpy(frame.data(), &add, sizeof(add));
+        return frame;
+    };
+    wire::CancelMessage cancel;
+    cancel.order_id_ = 0x80000000u;
+    std::vector<std::byte> cancel_frame(sizeof(cancel));
+    std::memcpy(cancel_frame.data(), &cancel, sizeof(cancel));
+    const std::vector<std::vector<std::byte>> frames = {
+        add_frame(1, 0x80000000u, 100),
+        add_frame(1, 0, 100),
+        add_frame(0x80000000u, 10, 100),
+        add_frame(1, 10, -1),
+        add_frame(1, 10, Constants::MarketBuyPrice),
+        cancel_frame,
     };
-    
+
+    static MemoryPool<Order> order_pool;
+    OrderBook orderbook;
+    std::vector<OrderCommand> out(2);
+    std::size_t malformed = 0;
+    for (const auto& frame : frames)
+    {
+        const auto result = wire::decode_batch(frame, out);
+        malformed += result.malformed_;
+        ASSERT_EQ(result.commands_, 0u);
+        ASSERT_EQ(result.bytes_, 0u);
+        const auto stats = replay_command_log(orderbook, order_pool, frame, ReplayOptions{ .format_ = LogFormat::Binary });
+        ASSERT_TRUE(stats.malformed_);
+        ASSERT_EQ(stats.messages_, 0u);
+    }
+    ASSERT_EQ(malformed, frames.size());
+    ASSERT_EQ(orderbook.Size(), 0u);
+    ASSERT_TRUE(orderbook.get_order_book().get_bids().empty());
+
+    // The edges of the range still decode
+    const auto result = wire::decode_batch(add_frame(0x7fffffffu, 0x7fffffffu, 0), out);
+    ASSERT_FALSE(result.malformed_);
+    ASSERT_EQ(result.commands_, 1u);
+    ASSERT_EQ(out[0].order_id_, std::numeric_limits<OrderId>::max());
+    ASSERT_EQ(out[0].quantity_, std::numeric_limits<Quantity>::max());
+}
+
+TEST(OrderbookMassCancelTests, CancelsOneSide)
+{
+    static MemoryPool<Order> order_pool;
     OrderBook orderbook;
-    auto GetOrderModify = [&orderbook](const Information& action)
-    {
-        static MemoryPool<Order> order_pool; // pool for modified orders
-        return OrderModify(
-            &order_pool,
-            orderbook.get_order_by_id(action.orderId_)->get_order_type(),
-            action.side_,
-            action.orderId_,
-            action.price_,
-            action.quantity_);
+    OrderId id = 0;
+    for (Price price = 90; price < 100; ++price)
+    {
+        orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Buy, ++id, price, 10));
+        orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, ++id, price + 20, 10));
+    }
+    orderbook.mass_cancel(OrderSide::Buy);
+    ASSERT_EQ(orderbook.Size(), 10u);
+    const auto levels = orderbook.get_order_book();
+    ASSERT_TRUE(levels.get_bids().empty());
+    ASSERT_EQ(levels.get_asks().size(), 10u);
+}
+
+TEST(OrderbookMassCancelTests, CancelsPriceRangesAndParticipants)
+{
+    static MemoryPool<Order> order_pool;
+    OrderBookConfig config;
+    config.level_delta_capacity_ = 256;
+    OrderBook orderbook{ config };
+    std::vector<LevelDelta> deltas;
+    auto drain = [&]()
+    {
+        deltas.clear();
+        orderbook.drain_level_deltas([&deltas](const LevelDelta& delta) { deltas.push_back(delta); });
+    };
+    // Bids 90-99: two orders of participant 1 around one of participant 2.
+    // Asks 120-124: participant 1 alone.
+    OrderId id = 0;
+    for (Price price = 90; price < 100; ++price)
+        for (ParticipantId participant : { 1u, 2u, 1u })
+            orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Buy, ++id, price, 10), [](const TradeInfo&) {}, 0, participant);
+    for (Price price = 120; price < 125; ++price)
+        for (int i = 0; i < 3; ++i)
+            orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, ++id, price, 10), [](const TradeInfo&) {}, 0, 1);
+    ASSERT_EQ(orderbook.participant_order_count(1), 35u);
+    ASSERT_EQ(orderbook.participant_order_count(2), 10u);
+
+    // A fill takes the order out of its participant's orders; a modify keeps it there
+    orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, ++id, 99, 25), [](const TradeInfo&) {});
+    ASSERT_EQ(orderbook.participant_order_count(1), 34u);
+    ASSERT_EQ(orderbook.participant_order_count(2), 9u);
+    orderbook.modify_order(OrderModify(&order_pool, OrderType::GoodTillCancel, OrderSide::Buy, 5, 80, 10), [](const TradeInfo&) {});
+    ASSERT_EQ(orderbook.participant_order_count(2), 9u);
+    drain();
+
+    // Bids 92 to 95: four whole levels, one Delete each
+    ASSERT_EQ(orderbook.mass_cancel(OrderSide::Buy, 92, 95), 12u);
+    drain();
+    ASSERT_EQ(deltas.size(), 4u);
+    for (const auto& delta : deltas)
+        ASSERT_EQ(delta.action_, LevelAction::Delete);
+    ASSERT_EQ(orderbook.participant_order_count(1), 26u);
+    ASSERT_EQ(orderbook.participant_order_count(2), 5u);
+    ASSERT_EQ(orderbook.mass_cancel(OrderSide::Sell, 130, 120), 0u);
+
+    // Participant 1: its ask levels go whole, its bid levels keep the other
+    // participant's order; one delta per level touched
+    ASSERT_EQ(orderbook.mass_cancel(ParticipantId{ 1 }), 26u);
+    ASSERT_EQ(orderbook.participant_order_count(1), 0u);
+    drain();
+    ASSERT_EQ(deltas.size(), 11u); // bids 90, 91 and 96-99, asks 120-124
+    auto levels = orderbook.get_order_book();
+    ASSERT_TRUE(levels.get_asks().empty());
+    for (const auto& [price, level] : levels.get_bids())
+    {
+        ASSERT_EQ(level.count_, 1);
+        ASSERT_EQ(level.quantity_, 10);
+    }
+    ASSERT_EQ(orderbook.Size(), 5u); // participant 2's, including the one at 80
+
+    // Participants survive a state snapshot
+    const auto image = orderbook.save_state();
+    OrderBook restored;
+    restored.restore_state(image, order_pool);
+    ASSERT_EQ(restored.participant_order_count(2), 5u);
+    ASSERT_EQ(restored.mass_cancel(ParticipantId{ 2 }), 5u);
+    ASSERT_EQ(restored.Size(), 0u);
+    ASSERT_TRUE(restored.get_order_book().get_bids().empty());
+}
+
+TEST(OrderbookGoodForDayTests, ExpiresOnlyGoodForDayOrdersInChunks)
+{
+    static MemoryPool<Order> order_pool;
+    OrderBookConfig config;
+    config.single_writer_ = true;
+    config.level_delta_capacity_ = 64;
+    OrderBook orderbook{ config };
+    auto add = [&](OrderType type, OrderSide side, OrderId id, Price price) {
+        orderbook.add_order(make_intrusive_pooled_order(&order_pool, type, side, id, price, 10), [](const TradeInfo&) {});
+    };
+    const auto GFD = OrderType::GoodForDay;
+    const auto GTC = OrderType::GoodTillCancel;
+    add(GFD, OrderSide::Buy, 1, 100);
+    add(GFD, OrderSide::Buy, 2, 100);
+    add(GFD, OrderSide::Buy, 3, 100);
+    add(GTC, OrderSide::Buy, 4, 99);
+    add(GFD, OrderSide::Buy, 5, 99);
+    add(GTC, OrderSide::Buy, 6, 99);
+    add(GTC, OrderSide::Buy, 7, 98);
+    add(GFD, OrderSide::Sell, 8, 110);
+    add(GFD, OrderSide::Sell, 9, 110);
+    // A filled GoodForDay order leaves the expiry list
+    add(GFD, OrderSide::Buy, 12, 105);
+    add(GTC, OrderSide::Sell, 13, 105);
+    ASSERT_EQ(orderbook.good_for_day_count(), 6u);
+    std::vector<LevelDelta> deltas;
+    auto drain = [&]() {
+        deltas.clear();
+        orderbook.drain_level_deltas([&deltas](const LevelDelta& delta) { deltas.push_back(delta); });
+    };
+    drain();
+
+    orderbook.begin_good_for_day_expiry();
+    // Level 100 holds only expiring orders: all three go at once, as one delta
+    ASSERT_TRUE(orderbook.expire_good_for_day(2));
+    drain();
+    ASSERT_EQ(deltas.size(), 1u);
+    ASSERT_EQ(deltas[0].price_, 100);
+    ASSERT_EQ(deltas[0].action_, LevelAction::Delete);
+    ASSERT_EQ(orderbook.Size(), 6u);
+
+    // Added after the cutoff: kept for the next session
+    add(GFD, OrderSide::Buy, 10, 97);
+    ASSERT_TRUE(orderbook.expire_good_for_day(2)); // 5 and 8
+    ASSERT_FALSE(orderbook.expire_good_for_day(10)); // 9
+    ASSERT_EQ(orderbook.Size(), 4u);
+    ASSERT_EQ(orderbook.good_for_day_count(), 1u);
+    ASSERT_NE(orderbook.get_order_by_id(10), nullptr);
+    const auto levels = orderbook.get_order_book();
+    ASSERT_EQ(levels.get_bids().size(), 3u);
+    const auto& best_bid = levels.get_bids().begin()->second;
+    ASSERT_EQ(best_bid.price_, 99);
+    ASSERT_EQ(best_bid.quantity_, 20);
+    ASSERT_EQ(best_bid.count_, 2);
+    ASSERT_TRUE(levels.get_asks().empty());
+
+    orderbook.prune_good_for_day_orders();
+    ASSERT_EQ(orderbook.Size(), 3u);
+    ASSERT_EQ(orderbook.good_for_day_count(), 0u);
+}
+
+TEST(OrderbookGoodForDayTests, PruneThreadFollowsTheSessionClock)
+{
+    static MemoryPool<Order> order_pool;
+    using namespace std::chrono;
+    // A session clock 50ms short of the cutoff
+    const auto offset = next_good_for_day_cutoff(system_clock::now()) - milliseconds(50) - system_clock::now();
+    OrderBookConfig config;
+    config.session_clock_ = [offset]() { return system_clock::now() + offset; };
+    OrderBook orderbook{ config };
+    orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodForDay, OrderSide::Buy, 1, 100, 10));
+    orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Buy, 2, 99, 10));
+
+    const auto deadline = steady_clock::now() + seconds(5);
+    while (orderbook.Size() != 1 && steady_clock::now() < deadline)
+        std::this_thread::sleep_for(milliseconds(10));
+    ASSERT_EQ(orderbook.Size(), 1u);
+    ASSERT_NE(orderbook.get_order_by_id(2), nullptr);
+}
+
+TEST(TimerWheelTests, FiresEveryEntryOnceAtOrAfterItsDeadline)
+{
+    // Deadlines from the current tick out past the top level's rotation,
+    // reached in uneven steps
+    std::mt19937_64 rng(7);
+    const std::uint64_t start = 5'000'000'000ull;
+    TimerWheel wheel(start);
+    std::vector<std::uint64_t> deadlines;
+    for (OrderId id = 0; id < 20'000; ++id) {
+        const auto span = std::uint64_t{1} << (rng() % 40);
+        deadlines.push_back(start + rng() % span);
+        wheel.schedule(deadlines.back(), id);
+    }
+    std::uint64_t now = start;
+    std::size_t fired = 0;
+    std::vector<bool> done(deadlines.size(), false);
+    while (fired < deadlines.size()) {
+        const auto before = now;
+        now += 1 + rng() % (std::uint64_t{1} << (rng() % 34));
+        // Due in (before, now]: not early, and not missed by an earlier advance
+        wheel.advance(now, [&](OrderId id) {
+            ASSERT_FALSE(done[id]);
+            ASSERT_LE(deadlines[id], now);
+            ASSERT_TRUE(deadlines[id] > before || deadlines[id] == start);
+            done[id] = true;
+            ++fired;
+        });
+        ASSERT_EQ(wheel.size(), deadlines.size() - fired);
+        ASSERT_EQ(wheel.now(), now);
+    }
+}
+
+TEST(OrderbookGoodTillDateTests, ExpiresOnAdvanceTime)
+{
+    static MemoryPool<Order> order_pool;
+    OrderBookConfig config;
+    config.single_writer_ = true;
+    config.timer_resolution_ = std::chrono::nanoseconds(10);
+    OrderBook orderbook{ config };
+    auto add = [&](OrderType type, OrderId id, Price price, Timestamp expiry) {
+        orderbook.add_order(make_intrusive_pooled_order(&order_pool, type, OrderSide::Buy, id, price, 10),
+                            [](const TradeInfo&) {}, expiry);
     };
+    const auto GTD = OrderType::GoodTillDate;
+    ASSERT_EQ(orderbook.advance_time(1'000), 0u);
+    add(GTD, 1, 100, 1'500);
+    add(GTD, 2, 100, 1'200);
+    add(GTD, 3, 99, 1'205); // due on the 1'210 grid line
+    add(GTD, 4, 98, 2'000);
+    add(OrderType::GoodTillCancel, 5, 97, 1'100); // not GoodTillDate: the expiry is ignored
+    add(GTD, 6, 96, 1'000); // already expired
+    add(GTD, 7, 96, 0);     // no expiry
+    ASSERT_EQ(orderbook.Size(), 5u);
+    ASSERT_EQ(orderbook.good_till_date_count(), 4u);
 
-    // Act
-    for (const auto& action : actions)
+    orderbook.cancel_order(4);
+    // Keeps its expiry through a modify, and a re-added id its new one
+    orderbook.modify_order(OrderModify(&order_pool, GTD, OrderSide::Buy, 1, 101, 5), [](const TradeInfo&) {});
+    orderbook.cancel_order(2);
+    add(GTD, 2, 100, 1'800);
+
+    ASSERT_EQ(orderbook.advance_time(1'199), 0u);
+    ASSERT_EQ(orderbook.advance_time(1'209), 0u);
+    ASSERT_EQ(orderbook.advance_time(1'210), 1u); // 3
+    ASSERT_EQ(orderbook.get_order_by_id(3), nullptr);
+    ASSERT_EQ(orderbook.advance_time(1'000), 0u); // never back
+    ASSERT_EQ(orderbook.current_time(), 1'210u);
+
+    // The clock and the expiries survive a state snapshot
+    const auto image = orderbook.save_state();
+    OrderBook restored{ config };
+    restored.restore_state(image, order_pool);
+    for (auto* book : { &orderbook, &restored }) {
+        ASSERT_EQ(book->current_time(), 1'210u);
+        ASSERT_EQ(book->advance_time(1'500), 1u); // 1
+        ASSERT_EQ(book->advance_time(1'900), 1u); // 2
+        ASSERT_EQ(book->advance_time(100'000), 0u);
+        ASSERT_EQ(book->Size(), 1u);
+        ASSERT_NE(book->get_order_by_id(5), nullptr);
+        ASSERT_EQ(book->good_till_date_count(), 0u);
+    }
+}
+
+TEST(CommandLogTests, TextAndBinaryLogsReplayToTheSameBook)
+{
+    // Resting flow around 100.00 with crossing orders, cancels, modifies and
+    // GoodTillDate orders on a recorded clock, written once as A/C/M/T text
+    // and once as BinaryProtocol messages
+    std::mt19937 rng(7);
+    std::vector<OrderCommand> commands;
+    std::vector<OrderType> types;
+    OrderId id = 0;
+    Timestamp clock = 1'000'000;
+    for (int i = 0; i < 2'000; ++i)
     {
-        switch (action.type_)
+        OrderCommand command;
+        if (i % 50 == 49)
         {
-        case ActionType::Add:
+            command.command_ = CommandType::AdvanceTime;
+            command.timestamp_ = clock += 50'000'000;
+            commands.push_back(command);
+            continue;
+        }
+        const int kind = std::uniform_int_distribution<int>(0, 9)(rng);
+        command.side_ = kind % 2 ? OrderSide::Buy : OrderSide::Sell;
+        command.order_id_ = kind < 2 && id > 0 ? std::uniform_int_distribution<OrderId>(1, id)(rng) : ++id;
+        command.command_ = kind < 2 && id > 0 ? (kind == 0 ? CommandType::Cancel : CommandType::Modify) : CommandType::Add;
+        command.price_ = 10'000 + std::uniform_int_distribution<Price>(-20, 20)(rng);
+        command.quantity_ = std::uniform_int_distribution<Quantity>(1, 50)(rng);
+        if (command.command_ == CommandType::Add)
         {
-            const auto& trades = orderbook.add_order(GetOrder(action));
+            command.order_type_ = kind == 9 ? OrderType::GoodTillDate : OrderType::GoodTillCancel;
+            if (kind == 9)
+                command.timestamp_ = clock + std::uniform_int_distribution<Timestamp>(1, 500'000'000)(rng);
+            types.resize(command.order_id_ + 1);
+            types[command.order_id_] = command.order_type_;
         }
-        break;
-        case ActionType::Modify:
+        else if (static_cast<std::size_t>(command.order_id_) < types.size())
         {
-            const auto& trades = orderbook.modify_order(GetOrderModify(action));
+            command.order_type_ = types[command.order_id_]; // the text form keeps the order's type
         }
-        break;
-        case ActionType::Cancel:
+        commands.push_back(command);
+    }
+
+    const auto text_path = std::filesystem::temp_directory_path() / "orderbook_replay_test.txt";
+    const auto binary_path = std::filesystem::temp_directory_path() / "orderbook_replay_test.bin";
+    {
+        std::ofstream text{ text_path };
+        std::ofstream binary{ binary_path, std::ios::binary };
+        std::byte message[wire::MaxMessageSize];
+        for (const auto& command : commands)
         {
-            orderbook.cancel_order(action.orderId_);
+            const char* side = command.side_ == OrderSide::Buy ? "B" : "S";
+            const auto price = std::to_string(command.price_ / 100) + "." + std::to_string(command.price_ % 100 / 10) + std::to_string(command.price_ % 10);
+            if (command.command_ == CommandType::Add && command.order_type_ == OrderType::GoodTillDate)
+                text << "A " << side << " GTD " << price << " " << command.quantity_ << " " << command.order_id_ << " " << command.timestamp_ << "\n";
+            else if (command.command_ == CommandType::Add)
+                text << "A " << side << " GoodTillCancel " << price << " " << command.quantity_ << " " << command.order_id_ << "\n";
+            else if (command.command_ == CommandType::AdvanceTime)
+                text << "T " << command.timestamp_ << "\n";
+            else if (command.command_ == CommandType::Cancel)
+                text << "C " << command.order_id_ << "\n";
+            else
+                text << "M " << command.order_id_ << " " << side << " " << price << " " << command.quantity_ << "\n";
+            binary.write(reinterpret_cast<const char*>(message), static_cast<std::streamsize>(wire::encode(command, message)));
         }
-        break;
-        default:
-            throw std::logic_error("Unsupported Action.");
+        text << "R 0 0 0\n";
+    }
+
+    auto replay = [](const std::filesystem::path& path, LogFormat format)
+    {
+        static MemoryPool<Order> order_pool;
+        OrderBook orderbook;
+        MappedFile log{ path };
+        return replay_command_log(orderbook, order_pool, log.bytes(), ReplayOptions{ .format_ = format });
+    };
+    const auto text = replay(text_path, LogFormat::Text);
+    const auto binary = replay(binary_path, LogFormat::Binary);
+    std::filesystem::remove(text_path);
+    std::filesystem::remove(binary_path);
+
+    ASSERT_EQ(text.messages_, commands.size());
+    ASSERT_EQ(text.skipped_, 1u); // the R line
+    ASSERT_EQ(binary.messages_, commands.size());
+    ASSERT_FALSE(binary.malformed_);
+    ASSERT_GT(text.trades_, 0u);
+    ASSERT_EQ(text.trades_, binary.trades_);
+    ASSERT_EQ(text.checksum_, binary.checksum_);
+    std::uint64_t timed = 0;
+    for (const auto& latency : text.latency_)
+        timed += latency.count();
+    ASSERT_EQ(timed, commands.size());
+
+    // The same commands applied directly give the same book
+    static MemoryPool<Order> order_pool;
+    OrderBook orderbook;
+    std::size_t expired = 0;
+    for (const auto& command : commands)
+    {
+        if (command.command_ == CommandType::Add)
+            orderbook.add_order(make_intrusive_pooled_order(&order_pool, command.order_type_, command.side_, command.order_id_, command.price_, command.quantity_), [](const TradeInfo&) {}, command.timestamp_);
+        else if (command.command_ == CommandType::AdvanceTime)
+            expired += orderbook.advance_time(command.timestamp_);
+        else if (command.command_ == CommandType::Cancel)
+            orderbook.cancel_order(command.order_id_);
+        else
+            orderbook.modify_order(OrderModify(&order_pool, command.order_type_, command.side_, command.order_id_, command.price_, command.quantity_));
+    }
+    ASSERT_EQ(book_checksum(orderbook), text.checksum_);
+    ASSERT_GT(expired, 0u);
+}
+
+TEST(JournalTests, RecoversTheBookFromTheJournal)
+{
+    const auto path = std::filesystem::temp_directory_path() / "orderbook_journal_test.bin";
+    static MemoryPool<Order> order_pool;
+    std::uint64_t journaled_trades = 0;
+    std::uint64_t trades = 0;
+    std::uint64_t live_checksum = 0;
+    {
+        Journal journal{ JournalConfig{ .path_ = path, .ring_capacity_ = 64, .batch_records_ = 16, .preallocate_bytes_ = 1 << 20 } };
+        OrderBookConfig config;
+        config.journal_ = &journal;
+        config.symbol_ = 5;
+        OrderBook orderbook{ config };
+
+        std::mt19937 rng(11);
+        OrderId id = 0;
+        auto count_trade = [&trades](const TradeInfo&) { ++trades; };
+        for (int i = 0; i < 5'000; ++i)
+        {
+            const int kind = std::uniform_int_distribution<int>(0, 9)(rng);
+            const auto side = kind % 2 ? OrderSide::Buy : OrderSide::Sell;
+            const Price price = 10'000 + std::uniform_int_distribution<Price>(-20, 20)(rng);
+            const Quantity quantity = std::uniform_int_distribution<Quantity>(1, 50)(rng);
+            if (kind == 0 && id > 0)
+                orderbook.cancel_order(std::uniform_int_distribution<OrderId>(1, id)(rng));
+            else if (kind == 1 && id > 0)
+                orderbook.modify_order(OrderModify(&order_pool, OrderType::GoodTillCancel, side, std::uniform_int_distribution<OrderId>(1, id)(rng), price, quantity), count_trade);
+            else if (i == 4'000)
+                orderbook.mass_cancel(side);
+            else
+                orderbook.add_order(make_intrusive_pooled_order(&order_pool, kind == 2 ? OrderType::FillAndKill : OrderType::GoodTillCancel, side, ++id, price, quantity), count_trade);
         }
+        journal.flush();
+        ASSERT_EQ(journal.error(), 0);
+        ASSERT_EQ(journal.durable_sequence(), journal.appended_sequence());
+        live_checksum = book_checksum(orderbook);
     }
 
-    // Assert
-    const auto& orderbookInfos = orderbook.get_order_book();
-    ASSERT_EQ(orderbook.Size(), result.allCount_);
-    ASSERT_EQ(orderbookInfos.get_bids().size(), result.bidCount_);
-    ASSERT_EQ(orderbookInfos.get_asks().size(), result.askCount_);
+    MappedFile log{ path };
+    ASSERT_EQ(log.bytes().size(), std::size_t{ 1 } << 20); // preallocated
+    read_journal(log.bytes(), [&](const JournalRecord& record)
+    {
+        ASSERT_EQ(record.symbol_, 5u);
+        journaled_trades += record.kind_ == JournalRecordKind::Trade;
+    });
+    ASSERT_GT(trades, 0u);
+    ASSERT_EQ(journaled_trades, trades);
+
+    OrderBook recovered;
+    ASSERT_EQ(recover_from_journal(recovered, order_pool, log.bytes(), 1), 0u); // other symbol
+    ASSERT_GT(recover_from_journal(recovered, order_pool, log.bytes(), 5), 0u);
+    ASSERT_EQ(book_checksum(recovered), live_checksum);
+
+    // A torn last record (sequence intact, payload not) ends the log before it
+    const auto records = read_journal(log.bytes(), [](const JournalRecord&) {});
+    std::vector<std::byte> torn(log.bytes().begin(), log.bytes().begin() + records * sizeof(JournalRecord));
+    torn[(records - 1) * sizeof(JournalRecord) + offsetof(JournalRecord, quantity_)] ^= std::byte{ 0x5a };
+    ASSERT_EQ(read_journal(torn, [](const JournalRecord&) {}), records - 1);
+    std::filesystem::remove(path);
 }
 
-INSTANTIATE_TEST_CASE_P(Tests, OrderbookTestsFixture, googletest::ValuesIn({
-    "Match_GoodTillCancel.txt",
-    "Match_FillAndKill.txt",
-    "Match_FillOrKill_Hit.txt",
-    "Match_FillOrKill_Miss.txt",
-    "Cancel_Success.txt",
-    "Modify_Side.txt",
-    "Match_Market.txt"
-}));
+TEST(JournalTests, RecoveredOrdersKeepTheirParticipant)
+{
+    const auto path = std::filesystem::temp_directory_path() / "orderbook_journal_participants.bin";
+    static MemoryPool<Order> order_pool;
+    std::size_t live_count = 0;
+    std::size_t other_count = 0;
+    {
+        Journal journal{ JournalConfig{ .path_ = path } };
+        OrderBookConfig config;
+        config.journal_ = &journal;
+        OrderBook orderbook{ config };
+        for (OrderId id = 1; id <= 40; ++id)
+        {
+            const auto side = id % 2 ? OrderSide::Buy : OrderSide::Sell;
+            const Price price = side == OrderSide::Buy ? 100 - id % 5 : 99 + id % 7;
+            orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, side, id, price, 10),
+                                [](const TradeInfo&) {}, 0, static_cast<ParticipantId>(1 + id % 2));
+        }
+        orderbook.modify_order(OrderModify(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, 40, 110, 5));
+        journal.flush();
+        live_count = orderbook.participant_order_count(1);
+        other_count = orderbook.participant_order_count(2);
+    }
+    ASSERT_GT(live_count, 0u);
+
+    MappedFile log{ path };
+    OrderBook recovered;
+    recover_from_journal(recovered, order_pool, log.bytes());
+    ASSERT_EQ(recovered.participant_order_count(1), live_count);
+    ASSERT_EQ(recovered.participant_order_count(2), other_count);
+    ASSERT_EQ(recovered.mass_cancel(ParticipantId{ 2 }), other_count);
+    ASSERT_EQ(recovered.Size(), live_count);
+    ASSERT_EQ(recovered.participant_order_count(2), 0u);
+    std::filesystem::remove(path);
+}
+
+TEST(JournalTests, StallsWhileTheWriterIsBlocked)
+{
+    // The journal writes into a pipe nobody reads until the producer has
+    // stalled: the writer blocks once the pipe is full, then the ring fills
+    const auto path = std::filesystem::temp_directory_path() / "orderbook_journal_stall.fifo";
+    std::filesystem::remove(path);
+    ASSERT_EQ(::mkfifo(path.c_str(), 0600), 0);
+    const int reader = ::open(path.c_str(), O_RDONLY | O_NONBLOCK);
+    ASSERT_GE(reader, 0);
+    {
+        Journal journal{ JournalConfig{ .path_ = path, .durability_ = Durability::Buffered, .ring_capacity_ = 64, .batch_records_ = 16 } };
+        // Several times what the pipe buffer and the ring hold together
+        const std::size_t count = 4 * ::fcntl(reader, F_GETPIPE_SZ) / sizeof(JournalRecord) + 256;
+        std::vector<std::byte> bytes(count * sizeof(JournalRecord));
+        std::thread drain([&]() {
+            while (journal.stalls() == 0)
+                std::this_thread::yield();
+            std::size_t read_bytes = 0;
+            while (read_bytes < bytes.size())
+            {
+                const auto got = ::read(reader, bytes.data() + read_bytes, bytes.size() - read_bytes);
+                if (got > 0)
+                    read_bytes += static_cast<std::size_t>(got);
+                else
+                    std::this_thread::yield();
+            }
+        });
+        for (std::size_t i = 1; i <= count; ++i)
+            journal.append_command(1, CommandType::Add, OrderType::GoodTillCancel, OrderSide::Buy, static_cast<OrderId>(i), 100, 10);
+        drain.join();
+
+        ASSERT_GT(journal.stalls(), 0u);
+        ASSERT_EQ(journal.error(), 0);
+        ASSERT_EQ(read_journal(bytes, [](const JournalRecord&) {}), count);
+    }
+    ::close(reader);
+    std::filesystem::remove(path);
+}
+
+TEST(OrderbookStateSnapshotTests, RestoreRoundTripsTheBook)
+{
+    static MemoryPool<Order> order_pool;
+    OrderBook original;
+    std::mt19937 rng(3);
+    std::vector<OrderId> ids;
+    for (OrderId id = 1; id <= 3'000; ++id)
+    {
+        const auto side = id % 2 ? OrderSide::Buy : OrderSide::Sell;
+        // Overlapping bands, so some orders trade and rest partially filled
+        const Price price = side == OrderSide::Buy ? 10'000 + std::uniform_int_distribution<Price>(-30, 3)(rng)
+                                                   : 10'000 + std::uniform_int_distribution<Price>(-3, 30)(rng);
+        const auto type = id % 7 == 0 ? OrderType::GoodForDay : OrderType::GoodTillCancel;
+        original.add_order(make_intrusive_pooled_order(&order_pool, type, side, id, price, std::uniform_int_distribution<Quantity>(1, 100)(rng)));
+        ids.push_back(id);
+    }
+    // Sparse levels far outside the restored book's ladder band, too
+    original.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, 5'000, 90'000, 5));
+    original.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Buy, 5'001, 10, 5));
+    ids.push_back(5'000);
+    ids.push_back(5'001);
+
+    const auto image = original.save_state(42);
+    ASSERT_EQ(image.size(), sizeof(state_snapshot::StateHeader) +
+        (original.get_order_book().get_bids().size() + original.get_order_book().get_asks().size()) * sizeof(state_snapshot::StateLevel) +
+        original.Size() * sizeof(state_snapshot::StateOrder));
+
+    OrderBookConfig config;
+    config.ladder_base_price_ = 9'900;
+    config.ladder_levels_ = 200;
+    config.order_index_mode_ = OrderIndexMode::Direct;
+    OrderBook restored{ config };
+    ASSERT_EQ(restored.restore_state(image, order_pool), 42u);
+    ASSERT_THROW(restored.restore_state(image, order_pool), std::invalid_argument); // not empty
+
+    const auto before = original.get_order_book();
+    const auto after = restored.get_order_book();
+    ASSERT_EQ(after.get_bids().size(), before.get_bids().size());
+    ASSERT_EQ(after.get_asks().size(), before.get_asks().size());
+    for (const auto& [price, level] : before.get_bids())
+    {
+        ASSERT_EQ(after.get_bids().at(price).quantity_, level.quantity_);
+        ASSERT_EQ(after.get_bids().at(price).count_, level.count_);
+    }
+    for (const auto& [price, level] : before.get_asks())
+    {
+        ASSERT_EQ(after.get_asks().at(price).quantity_, level.quantity_);
+        ASSERT_EQ(after.get_asks().at(price).count_, level.count_);
+    }
+    ASSERT_EQ(restored.Size(), original.Size());
+    for (auto id : ids)
+    {
+        auto was = original.get_order_by_id(id);
+        auto is = restored.get_order_by_id(id);
+        ASSERT_EQ(was == nullptr, is == nullptr);
+        if (!was)
+            continue;
+        ASSERT_EQ(is->get_order_type(), was->get_order_type());
+        ASSERT_EQ(is->get_order_side(), was->get_order_side());
+        ASSERT_EQ(is->get_price(), was->get_price());
+        ASSERT_EQ(is->get_quantity(), was->get_quantity());
+        ASSERT_EQ(is->get_initial_quantity(), was->get_initial_quantity());
+    }
+    // Same queues: the restored book saves to the same bytes and trades the same
+    ASSERT_EQ(restored.save_state(42), image);
+    auto sweep = [](OrderBook& orderbook)
+    {
+        return orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::FillAndKill, OrderSide::Buy, 9'999, 10'010, 2'000)).trades_made_;
+    };
+    const auto original_trades = sweep(original);
+    const auto restored_trades = sweep(restored);
+    ASSERT_GT(original_trades.size(), 1u);
+    ASSERT_EQ(restored_trades.size(), original_trades.size());
+    for (std::size_t i = 0; i < original_trades.size(); ++i)
+    {
+        ASSERT_EQ(restored_trades[i].get_sell().id_, original_trades[i].get_sell().id_);
+        ASSERT_EQ(restored_trades[i].get_quantity(), original_trades[i].get_quantity());
+    }
+
+    // A corrupt image is rejected before anything is loaded
+    auto corrupt = image;
+    corrupt.pop_back();
+    OrderBook untouched;
+    ASSERT_THROW(untouched.restore_state(corrupt, order_pool), std::invalid_argument);
+    ASSERT_EQ(untouched.Size(), 0u);
+    OrderBook other_tick{ OrderBookConfig{ .tick_size_ = TickSize::from_string("0.05") } };
+    ASSERT_THROW(other_tick.restore_state(image, order_pool), std::invalid_argument);
+}
+
+TEST(OrderbookStateSnapshotTests, InvalidImageLeavesTheBookUntouched)
+{
+    static MemoryPool<Order> order_pool;
+    OrderBook original;
+    original.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Buy, 1, 100, 10), [](const TradeInfo&) {}, 0, 7);
+    original.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillDate, OrderSide::Buy, 2, 100, 10), [](const TradeInfo&) {}, 1'000'000'000);
+    original.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, 3, 110, 10), [](const TradeInfo&) {}, 0, 8);
+    const auto image = original.save_state(1);
+
+    // Header, bid level, orders 1 and 2, ask level, order 3, one timer, two participants
+    using namespace state_snapshot;
+    constexpr std::size_t order_3 = sizeof(StateHeader) + 2 * sizeof(StateLevel) + 2 * sizeof(StateOrder);
+    constexpr std::size_t timer = order_3 + sizeof(StateOrder);
+    constexpr std::size_t participants = timer + sizeof(StateTimer);
+    ASSERT_EQ(image.size(), participants + 2 * sizeof(StateParticipant));
+    auto with_id = [&image](std::size_t offset, std::uint32_t id) {
+        auto bad = image;
+        std::memcpy(bad.data() + offset, &id, sizeof(id));
+        return bad;
+    };
+    std::uint32_t first_participant_order = 0;
+    std::memcpy(&first_participant_order, image.data() + participants, sizeof(first_participant_order));
+    const std::vector<std::vector<std::byte>> bad_images = {
+        with_id(order_3, 1),                                                    // repeated order id
+        with_id(timer, 1),                                                      // timer on a GoodTillCancel order
+        with_id(participants, 99),                                              // participant for an unknown order
+        with_id(participants + sizeof(StateParticipant), first_participant_order), // two participants for one order
+    };
+
+    OrderBook restored;
+    for (const auto& bad : bad_images)
+    {
+        ASSERT_THROW(restored.restore_state(bad, order_pool), std::invalid_argument);
+        ASSERT_EQ(restored.Size(), 0u);
+        ASSERT_TRUE(restored.get_order_book().get_bids().empty());
+        ASSERT_TRUE(restored.get_order_book().get_asks().empty());
+        ASSERT_EQ(restored.good_till_date_count(), 0u);
+        ASSERT_EQ(restored.participant_order_count(7), 0u);
+        ASSERT_EQ(restored.participant_order_count(8), 0u);
+    }
+    // Still empty, so the valid image loads into it just as into a fresh book
+    OrderBook fresh;
+    ASSERT_EQ(fresh.restore_state(image, order_pool), 1u);
+    ASSERT_EQ(restored.restore_state(image, order_pool), 1u);
+    ASSERT_EQ(restored.save_state(1), fresh.save_state(1));
+    ASSERT_EQ(restored.Size(), 3u);
+    ASSERT_EQ(restored.good_till_date_count(), 1u);
+    ASSERT_EQ(restored.participant_order_count(7), 1u);
+    ASSERT_EQ(restored.participant_order_count(8), 1u);
+}
+
+TEST(MatchingEngineTests, EventsFollowCommandOrder)
+{
+    MatchingEngineConfig config;
+    config.order_pool_slots_ = 1024;
+    MatchingEngine engine{ config };
+
+    auto command = [](CommandType type, OrderSide side, OrderId id, Price price, Quantity quantity) {
+        OrderCommand command;
+        command.command_ = type;
+        command.side_ = side;
+        command.order_id_ = id;
+        command.price_ = price;
+        command.quantity_ = quantity;
+        command.tag_ = static_cast<std::uint64_t>(id) * 10;
+        return command;
+    };
+    const OrderCommand commands[] = {
+        command(CommandType::Add, OrderSide::Sell, 1, 100, 5),
+        command(CommandType::Add, OrderSide::Sell, 2, 101, 5),
+        command(CommandType::Modify, OrderSide::Sell, 2, 100, 5),
+        command(CommandType::Add, OrderSide::Buy, 3, 100, 8), // trades with 1, then 2
+        command(CommandType::Cancel, OrderSide::Sell, 2, 0, 0),
+    };
+    for (const auto& c : commands)
+        ASSERT_TRUE(engine.try_submit(c));
+
+    std::vector<EngineEvent> events;
+    EngineEvent event;
+    while (events.size() < 7)
+        if (engine.try_poll(event))
+            events.push_back(event);
+
+    using Kind = EngineEvent::Kind;
+    ASSERT_EQ(events[0].kind_, Kind::Done);
+    ASSERT_EQ(events[0].tag_, 10u);
+    ASSERT_EQ(events[2].kind_, Kind::Done);
+    ASSERT_EQ(events[2].tag_, 20u);
+    ASSERT_EQ(events[3].kind_, Kind::Trade);
+    ASSERT_EQ(events[3].tag_, 30u);
+    ASSERT_EQ(events[3].sell_order_id_, 1);
+    ASSERT_EQ(events[3].quantity_, 5);
+    ASSERT_EQ(events[4].kind_, Kind::Trade);
+    ASSERT_EQ(events[4].sell_order_id_, 2);
+    ASSERT_EQ(events[4].quantity_, 3);
+    ASSERT_EQ(events[5].kind_, Kind::Done);
+    ASSERT_EQ(events[5].order_id_, 3);
+    ASSERT_EQ(events[6].kind_, Kind::Done);
+    ASSERT_EQ(events[6].tag_, 20u);
+    while (engine.processed() < 5) // counted after the burst that emitted the events
+        std::this_thread::yield();
+    ASSERT_EQ(engine.processed(), 5u);
+}
+
+TEST(MatchingEngineTests, ExpiresGoodTillDateOrdersWhileIdle)
+{
+    MatchingEngineConfig config;
+    config.order_pool_slots_ = 1024;
+    config.book_.snapshot_depth_ = 1;
+    MatchingEngine engine{ config };
+
+    using namespace std::chrono;
+    OrderCommand command;
+    command.order_type_ = OrderType::GoodTillDate;
+    command.order_id_ = 1;
+    command.price_ = 100;
+    command.quantity_ = 5;
+    command.timestamp_ = static_cast<Timestamp>(
+        duration_cast<nanoseconds>((system_clock::now() + milliseconds(20)).time_since_epoch()).count());
+    ASSERT_TRUE(engine.try_submit(command));
+    EngineEvent event;
+    while (!engine.try_poll(event))
+        std::this_thread::yield();
+    ASSERT_EQ(event.kind_, EngineEvent::Kind::Done);
+
+    // Nothing else is submitted: the idle loop moves the clock on once the
+    // wheel reaches the expiry tick
+    BookSnapshot snapshot{ 1 };
+    engine.read_snapshot(snapshot);
+    ASSERT_EQ(snapshot.bid_count_, 1u);
+    ASSERT_THROW(engine.read_snapshot(snapshot, 7), std::out_of_range); // not hosted
+    const auto deadline = steady_clock::now() + seconds(5);
+    do {
+        std::this_thread::sleep_for(milliseconds(1));
+        engine.read_snapshot(snapshot);
+    } while (snapshot.bid_count_ != 0 && steady_clock::now() < deadline);
+    ASSERT_EQ(snapshot.bid_count_, 0u);
+}
+
+TEST(OrderBookManagerTests, RoutesCommandsToPerSymbolBooks)
+{
+    OrderBookManagerConfig config;
+    config.symbols_ = { 7, 8, 9 };
+    config.shards_ = 2;
+    config.shard_.book_.expected_orders_ = 16;
+    config.shard_.order_pool_slots_ = 1024;
+    OrderBookManager manager{ config };
+
+    ASSERT_EQ(manager.shard_count(), 2u);
+    ASSERT_EQ(manager.shard_of(7), 0u);
+    ASSERT_EQ(manager.shard_of(8), 1u);
+    ASSERT_EQ(manager.shard_of(9), 0u);
+    ASSERT_THROW(manager.shard_of(10), std::out_of_range);
+
+    auto add = [](SymbolId symbol, OrderSide side, OrderId id, Price price) {
+        OrderCommand command;
+        command.symbol_ = symbol;
+        command.side_ = side;
+        command.order_id_ = id;
+        command.price_ = price;
+        command.quantity_ = 10;
+        return command;
+    };
+    // Same ids and crossing prices, but only the orders on symbol 9 meet
+    ASSERT_TRUE(manager.try_submit(add(7, OrderSide::Sell, 1, 100)));
+    ASSERT_TRUE(manager.try_submit(add(8, OrderSide::Buy, 2, 100)));
+    ASSERT_TRUE(manager.try_submit(add(9, OrderSide::Sell, 1, 100)));
+    ASSERT_TRUE(manager.try_submit(add(9, OrderSide::Buy, 2, 100)));
+
+    std::vector<EngineEvent> trades;
+    std::size_t done = 0;
+    EngineEvent event;
+    while (done < 4)
+    {
+        for (std::size_t shard = 0; shard < manager.shard_count(); ++shard)
+        {
+            while (manager.try_poll(shard, event))
+            {
+                if (event.kind_ == EngineEvent::Kind::Trade)
+                    trades.push_back(event);
+                else
+                    ++done;
+            }
+        }
+    }
+    ASSERT_EQ(trades.size(), 1u);
+    ASSERT_EQ(trades[0].symbol_, 9u);
+    ASSERT_EQ(trades[0].buy_order_id_, 2);
+    ASSERT_EQ(trades[0].sell_order_id_, 1);
+
+    // A journal takes one producer thread, so it cannot span shards
+    const auto path = std::filesystem::temp_directory_path() / "orderbook_manager_journal.bin";
+    {
+        Journal journal{ JournalConfig{ .path_ = path } };
+        config.shard_.book_.journal_ = &journal;
+        ASSERT_THROW(OrderBookManager{ config }, std::invalid_argument);
+        config.shards_ = 1;
+        ASSERT_NO_THROW(OrderBookManager{ config });
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(OrderbookAllocationTests, SteadyStateMatchingDoesNotAllocate)
+{
+    // The performance workload in miniature: populate both sides, then cross
+    // them with limit and market orders, fills going into one reused buffer.
+    // Pool, order table, ladder band and trade buffer are all sized up front.
+    MemoryPool<Order> order_pool(1 << 16);
+    OrderBookConfig config;
+    config.ladder_base_price_ = 9'000;
+    config.ladder_levels_ = 2'000;
+    config.order_index_mode_ = OrderIndexMode::Direct;
+    config.order_index_base_id_ = 1;
+    config.expected_orders_ = 1 << 16;
+    OrderBook orderbook{ config };
+
+    OrderId id = 0;
+    for (Price level = 0; level < 100; ++level)
+    {
+        for (int j = 0; j < 20; ++j)
+        {
+            orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Buy, ++id, 9'990 - level, 100));
+            orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, ++id, 10'010 + level, 100));
+        }
+    }
+
+    TradeInfos trades;
+    trades.trades_made_.reserve(256);
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<Price> price_dist(9'950, 10'050);
+    std::uniform_int_distribution<int> side_dist(0, 1);
+    std::uniform_int_distribution<Quantity> quantity_dist(50, 500);
+    std::size_t fills = 0;
+
+    const auto before = heap_allocations.load();
+    for (int i = 0; i < 20'000; ++i)
+    {
+        auto side = side_dist(rng) ? OrderSide::Buy : OrderSide::Sell;
+        auto type = i % 4 == 0 ? OrderType::Market : OrderType::GoodTillCancel;
+        trades.trades_made_.clear();
+        orderbook.add_order(make_intrusive_pooled_order(&order_pool, type, side, ++id, price_dist(rng), quantity_dist(rng)), trades);
+        fills += trades.trades_made_.size();
+    }
+    const auto allocations = heap_allocations.load() - before;
+
+    ASSERT_GT(fills, 0u);
+    ASSERT_EQ(allocations, 0u);
+
+    // The callback form reports the same fills without any buffer at all
+    std::size_t callback_fills = 0;
+    auto count_fill = [&callback_fills](const TradeInfo&) { ++callback_fills; };
+    const auto callback_before = heap_allocations.load();
+    orderbook.add_order(make_intrusive_pooled_order(&order_pool, OrderType::Market, OrderSide::Buy, ++id, Constants::InvalidPrice, 1'000), count_fill);
+    ASSERT_EQ(heap_allocations.load() - callback_before, 0u);
+    ASSERT_GT(callback_fills, 0u);
+}
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "include/OrderBook.hpp"
+#include "include/PooledShared.hpp"
+#include "include/TickSize.hpp"
+#include "perf_utils/LatencyStats.hpp"
+
+using namespace std;
+
+// Bursts of commands applied with one apply_batch() call against the same
+// bursts issued as one add_order/cancel_order call each. The book is a locked
+// one (not single-writer), publishing a depth snapshot and optionally the L2
+// delta feed, so per-message calls pay the lock and the end-of-message work
+// on every command and apply_batch once per burst. Building the pooled
+// orders is timed on both sides.
+//
+//   batch_perf [--orders N] [--burst N] [--depth D] [--level-deltas] [--ladder]
+//
+// --depth is the published snapshot depth (default 10, 0 disables it);
+// --level-deltas enables the L2 delta feed and drains it after every burst.
+
+uint64_t get_time_nanoseconds() {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+}
+
+int main(int argc, char** argv) {
+    const TickSize tick_size{};
+    OrderBookConfig config{.tick_size_ = tick_size};
+    config.snapshot_depth_ = 10;
+    size_t num_orders = 1'000'000;
+    size_t burst = 64;
+    for (int arg = 1; arg < argc; ++arg) {
+        if (std::strcmp(argv[arg], "--orders") == 0 && arg + 1 < argc)
+            num_orders = std::strtoull(argv[++arg], nullptr, 10);
+        else if (std::strcmp(argv[arg], "--burst") == 0 && arg + 1 < argc)
+            burst = std::max<size_t>(1, std::strtoull(argv[++arg], nullptr, 10));
+        else if (std::strcmp(argv[arg], "--depth") == 0 && arg + 1 < argc)
+            config.snapshot_depth_ = std::strtoull(argv[++arg], nullptr, 10);
+        else if (std::strcmp(argv[arg], "--level-deltas") == 0)
+            config.level_delta_capacity_ = 1 << 16;
+        else if (std::strcmp(argv[arg], "--ladder") == 0) {
+            config.ladder_base_price_ = tick_size.to_ticks(20.0);
+            config.ladder_levels_ = 21'000;
+        }
+    }
+    config.expected_orders_ = num_orders;
+
+    // Resting flow on both sides of mid with a crossing tail, cancels and markets
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> action_dist(0, 9);
+    std::uniform_int_distribution<int> side_dist(0, 1);
+    std::uniform_int_distribution<int> qty_dist(100, 1000);
+    std::normal_distribution<double> offset_dist(0.0, 40.0);
+    const Price mid = tick_size.to_ticks(125.0);
+    std::vector<OrderCommand> commands(num_orders);
+    OrderId id = 0;
+    for (auto& command : commands) {
+        int kind = action_dist(rng);
+        command.side_ = side_dist(rng) ? OrderSide::Buy : OrderSide::Sell;
+        if (kind >= 7 && id > 0) {
+            command.command_ = CommandType::Cancel;
+            command.order_id_ = std::uniform_int_distribution<OrderId>(1, id)(rng);
+            continue;
+        }
+        command.order_type_ = kind == 6 ? OrderType::Market : OrderType::GoodTillCancel;
+        command.order_id_ = ++id;
+        Price offset = 1 + static_cast<Price>(offset_dist(rng));
+        command.price_ = command.side_ == OrderSide::Buy ? mid - offset : mid + offset;
+        command.quantity_ = qty_dist(rng);
+    }
+
+    struct Run {
+        uint64_t total_ns_ = 0;
+        std::vector<uint64_t> bursts_;
+        size_t trades_ = 0;
+        size_t resting_ = 0;
+        uint64_t snapshots_ = 0;
+    };
+    auto run = [&](bool batched) {
+        MemoryPool<Order> order_pool(num_orders);
+        OrderBook book(config);
+        std::vector<CommandResult> results(burst);
+        Run out;
+        out.bursts_.reserve(commands.size() / burst + 1);
+        size_t deltas = 0;
+        auto count_trade = [&out](const TradeInfo&) { ++out.trades_; };
+        for (size_t begin = 0; begin < commands.size(); begin += burst) {
+            const auto slice = std::span(commands).subspan(begin, std::min(burst, commands.size() - begin));
+            const uint64_t start_t = get_time_nanoseconds();
+            if (batched) {
+                book.apply_batch(slice, order_pool, std::span(results).first(slice.size()), count_trade);
+            } else {
+                for (const auto& command : slice) {
+                    if (command.command_ == CommandType::Cancel)
+                        book.cancel_order(command.order_id_);
+                    else
+                        book.add_order(make_intrusive_pooled_order(&order_pool, command.order_type_, command.side_,
+                                                                   command.order_id_, command.price_,
+                                                                   command.quantity_),
+                                       count_trade);
+                }
+            }
+            const uint64_t elapsed = get_time_nanoseconds() - start_t;
+            out.bursts_.push_back(elapsed);
+            out.total_ns_ += elapsed;
+            if (config.level_delta_capacity_ != 0)
+                book.drain_level_deltas([&deltas](const auto&) { ++deltas; });
+        }
+        out.resting_ = book.Size();
+        out.snapshots_ = book.snapshot_sequence();
+        return out;
+    };
+
+    const auto single = run(false);
+    const auto batched = run(true);
+    cout << commands.size() << " commands in bursts of " << burst << ", snapshot depth " << config.snapshot_depth_
+         << (config.level_delta_capacity_ != 0 ? ", L2 delta feed on" : "") << endl;
+    const pair<const Run*, const char*> runs[] = {{&single, "One call per command"}, {&batched, "apply_batch per burst"}};
+    for (const auto& [result, name] : runs) {
+        cout << endl << name << ": " << result->total_ns_ / 1e6 << " ms, "
+             << commands.size() * 1e9 / max<uint64_t>(result->total_ns_, 1) << " msgs/sec, "
+             << static_cast<double>(result->total_ns_) / max<size_t>(commands.size(), 1) << " ns/msg" << endl;
+        cout << "trades: " << result->trades_ << ", resting: " << result->resting_
+             << ", snapshots published: " << result->snapshots_ << endl;
+        cout << "Burst latency (ns):" << endl;
+        appendLatencyStatsToFile(computeLatencyStats(result->bursts_));
+    }
+    cout << endl << "apply_batch speedup: " << static_cast<double>(single.total_ns_) / max<uint64_t>(batched.total_ns_, 1)
+         << "x" << endl;
+    return 0;
+}
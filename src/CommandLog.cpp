@@ -0,0 +1,301 @@
+#include "include/CommandLog.hpp"
+#include "include/BinaryProtocol.hpp"
+#include "include/ModifyOrder.hpp"
+#include "include/OrderBook.hpp"
+#include "include/PooledShared.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::filesystem::path &path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::system_error(errno, std::generic_category(), "open " + path.string());
+  struct stat info {};
+  if (::fstat(fd, &info) != 0) {
+    const int error = errno;
+    ::close(fd);
+    throw std::system_error(error, std::generic_category(), "stat " + path.string());
+  }
+  size_ = static_cast<std::size_t>(info.st_size);
+  if (size_ != 0) {
+    void *mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+      const int error = errno;
+      ::close(fd);
+      throw std::system_error(error, std::generic_category(), "mmap " + path.string());
+    }
+    // Read ahead aggressively and drop pages behind the replay
+    ::madvise(mapping, size_, MADV_SEQUENTIAL);
+    ::madvise(mapping, size_, MADV_WILLNEED);
+    data_ = static_cast<const std::byte *>(mapping);
+  }
+  ::close(fd); // the mapping keeps the file
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr)
+    ::munmap(const_cast<std::byte *>(data_), size_);
+}
+
+std::uint64_t LatencyHistogram::percentile(double pct) const {
+  if (count_ == 0)
+    return 0;
+  auto rank = static_cast<std::uint64_t>(pct / 100.0 * static_cast<double>(count_) + 0.5);
+  rank = std::clamp<std::uint64_t>(rank, 1, count_);
+  std::uint64_t seen = 0;
+  for (std::size_t index = 0; index < Buckets; ++index) {
+    seen += counts_[index];
+    if (seen < rank)
+      continue;
+    if (index < (1u << SubBits))
+      return index;
+    const unsigned shift = static_cast<unsigned>(index >> SubBits) - 1;
+    const auto lower = (static_cast<std::uint64_t>((1u << SubBits) + (index & ((1u << SubBits) - 1)))) << shift;
+    return std::min(lower + (std::uint64_t{1} << shift) - 1, max_);
+  }
+  return max_;
+}
+
+namespace {
+
+std::uint64_t now_nanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Applies commands one at a time, timing every Nth
+class Replayer {
+public:
+  Replayer(OrderBook &book, MemoryPool<Order> &order_pool, const ReplayOptions &options, ReplayStats &stats)
+      : book_(book), order_pool_(order_pool), sample_(options.latency_sample_), stats_(stats) {}
+
+  void apply(const OrderCommand &command) {
+    ++stats_.messages_;
+    if (sample_ != 0 && --until_sample_ == 0) {
+      until_sample_ = sample_;
+      const auto start_t = now_nanoseconds();
+      dispatch(command);
+      stats_.latency_[static_cast<std::size_t>(command.command_)].record(now_nanoseconds() - start_t);
+    } else {
+      dispatch(command);
+    }
+  }
+
+private:
+  void dispatch(const OrderCommand &command) {
+    auto count_trade = [this](const TradeInfo &) { ++stats_.trades_; };
+    switch (command.command_) {
+    case CommandType::Add:
+      book_.add_order(make_intrusive_pooled_order(&order_pool_, command.order_type_, command.side_,
+                                                  command.order_id_, command.price_, command.quantity_),
+                      count_trade, command.timestamp_);
+      break;
+    case CommandType::Cancel:
+      book_.cancel_order(command.order_id_);
+      break;
+    case CommandType::Modify:
+      book_.modify_order(OrderModify(&order_pool_, command.order_type_, command.side_, command.order_id_,
+                                     command.price_, command.quantity_),
+                         count_trade, command.timestamp_);
+      break;
+    case CommandType::MassCancel:
+      book_.mass_cancel(command.side_);
+      break;
+    case CommandType::AdvanceTime:
+      book_.advance_time(command.timestamp_);
+      break;
+    }
+  }
+
+  OrderBook &book_;
+  MemoryPool<Order> &order_pool_;
+  std::uint32_t sample_;
+  std::uint32_t until_sample_ = 1;
+  ReplayStats &stats_;
+};
+
+// Splits line at single spaces; false if it has more than out.size() tokens
+bool tokenize(std::string_view line, std::span<std::string_view> out, std::size_t &count) {
+  count = 0;
+  while (!line.empty()) {
+    const auto space = line.find(' ');
+    const auto token = line.substr(0, space);
+    if (!token.empty()) {
+      if (count == out.size())
+        return false;
+      out[count++] = token;
+    }
+    if (space == std::string_view::npos)
+      break;
+    line.remove_prefix(space + 1);
+  }
+  return true;
+}
+
+bool parse_number(std::string_view str, int &value) {
+  auto [end, error] = std::from_chars(str.data(), str.data() + str.size(), value);
+  return error == std::errc{} && end == str.data() + str.size();
+}
+
+bool parse_side(std::string_view str, OrderSide &side) {
+  if (str == "B")
+    side = OrderSide::Buy;
+  else if (str == "S")
+    side = OrderSide::Sell;
+  else
+    return false;
+  return true;
+}
+
+bool parse_order_type(std::string_view str, OrderType &type) {
+  if (str == "GoodTillCancel" || str == "GTC")
+    type = OrderType::GoodTillCancel;
+  else if (str == "FillAndKill" || str == "FAK")
+    type = OrderType::FillAndKill;
+  else if (str == "FillOrKill" || str == "FOK")
+    type = OrderType::FillOrKill;
+  else if (str == "GoodForDay" || str == "GFD")
+    type = OrderType::GoodForDay;
+  else if (str == "GoodTillDate" || str == "GTD")
+    type = OrderType::GoodTillDate;
+  else if (str == "Market" || str == "MKT")
+    type = OrderType::Market;
+  else
+    return false;
+  return true;
+}
+
+bool parse_timestamp(std::string_view str, Timestamp &value) {
+  auto [end, error] = std::from_chars(str.data(), str.data() + str.size(), value);
+  return error == std::errc{} && end == str.data() + str.size();
+}
+
+// A <side> <type> <price> <quantity> <id> [<expiry ns>, GoodTillDate only] |
+// C <id> | M <id> <side> <price> <quantity> | T <ns>
+bool parse_line(std::string_view line, OrderBook &book, OrderCommand &command) {
+  std::array<std::string_view, 7> tokens;
+  std::size_t count = 0;
+  if (!tokenize(line, tokens, count) || count == 0 || tokens[0].size() != 1)
+    return false;
+
+  command = OrderCommand{};
+  try {
+    switch (tokens[0][0]) {
+    case 'A':
+      command.command_ = CommandType::Add;
+      if (count < 6 || !parse_side(tokens[1], command.side_) ||
+          !parse_order_type(tokens[2], command.order_type_) ||
+          !parse_number(tokens[4], command.quantity_) || !parse_number(tokens[5], command.order_id_))
+        return false;
+      if (count != (command.order_type_ == OrderType::GoodTillDate ? 7u : 6u) ||
+          (count == 7 && !parse_timestamp(tokens[6], command.timestamp_)))
+        return false;
+      command.price_ = book.get_tick_size().to_ticks(tokens[3]);
+      return true;
+    case 'C':
+      command.command_ = CommandType::Cancel;
+      return count == 2 && parse_number(tokens[1], command.order_id_);
+    case 'M': {
+      command.command_ = CommandType::Modify;
+      if (count != 5 || !parse_number(tokens[1], command.order_id_) ||
+          !parse_side(tokens[2], command.side_) || !parse_number(tokens[4], command.quantity_))
+        return false;
+      command.price_ = book.get_tick_size().to_ticks(tokens[3]);
+      // The text form has no type: the order keeps its own, as in the REPL
+      if (auto existing = book.get_order_by_id(command.order_id_))
+        command.order_type_ = existing->get_order_type();
+      return true;
+    }
+    case 'T':
+      command.command_ = CommandType::AdvanceTime;
+      return count == 2 && parse_timestamp(tokens[1], command.timestamp_);
+    default:
+      return false;
+    }
+  } catch (const std::invalid_argument &) { // price not a decimal on tick
+    return false;
+  }
+}
+
+void replay_text(std::string_view log, OrderBook &book, Replayer &replayer, ReplayStats &stats) {
+  OrderCommand command;
+  while (!log.empty()) {
+    const auto end = log.find('\n');
+    auto line = log.substr(0, end);
+    if (!line.empty() && line.back() == '\r')
+      line.remove_suffix(1);
+    if (parse_line(line, book, command))
+      replayer.apply(command);
+    else if (!line.empty())
+      ++stats.skipped_;
+    if (end == std::string_view::npos)
+      break;
+    log.remove_prefix(end + 1);
+  }
+}
+
+void replay_binary(std::span<const std::byte> log, Replayer &replayer, ReplayStats &stats) {
+  std::array<OrderCommand, 1024> batch;
+  while (!log.empty()) {
+    const auto result = wire::decode_batch(log, batch);
+    for (std::size_t i = 0; i < result.commands_; ++i)
+      replayer.apply(batch[i]);
+    log = log.subspan(result.bytes_);
+    if (result.malformed_ || result.commands_ == 0) {
+      stats.malformed_ = true; // bad type/field, or a message cut off at the end
+      break;
+    }
+  }
+}
+
+void fnv1a(std::uint64_t &hash, std::uint64_t value) {
+  for (int byte = 0; byte < 8; ++byte, value >>= 8) {
+    hash ^= value & 0xff;
+    hash *= 0x100000001b3ull;
+  }
+}
+
+} // namespace
+
+ReplayStats replay_command_log(OrderBook &book, MemoryPool<Order> &order_pool,
+                               std::span<const std::byte> log, const ReplayOptions &options) {
+  ReplayStats stats;
+  Replayer replayer(book, order_pool, options, stats);
+  const auto start_t = now_nanoseconds();
+  if (options.format_ == LogFormat::Text)
+    replay_text(std::string_view(reinterpret_cast<const char *>(log.data()), log.size()), book, replayer, stats);
+  else
+    replay_binary(log, replayer, stats);
+  stats.elapsed_ns_ = now_nanoseconds() - start_t;
+  stats.checksum_ = book_checksum(book);
+  return stats;
+}
+
+std::uint64_t book_checksum(OrderBook &book) {
+  std::uint64_t hash = 0xcbf29ce484222325ull;
+  const auto levels = book.get_order_book();
+  for (const auto &[price, level] : levels.get_bids()) {
+    fnv1a(hash, static_cast<std::uint64_t>(price));
+    fnv1a(hash, static_cast<std::uint64_t>(level.quantity_));
+    fnv1a(hash, static_cast<std::uint64_t>(level.count_));
+  }
+  fnv1a(hash, ~std::uint64_t{0}); // side separator
+  for (const auto &[price, level] : levels.get_asks()) {
+    fnv1a(hash, static_cast<std::uint64_t>(price));
+    fnv1a(hash, static_cast<std::uint64_t>(level.quantity_));
+    fnv1a(hash, static_cast<std::uint64_t>(level.count_));
+  }
+  fnv1a(hash, book.Size());
+  return hash;
+}
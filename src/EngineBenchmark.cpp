@@ -0,0 +1,154 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "include/MatchingEngine.hpp"
+#include "include/OrderCommand.hpp"
+#include "include/TickSize.hpp"
+#include "perf_utils/LatencyStats.hpp"
+
+using namespace std;
+
+// End-to-end latency through MatchingEngine: the producer stamps each command's
+// tag with its enqueue time, the consumer thread measures enqueue -> first
+// trade (commands that trade) and enqueue -> Done (every command).
+//
+//   engine_perf [--core N] [--rate COMMANDS_PER_SEC] [--ladder]
+//
+// --rate paces the producer (0 = as fast as the ring accepts, which measures
+// queueing as much as matching).
+
+uint64_t get_time_nanoseconds() {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+}
+
+int main(int argc, char** argv) {
+    const TickSize tick_size{};
+    MatchingEngineConfig config;
+    config.book_.tick_size_ = tick_size;
+    uint64_t rate = 200'000;
+    for (int arg = 1; arg < argc; ++arg) {
+        if (std::strcmp(argv[arg], "--core") == 0 && arg + 1 < argc)
+            config.core_ = std::atoi(argv[++arg]);
+        else if (std::strcmp(argv[arg], "--rate") == 0 && arg + 1 < argc)
+            rate = std::strtoull(argv[++arg], nullptr, 10);
+        else if (std::strcmp(argv[arg], "--ladder") == 0) {
+            config.book_.ladder_base_price_ = tick_size.to_ticks(20.0);
+            config.book_.ladder_levels_ = 21'000;
+        }
+    }
+    config.order_pool_slots_ = 2'000'000;
+
+    // Producer, consumer and matching thread all spin; with fewer cores than
+    // that, spinning just burns the timeslice the other side needs
+    const bool oversubscribed = std::thread::hardware_concurrency() < 3;
+    auto relax = [oversubscribed]() {
+        if (oversubscribed)
+            std::this_thread::yield();
+    };
+
+    const int NUM_RESTING = 400'000;
+    const int NUM_MEASURED = 500'000;
+    MatchingEngine engine(config);
+
+    // Consumer: drains events until every command has its Done
+    std::vector<uint64_t> trade_latencies;
+    std::vector<uint64_t> done_latencies;
+    trade_latencies.reserve(NUM_MEASURED);
+    done_latencies.reserve(NUM_MEASURED);
+    const uint64_t total_commands = NUM_RESTING + NUM_MEASURED;
+    std::thread consumer([&]() {
+        uint64_t done = 0;
+        uint64_t last_traded_tag = 0;
+        EngineEvent event;
+        while (done < total_commands) {
+            if (!engine.try_poll(event)) {
+                relax();
+                continue;
+            }
+            if (event.tag_ == 0) { // populate phase, not measured
+                done += event.kind_ == EngineEvent::Kind::Done;
+                continue;
+            }
+            uint64_t now = get_time_nanoseconds();
+            if (event.kind_ == EngineEvent::Kind::Trade) {
+                if (event.tag_ != last_traded_tag) {
+                    trade_latencies.push_back(now - event.tag_);
+                    last_traded_tag = event.tag_;
+                }
+            } else {
+                done_latencies.push_back(now - event.tag_);
+                ++done;
+            }
+        }
+    });
+
+    auto submit = [&](const OrderCommand& command) {
+        while (!engine.try_submit(command))
+            relax();
+    };
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> qty_dist(100, 1000);
+    std::normal_distribution<double> offset_dist(0.0, 40.0);
+    const Price mid = tick_size.to_ticks(125.0);
+    OrderId id = 0;
+
+    // Resting book: bids below mid, asks above
+    for (int i = 0; i < NUM_RESTING; ++i) {
+        OrderCommand command;
+        command.order_id_ = ++id;
+        command.side_ = (i & 1) ? OrderSide::Sell : OrderSide::Buy;
+        Price offset = 1 + static_cast<Price>(std::abs(offset_dist(rng)));
+        command.price_ = command.side_ == OrderSide::Buy ? mid - offset : mid + offset;
+        command.quantity_ = qty_dist(rng);
+        submit(command);
+    }
+
+    while (engine.processed() < static_cast<uint64_t>(NUM_RESTING))
+        relax();
+
+    // Measured flow: limits around mid (a share of them cross), cancels, markets
+    std::uniform_int_distribution<int> action_dist(0, 9);
+    std::uniform_int_distribution<int> side_dist(0, 1);
+    const uint64_t interval = rate ? 1'000'000'000 / rate : 0;
+    uint64_t next_send = get_time_nanoseconds();
+    for (int i = 0; i < NUM_MEASURED; ++i) {
+        OrderCommand command;
+        int action = action_dist(rng);
+        command.side_ = side_dist(rng) ? OrderSide::Buy : OrderSide::Sell;
+        if (action < 6) {
+            command.order_id_ = ++id;
+            Price offset = static_cast<Price>(offset_dist(rng) / 4);
+            command.price_ = command.side_ == OrderSide::Buy ? mid - offset : mid + offset;
+            command.quantity_ = qty_dist(rng);
+        } else if (action < 9) {
+            command.command_ = CommandType::Cancel;
+            command.order_id_ = std::uniform_int_distribution<OrderId>(1, id)(rng);
+        } else {
+            command.order_id_ = ++id;
+            command.order_type_ = OrderType::Market;
+            command.quantity_ = qty_dist(rng);
+        }
+        if (interval) {
+            while (get_time_nanoseconds() < next_send)
+                relax();
+            next_send += interval;
+        }
+        command.tag_ = get_time_nanoseconds();
+        submit(command);
+    }
+    consumer.join();
+
+    cout << endl << "Enqueue -> first trade (" << trade_latencies.size() << " commands that traded):" << endl;
+    appendLatencyStatsToFile(computeLatencyStats(trade_latencies));
+    cout << endl << "Enqueue -> done (" << done_latencies.size() << " commands):" << endl;
+    appendLatencyStatsToFile(computeLatencyStats(done_latencies));
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "include/OrderBook.hpp"
+#include "include/PooledShared.hpp"
+#include "include/TickSize.hpp"
+#include "perf_utils/LatencyStats.hpp"
+
+using namespace std;
+
+// End-of-session GoodForDay expiry in a book dominated by GoodTillCancel
+// orders. Half the GoodForDay orders share levels with GoodTillCancel ones,
+// half sit on levels of their own (expired a level at a time).
+//
+//   gfd_perf [--orders N] [--gfd N] [--chunk N] [--ladder]
+//
+// 1. Steps: a single-writer book expires in --chunk sized steps; reports the
+//    time each step holds the book, against cancelling the same orders one
+//    by one.
+// 2. Live: a locked book whose session clock reaches the cutoff just after
+//    the book is filled; this thread keeps adding and cancelling orders while the prune thread
+//    expires, and reports those calls' latency.
+
+uint64_t get_time_nanoseconds() {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+}
+
+struct Resting {
+    OrderType type_;
+    OrderSide side_;
+    Price price_;
+};
+
+int main(int argc, char** argv) {
+    const TickSize tick_size{};
+    OrderBookConfig config{.tick_size_ = tick_size};
+    size_t num_orders = 2'000'000;
+    size_t num_gfd = 200'000;
+    for (int arg = 1; arg < argc; ++arg) {
+        if (std::strcmp(argv[arg], "--orders") == 0 && arg + 1 < argc)
+            num_orders = std::strtoull(argv[++arg], nullptr, 10);
+        else if (std::strcmp(argv[arg], "--gfd") == 0 && arg + 1 < argc)
+            num_gfd = std::strtoull(argv[++arg], nullptr, 10);
+        else if (std::strcmp(argv[arg], "--chunk") == 0 && arg + 1 < argc)
+            config.good_for_day_expiry_chunk_ = std::strtoull(argv[++arg], nullptr, 10);
+        else if (std::strcmp(argv[arg], "--ladder") == 0) {
+            config.ladder_base_price_ = tick_size.to_ticks(20.0);
+            config.ladder_levels_ = 21'000;
+        }
+    }
+    config.expected_orders_ = num_orders + num_gfd;
+
+    // GoodTillCancel within 100.00-150.00 around a 125.00 mid, with half the
+    // GoodForDay orders among them; the other half out at 80.00-99.99 and
+    // 150.01-170.00, away from everything else
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> offset_dist(1, 2'500);
+    std::uniform_int_distribution<int> outer_dist(1, 2'000);
+    const Price mid = tick_size.to_ticks(125.0);
+    vector<Resting> resting;
+    resting.reserve(num_orders + num_gfd);
+    const size_t stride = num_gfd == 0 ? 0 : (num_orders + num_gfd) / num_gfd;
+    for (size_t i = 0; i < num_orders + num_gfd; ++i) {
+        const auto side = i % 2 ? OrderSide::Buy : OrderSide::Sell;
+        const bool gfd = stride != 0 && i % stride == 0;
+        const bool outer = gfd && i / stride % 2 == 1;
+        const Price offset = outer ? 2'500 + outer_dist(rng) : offset_dist(rng);
+        resting.push_back({gfd ? OrderType::GoodForDay : OrderType::GoodTillCancel, side,
+                           side == OrderSide::Buy ? mid - offset : mid + offset});
+    }
+
+    auto fill = [&](OrderBook& book, MemoryPool<Order>& pool) {
+        OrderId id = 0;
+        for (const auto& order : resting)
+            book.add_order(make_intrusive_pooled_order(&pool, order.type_, order.side_, ++id, order.price_, 100),
+                           [](const TradeInfo&) {});
+    };
+
+    uint64_t fill_t = 0;
+    {
+        MemoryPool<Order> pool(resting.size());
+        auto book_config = config;
+        book_config.single_writer_ = true;
+        OrderBook book(book_config);
+        fill_t = get_time_nanoseconds();
+        fill(book, pool);
+        fill_t = get_time_nanoseconds() - fill_t;
+        const auto gfd_orders = book.good_for_day_count();
+        const auto total = book.Size();
+
+        std::vector<uint64_t> holds;
+        const uint64_t start_t = get_time_nanoseconds();
+        book.begin_good_for_day_expiry();
+        bool pending = true;
+        while (pending) {
+            const uint64_t chunk_t = get_time_nanoseconds();
+            pending = book.expire_good_for_day(book_config.good_for_day_expiry_chunk_);
+            holds.push_back(get_time_nanoseconds() - chunk_t);
+        }
+        const uint64_t expiry_t = get_time_nanoseconds() - start_t;
+        const auto stats = computeLatencyStats(holds);
+        cout << "Expiring " << gfd_orders << " GoodForDay orders among " << total << " resting, chunks of "
+             << book_config.good_for_day_expiry_chunk_ << ":" << endl;
+        cout << "total: " << expiry_t / 1e6 << " ms (" << static_cast<double>(expiry_t) / max<size_t>(gfd_orders, 1)
+             << " ns/order), " << holds.size() << " chunks, book held p50 " << stats.p50 / 1e3 << " us, p99 "
+             << stats.p99 / 1e3 << " us, max " << *std::max_element(holds.begin(), holds.end()) / 1e3 << " us"
+             << endl;
+        cout << "left: " << book.Size() << " orders, " << book.good_for_day_count() << " GoodForDay" << endl;
+
+        // Baseline: the same orders cancelled one at a time
+        MemoryPool<Order> cancel_pool(resting.size());
+        OrderBook cancelled(book_config);
+        fill(cancelled, cancel_pool);
+        const uint64_t cancel_start = get_time_nanoseconds();
+        for (size_t i = 0; i < resting.size(); ++i)
+            if (resting[i].type_ == OrderType::GoodForDay)
+                cancelled.cancel_order(static_cast<OrderId>(i + 1));
+        const uint64_t cancel_t = get_time_nanoseconds() - cancel_start;
+        cout << "cancel_order per GoodForDay order: " << cancel_t / 1e6 << " ms ("
+             << static_cast<double>(cancel_t) / max<size_t>(gfd_orders, 1) << " ns/order)" << endl;
+    }
+
+    {
+        using namespace std::chrono;
+        MemoryPool<Order> pool(resting.size() + 1);
+        auto book_config = config;
+        // The prune thread starts with the first order, so the cutoff is set to
+        // come once the book is filled (going by the fill above), plus 200ms
+        const auto lead = nanoseconds(2 * fill_t) + milliseconds(200);
+        book_config.session_clock_ = [offset = next_good_for_day_cutoff(system_clock::now()) - lead -
+                                               system_clock::now()]() { return system_clock::now() + offset; };
+        OrderBook book(book_config);
+        fill(book, pool);
+
+        // Flow at 75.00, clear of the book (no fills), until the prune thread is done
+        std::vector<uint64_t> before, during;
+        before.reserve(1 << 20);
+        during.reserve(1 << 20);
+        const auto gfd_orders = book.good_for_day_count();
+        OrderId id = static_cast<OrderId>(resting.size());
+        const auto deadline = steady_clock::now() + seconds(10);
+        while (steady_clock::now() < deadline) {
+            const auto gfd_left = book.good_for_day_count();
+            if (gfd_left == 0)
+                break;
+            auto order = make_intrusive_pooled_order(&pool, OrderType::GoodTillCancel, OrderSide::Buy, ++id,
+                                                     mid - 5'000, 100);
+            const uint64_t start_t = get_time_nanoseconds();
+            book.add_order(std::move(order), [](const TradeInfo&) {});
+            book.cancel_order(id);
+            (gfd_left < gfd_orders ? during : before).push_back(get_time_nanoseconds() - start_t);
+        }
+        cout << endl << "Add+cancel round trip while the prune thread expires (ns):" << endl;
+        appendLatencyStatsToFile(computeLatencyStats(during));
+        if (!during.empty())
+            cout << "max: " << *std::max_element(during.begin(), during.end()) << " ns" << endl;
+        cout << endl << "Before the cutoff (ns):" << endl;
+        appendLatencyStatsToFile(computeLatencyStats(before));
+        cout << "GoodForDay left: " << book.good_for_day_count() << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "include/OrderBook.hpp"
+#include "include/PooledShared.hpp"
+#include "include/TickSize.hpp"
+#include "include/TimerWheel.hpp"
+#include "perf_utils/LatencyStats.hpp"
+
+using namespace std;
+
+// GoodTillDate expiry on the timer wheel: a single-writer book holding
+// --orders pending expiries spread over --horizon-ms, whose clock is then
+// advanced one --step-us at a time to the end of the horizon, as the matching
+// thread would. Each advance_time() call is timed.
+//
+//   gtd_perf [--orders N] [--horizon-ms H] [--step-us S] [--cancel PCT] [--ladder]
+//
+// --cancel cancels that share of the orders before their expiry; their wheel
+// entries stay behind and are skipped when they fire.
+//
+// 1. Wheel alone: schedule every expiry, then advance through them.
+// 2. Book: add cost against GoodTillCancel, then the per-tick cost of ticks
+//    with nothing due and of ticks that expire orders.
+
+uint64_t get_time_nanoseconds() {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+}
+
+struct Resting {
+    OrderSide side_;
+    Price price_;
+    Timestamp expiry_;
+};
+
+int main(int argc, char** argv) {
+    const TickSize tick_size{};
+    OrderBookConfig config{.tick_size_ = tick_size};
+    config.single_writer_ = true;
+    size_t num_orders = 1'000'000;
+    uint64_t horizon_ms = 3'600'000;
+    uint64_t step_us = 1'000;
+    int cancel_pct = 0;
+    for (int arg = 1; arg < argc; ++arg) {
+        if (std::strcmp(argv[arg], "--orders") == 0 && arg + 1 < argc)
+            num_orders = std::strtoull(argv[++arg], nullptr, 10);
+        else if (std::strcmp(argv[arg], "--horizon-ms") == 0 && arg + 1 < argc)
+            horizon_ms = std::strtoull(argv[++arg], nullptr, 10);
+        else if (std::strcmp(argv[arg], "--step-us") == 0 && arg + 1 < argc)
+            step_us = std::max<uint64_t>(1, std::strtoull(argv[++arg], nullptr, 10));
+        else if (std::strcmp(argv[arg], "--cancel") == 0 && arg + 1 < argc)
+            cancel_pct = std::atoi(argv[++arg]);
+        else if (std::strcmp(argv[arg], "--ladder") == 0) {
+            config.ladder_base_price_ = tick_size.to_ticks(20.0);
+            config.ladder_levels_ = 21'000;
+        }
+    }
+    config.expected_orders_ = num_orders;
+
+    // Resting on both sides of a 125.00 mid without crossing, each with an
+    // expiry somewhere in the next horizon_ms
+    const Timestamp start = 1'700'000'000'000'000'000ull;
+    const Timestamp horizon = horizon_ms * 1'000'000;
+    const Timestamp step = step_us * 1'000;
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int> offset_dist(1, 2'500);
+    std::uniform_int_distribution<Timestamp> expiry_dist(1, horizon);
+    const Price mid = tick_size.to_ticks(125.0);
+    vector<Resting> resting(num_orders);
+    for (size_t i = 0; i < num_orders; ++i) {
+        const auto side = i % 2 ? OrderSide::Buy : OrderSide::Sell;
+        const Price offset = offset_dist(rng);
+        resting[i] = {side, side == OrderSide::Buy ? mid - offset : mid + offset, start + expiry_dist(rng)};
+    }
+
+    {
+        const auto resolution = static_cast<uint64_t>(config.timer_resolution_.count());
+        TimerWheel wheel(start / resolution);
+        uint64_t start_t = get_time_nanoseconds();
+        for (size_t i = 0; i < num_orders; ++i)
+            wheel.schedule((resting[i].expiry_ + resolution - 1) / resolution, static_cast<OrderId>(i + 1));
+        const uint64_t schedule_t = get_time_nanoseconds() - start_t;
+        size_t fired = 0;
+        start_t = get_time_nanoseconds();
+        for (Timestamp now = start; now <= start + horizon; now += step)
+            wheel.advance(now / resolution, [&fired](OrderId) { ++fired; });
+        const uint64_t advance_t = get_time_nanoseconds() - start_t;
+        cout << "TimerWheel alone, " << num_orders << " entries over " << horizon_ms << " ms:" << endl;
+        cout << "schedule: " << static_cast<double>(schedule_t) / max<size_t>(num_orders, 1)
+             << " ns/entry, advance: " << advance_t / 1e6 << " ms for " << fired << " entries ("
+             << static_cast<double>(advance_t) / max<size_t>(fired, 1) << " ns/entry, idle steps included)" << endl;
+    }
+
+    auto fill = [&](OrderBook& book, MemoryPool<Order>& pool, OrderType type) {
+        const uint64_t start_t = get_time_nanoseconds();
+        for (size_t i = 0; i < num_orders; ++i)
+            book.add_order(make_intrusive_pooled_order(&pool, type, resting[i].side_, static_cast<OrderId>(i + 1),
+                                                       resting[i].price_, 100),
+                           [](const TradeInfo&) {}, resting[i].expiry_);
+        return get_time_nanoseconds() - start_t;
+    };
+
+    uint64_t gtc_fill_t = 0;
+    {
+        MemoryPool<Order> pool(num_orders);
+        OrderBook book(config);
+        book.advance_time(start);
+        gtc_fill_t = fill(book, pool, OrderType::GoodTillCancel);
+    }
+
+    MemoryPool<Order> pool(num_orders);
+    OrderBook book(config);
+    book.advance_time(start);
+    const uint64_t gtd_fill_t = fill(book, pool, OrderType::GoodTillDate);
+    cout << endl << "add_order: GoodTillDate " << static_cast<double>(gtd_fill_t) / max<size_t>(num_orders, 1)
+         << " ns/order, GoodTillCancel " << static_cast<double>(gtc_fill_t) / max<size_t>(num_orders, 1)
+         << " ns/order" << endl;
+
+    std::uniform_int_distribution<int> pct_dist(0, 99);
+    size_t cancelled = 0;
+    for (size_t i = 0; i < num_orders; ++i) {
+        if (pct_dist(rng) < cancel_pct) {
+            book.cancel_order(static_cast<OrderId>(i + 1));
+            ++cancelled;
+        }
+    }
+
+    std::vector<uint64_t> idle, expiring;
+    idle.reserve(horizon / step + 1);
+    expiring.reserve(horizon / step + 1);
+    size_t expired = 0;
+    uint64_t expiring_t = 0;
+    const uint64_t total_start = get_time_nanoseconds();
+    for (Timestamp now = start + step; now <= start + horizon; now += step) {
+        const uint64_t start_t = get_time_nanoseconds();
+        const auto count = book.advance_time(now);
+        const uint64_t elapsed = get_time_nanoseconds() - start_t;
+        (count == 0 ? idle : expiring).push_back(elapsed);
+        if (count != 0) {
+            expired += count;
+            expiring_t += elapsed;
+        }
+    }
+    const uint64_t total_t = get_time_nanoseconds() - total_start;
+
+    cout << endl << "advance_time every " << step_us << " us over " << horizon_ms << " ms, " << num_orders
+         << " GoodTillDate orders pending (" << cancelled << " cancelled beforehand):" << endl;
+    cout << "total: " << total_t / 1e6 << " ms for " << idle.size() + expiring.size() << " ticks, " << expired
+         << " orders expired, " << book.Size() << " left" << endl;
+    if (!idle.empty()) {
+        cout << endl << "Ticks with nothing due (" << idle.size() << ", ns):" << endl;
+        appendLatencyStatsToFile(computeLatencyStats(idle));
+    }
+    if (!expiring.empty()) {
+        cout << endl << "Ticks that expire orders (" << expiring.size() << ", ns):" << endl;
+        appendLatencyStatsToFile(computeLatencyStats(expiring));
+        cout << "max: " << *std::max_element(expiring.begin(), expiring.end()) << " ns, "
+             << static_cast<double>(expiring_t) / max<size_t>(expired, 1) << " ns per expired order" << endl;
+    }
+    return 0;
+}
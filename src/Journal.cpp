@@ -0,0 +1,153 @@
+#include "include/Journal.hpp"
+#include "include/ModifyOrder.hpp"
+#include "include/OrderBook.hpp"
+#include "include/PooledShared.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <system_error>
+#include <unistd.h>
+
+Journal::Journal(JournalConfig config)
+    : config_(std::move(config)), ring_(config_.ring_capacity_),
+      batch_(std::max<std::size_t>(1, config_.batch_records_)) {
+  fd_ = ::open(config_.path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0)
+    throw std::system_error(errno, std::generic_category(), "open " + config_.path_.string());
+  if (config_.preallocate_bytes_ != 0) {
+    // Zero-filled: read_journal stops at the first sequence 0
+    const int error = ::posix_fallocate(fd_, 0, static_cast<off_t>(config_.preallocate_bytes_));
+    if (error != 0) {
+      ::close(fd_);
+      throw std::system_error(error, std::generic_category(), "fallocate " + config_.path_.string());
+    }
+    ::fdatasync(fd_);
+  }
+  writer_ = std::thread{[this]() { run(); }};
+}
+
+Journal::~Journal() {
+  stop_.store(true, std::memory_order_release);
+  writer_.join();
+  ::close(fd_);
+}
+
+void Journal::flush() {
+  const auto target = sequence_;
+  sync_requested_.store(true, std::memory_order_release);
+  while (durable_.load(std::memory_order_acquire) < target && error() == 0)
+    std::this_thread::sleep_for(config_.idle_wait_);
+}
+
+void Journal::run() {
+#ifdef __linux__
+  if (config_.core_ >= 0) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(config_.core_, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  }
+#endif
+  auto last_sync = std::chrono::steady_clock::now();
+  bool unsynced = false;
+  while (true) {
+    // Read before draining: once it is set, an empty ring stays empty
+    const bool stopping = stop_.load(std::memory_order_acquire);
+    std::size_t count = 0;
+    while (count < batch_.size() && ring_.try_pop(batch_[count]))
+      ++count;
+
+    if (count != 0) {
+      write_batch(count);
+      unsynced = true;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    const bool sync_now =
+        unsynced && (config_.durability_ == Durability::GroupCommit || stopping ||
+                     sync_requested_.exchange(false, std::memory_order_acq_rel) ||
+                     (config_.durability_ == Durability::Periodic && now - last_sync >= config_.sync_interval_));
+    if (sync_now) {
+      sync();
+      last_sync = now;
+      unsynced = false;
+    } else if (!unsynced || config_.durability_ == Durability::Buffered) {
+      // Buffered promises no more than write()
+      durable_.store(written_.load(std::memory_order_relaxed), std::memory_order_release);
+    }
+
+    if (count == 0) {
+      if (stopping)
+        break;
+      std::this_thread::sleep_for(config_.idle_wait_);
+    }
+  }
+}
+
+void Journal::write_batch(std::size_t count) {
+  const auto last = batch_[count - 1].sequence_;
+  if (error() == 0) {
+    // Here rather than in append(), off the matching thread
+    for (std::size_t i = 0; i < count; ++i)
+      batch_[i].checksum_ = journal_checksum(batch_[i]);
+    const auto *data = reinterpret_cast<const char *>(batch_.data());
+    std::size_t remaining = count * sizeof(JournalRecord);
+    while (remaining != 0) {
+      // Sequential from offset 0 (the file is opened truncated, and
+      // fallocate leaves the offset alone), so a pipe works as well as a file
+      const auto written = ::write(fd_, data, remaining);
+      if (written < 0) {
+        if (errno == EINTR)
+          continue;
+        error_.store(errno, std::memory_order_release);
+        break;
+      }
+      data += written;
+      remaining -= static_cast<std::size_t>(written);
+    }
+  }
+  batches_.fetch_add(1, std::memory_order_relaxed);
+  // Advanced even after an error, so flush() and the producer never hang
+  written_.store(last, std::memory_order_release);
+}
+
+void Journal::sync() {
+  if (error() == 0 && ::fdatasync(fd_) != 0)
+    error_.store(errno, std::memory_order_release);
+  syncs_.fetch_add(1, std::memory_order_relaxed);
+  durable_.store(written_.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+std::size_t recover_from_journal(OrderBook &book, MemoryPool<Order> &order_pool, std::span<const std::byte> bytes,
+                                 SymbolId symbol) {
+  std::size_t applied = 0;
+  read_journal(bytes, [&](const JournalRecord &record) {
+    if (record.kind_ != JournalRecordKind::Command || record.symbol_ != symbol)
+      return;
+    ++applied;
+    const auto type = static_cast<OrderType>(record.order_type_);
+    const auto side = static_cast<OrderSide>(record.side_);
+    switch (record.command_) {
+    case CommandType::Add:
+      book.add_order(make_intrusive_pooled_order(&order_pool, type, side, record.order_id_,
+                                                 record.price_, record.quantity_),
+                     [](const TradeInfo &) {}, record.expiry_, record.participant_);
+      break;
+    case CommandType::Cancel:
+      book.cancel_order(record.order_id_);
+      break;
+    case CommandType::Modify:
+      book.modify_order(OrderModify(&order_pool, type, side, record.order_id_,
+                                    record.price_, record.quantity_),
+                        [](const TradeInfo &) {}, record.expiry_);
+      break;
+    case CommandType::MassCancel:
+      book.mass_cancel(side);
+      break;
+    case CommandType::AdvanceTime: // never journaled
+      break;
+    }
+  });
+  return applied;
+}
@@ -0,0 +1,149 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "include/Journal.hpp"
+#include "include/OrderBook.hpp"
+#include "include/PooledShared.hpp"
+#include "include/TickSize.hpp"
+#include "perf_utils/LatencyStats.hpp"
+
+using namespace std;
+
+// Matching-thread cost of the write-ahead journal. The same pre-generated
+// flow runs through a book without a journal and then with one in each
+// durability mode. Only the book call is timed; the writer thread's
+// write/fdatasync work shows up on the matching thread only when the ring
+// fills (reported as stalls), or when it shares the matching thread's core.
+//
+//   journal_perf [--orders N] [--ladder] [--path FILE] [--ring N] [--core C]
+//
+// FILE defaults to the temp directory; point it at the disk you care about.
+// --ring sizes the journal ring (default 4096 records, 160KB: a ring that
+// stays in cache costs less per append than a deep one the writer keeps
+// evicting); --core pins the writer thread.
+
+uint64_t get_time_nanoseconds() {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+}
+
+struct Action {
+    bool cancel_;
+    OrderType type_;
+    OrderSide side_;
+    OrderId id_;
+    Price price_;
+    Quantity quantity_;
+};
+
+int main(int argc, char** argv) {
+    const TickSize tick_size{};
+    OrderBookConfig config{.tick_size_ = tick_size};
+    int num_orders = 1'000'000;
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "orderbook_bench.journal";
+    size_t ring = 4096;
+    int core = -1;
+    for (int arg = 1; arg < argc; ++arg) {
+        if (std::strcmp(argv[arg], "--orders") == 0 && arg + 1 < argc)
+            num_orders = std::atoi(argv[++arg]);
+        else if (std::strcmp(argv[arg], "--path") == 0 && arg + 1 < argc)
+            path = argv[++arg];
+        else if (std::strcmp(argv[arg], "--ring") == 0 && arg + 1 < argc)
+            ring = std::strtoull(argv[++arg], nullptr, 10);
+        else if (std::strcmp(argv[arg], "--core") == 0 && arg + 1 < argc)
+            core = std::atoi(argv[++arg]);
+        else if (std::strcmp(argv[arg], "--ladder") == 0) {
+            config.ladder_base_price_ = tick_size.to_ticks(20.0);
+            config.ladder_levels_ = 21'000;
+        }
+    }
+    config.expected_orders_ = num_orders;
+
+    // Resting flow on both sides of mid with a crossing tail, cancels and markets
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> action_dist(0, 9);
+    std::uniform_int_distribution<int> side_dist(0, 1);
+    std::uniform_int_distribution<int> qty_dist(100, 1000);
+    std::normal_distribution<double> offset_dist(0.0, 40.0);
+    const Price mid = tick_size.to_ticks(125.0);
+    std::vector<Action> actions(num_orders);
+    OrderId id = 0;
+    for (auto& action : actions) {
+        int kind = action_dist(rng);
+        action.side_ = side_dist(rng) ? OrderSide::Buy : OrderSide::Sell;
+        action.cancel_ = kind >= 7 && id > 0;
+        action.type_ = kind == 6 ? OrderType::Market : OrderType::GoodTillCancel;
+        if (action.cancel_) {
+            action.id_ = std::uniform_int_distribution<OrderId>(1, id)(rng);
+            continue;
+        }
+        action.id_ = ++id;
+        Price offset = 1 + static_cast<Price>(offset_dist(rng));
+        action.price_ = action.side_ == OrderSide::Buy ? mid - offset : mid + offset;
+        action.quantity_ = qty_dist(rng);
+    }
+
+    auto run = [&](Journal* journal) {
+        MemoryPool<Order> order_pool(num_orders);
+        auto book_config = config;
+        book_config.journal_ = journal;
+        OrderBook book(book_config);
+        TradeInfos trades;
+        trades.trades_made_.reserve(1024);
+        std::vector<uint64_t> latencies;
+        latencies.reserve(actions.size());
+        for (const auto& action : actions) {
+            uint64_t start_t;
+            if (action.cancel_) {
+                start_t = get_time_nanoseconds();
+                book.cancel_order(action.id_);
+            } else {
+                auto order = make_intrusive_pooled_order(&order_pool, action.type_, action.side_, action.id_,
+                                                         action.price_, action.quantity_);
+                trades.trades_made_.clear();
+                start_t = get_time_nanoseconds();
+                book.add_order(std::move(order), trades);
+            }
+            latencies.push_back(get_time_nanoseconds() - start_t);
+        }
+        return computeLatencyStats(latencies);
+    };
+
+    const auto plain = run(nullptr);
+    cout << endl << "Matcher without a journal (" << actions.size() << " calls):" << endl;
+    appendLatencyStatsToFile(plain);
+
+    const pair<Durability, const char*> modes[] = {
+        {Durability::Buffered, "Buffered"}, {Durability::Periodic, "Periodic (1ms)"}, {Durability::GroupCommit, "GroupCommit"}};
+    for (const auto& [durability, name] : modes) {
+        JournalConfig journal_config{.path_ = path, .durability_ = durability, .ring_capacity_ = ring,
+                                     .batch_records_ = ring / 8, .core_ = core};
+        // Commands plus trades: comfortably more than one record per call
+        journal_config.preallocate_bytes_ = actions.size() * 2 * sizeof(JournalRecord);
+        Journal journal(journal_config);
+        const auto stats = run(&journal);
+        const auto start_t = get_time_nanoseconds();
+        journal.flush();
+        const auto flush_t = get_time_nanoseconds() - start_t;
+
+        cout << endl << "Matcher journaling, " << name << ":" << endl;
+        appendLatencyStatsToFile(stats);
+        cout << "average cost: " << stats.avg - plain.avg << " ns/call, p50 " << static_cast<int64_t>(stats.p50 - plain.p50)
+             << " ns, p99 " << static_cast<int64_t>(stats.p99 - plain.p99) << " ns" << endl;
+        cout << "records: " << journal.appended_sequence() << ", write batches: " << journal.batches()
+             << ", fdatasyncs: " << journal.syncs() << ", ring-full stalls: " << journal.stalls()
+             << ", final flush: " << flush_t / 1e3 << " us" << endl;
+        if (journal.error() != 0) {
+            cerr << "journal write failed: " << std::strerror(journal.error()) << endl;
+            return 1;
+        }
+    }
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "include/OrderBookManager.hpp"
+#include "include/OrderCommand.hpp"
+#include "include/TickSize.hpp"
+
+using namespace std;
+
+// Multi-symbol throughput through OrderBookManager: the same pre-generated
+// command stream (adds around each symbol's mid, cancels of that symbol's
+// earlier orders, market orders) is replayed with 1, 2, 4... shards and the
+// commands/sec of each run is compared with the first one.
+//
+//   manager_perf [--symbols N] [--commands N] [--shards 1,2,4] [--first-core C]
+//
+// --first-core pins shard i to core C + i.
+
+uint64_t get_time_nanoseconds() {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+}
+
+int main(int argc, char** argv) {
+    std::size_t num_symbols = 1000;
+    std::size_t num_commands = 2'000'000;
+    std::vector<std::size_t> shard_counts{1, 2, 4};
+    int first_core = -1;
+    for (int arg = 1; arg < argc; ++arg) {
+        if (std::strcmp(argv[arg], "--symbols") == 0 && arg + 1 < argc)
+            num_symbols = std::strtoull(argv[++arg], nullptr, 10);
+        else if (std::strcmp(argv[arg], "--commands") == 0 && arg + 1 < argc)
+            num_commands = std::strtoull(argv[++arg], nullptr, 10);
+        else if (std::strcmp(argv[arg], "--first-core") == 0 && arg + 1 < argc)
+            first_core = std::atoi(argv[++arg]);
+        else if (std::strcmp(argv[arg], "--shards") == 0 && arg + 1 < argc) {
+            shard_counts.clear();
+            std::stringstream list(argv[++arg]);
+            std::string count;
+            while (std::getline(list, count, ','))
+                shard_counts.push_back(std::strtoull(count.c_str(), nullptr, 10));
+        }
+    }
+
+    // Command stream, generated once so the producer only copies
+    const TickSize tick_size{};
+    const Price mid = tick_size.to_ticks(100.0);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<SymbolId> symbol_dist(0, static_cast<SymbolId>(num_symbols - 1));
+    std::uniform_int_distribution<int> action_dist(0, 9);
+    std::uniform_int_distribution<int> side_dist(0, 1);
+    std::uniform_int_distribution<int> qty_dist(100, 1000);
+    std::normal_distribution<double> offset_dist(0.0, 10.0);
+    std::vector<std::vector<OrderId>> symbol_orders(num_symbols);
+    std::vector<OrderCommand> commands(num_commands);
+    OrderId id = 0;
+    for (auto& command : commands) {
+        command.symbol_ = symbol_dist(rng);
+        command.side_ = side_dist(rng) ? OrderSide::Buy : OrderSide::Sell;
+        auto& issued = symbol_orders[command.symbol_];
+        int action = action_dist(rng);
+        if (action < 3 && !issued.empty()) {
+            command.command_ = CommandType::Cancel;
+            command.order_id_ = issued[std::uniform_int_distribution<std::size_t>(0, issued.size() - 1)(rng)];
+        } else if (action == 9) {
+            command.order_id_ = ++id;
+            command.order_type_ = OrderType::Market;
+            command.quantity_ = qty_dist(rng);
+        } else {
+            command.order_id_ = ++id;
+            // Resting side of mid, with a tail that crosses
+            Price offset = 2 + static_cast<Price>(offset_dist(rng));
+            command.price_ = command.side_ == OrderSide::Buy ? mid - offset : mid + offset;
+            command.quantity_ = qty_dist(rng);
+            issued.push_back(command.order_id_);
+        }
+    }
+
+    std::vector<SymbolId> symbols(num_symbols);
+    for (std::size_t symbol = 0; symbol < num_symbols; ++symbol)
+        symbols[symbol] = static_cast<SymbolId>(symbol);
+
+    // Producer, consumer and shard threads all spin; yield when they cannot
+    // each have a core
+    double first_rate = 0;
+    for (auto shards : shard_counts) {
+        const bool oversubscribed = std::thread::hardware_concurrency() < shards + 2;
+        auto relax = [oversubscribed]() {
+            if (oversubscribed)
+                std::this_thread::yield();
+        };
+
+        OrderBookManagerConfig config;
+        config.symbols_ = symbols;
+        config.shards_ = shards;
+        for (std::size_t shard = 0; first_core >= 0 && shard < shards; ++shard)
+            config.cores_.push_back(first_core + static_cast<int>(shard));
+        config.shard_.book_.tick_size_ = tick_size;
+        config.shard_.book_.expected_orders_ = 4096;
+        config.shard_.order_pool_slots_ = num_commands / shards + 1024;
+        OrderBookManager manager(config);
+
+        uint64_t start_t = get_time_nanoseconds();
+        std::thread consumer([&]() {
+            std::size_t done = 0;
+            EngineEvent event;
+            while (done < commands.size()) {
+                bool idle = true;
+                for (std::size_t shard = 0; shard < manager.shard_count(); ++shard) {
+                    while (manager.try_poll(shard, event)) {
+                        done += event.kind_ != EngineEvent::Kind::Trade;
+                        idle = false;
+                    }
+                }
+                if (idle)
+                    relax();
+            }
+        });
+        for (const auto& command : commands) {
+            while (!manager.try_submit(command))
+                relax();
+        }
+        consumer.join();
+        uint64_t elapsed_t = get_time_nanoseconds() - start_t;
+
+        double rate = commands.size() * 1e9 / elapsed_t;
+        if (first_rate == 0)
+            first_rate = rate;
+        cout << endl << shards << " shard(s), " << num_symbols << " symbols: "
+             << commands.size() << " commands in " << elapsed_t / 1'000'000 << " ms, "
+             << rate << " commands/sec, " << rate / first_rate << "x" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include "include/MarketByOrderBook.hpp"
+
+MarketByOrderBook::MarketByOrderBook(std::size_t expected_orders) : pool_(expected_orders) {
+  orders_.reserve(expected_orders);
+}
+
+MarketByOrderBook::~MarketByOrderBook() {
+  for (auto &[id, order] : orders_)
+    pool_.deallocate(order);
+}
+
+bool MarketByOrderBook::apply(const OrderEvent &event) {
+  bool in_sequence = event.sequence_ == sequence_ + 1;
+  sequence_ = event.sequence_;
+
+  switch (event.kind_) {
+  case OrderEventKind::Added:
+    if (orders_.contains(event.order_id_))
+      return false;
+    if (event.side_ == OrderSide::Buy)
+      add(bids_, event);
+    else
+      add(asks_, event);
+    return in_sequence;
+  case OrderEventKind::Executed:
+  case OrderEventKind::Reduced:
+    return take(event, event.quantity_) && in_sequence;
+  case OrderEventKind::Deleted:
+    return take(event, leaves(event.order_id_)) && in_sequence;
+  }
+  return false;
+}
+
+template <typename Levels> void MarketByOrderBook::add(Levels &levels, const OrderEvent &event) {
+  auto *order = pool_.allocate_emplace(event.order_id_, event.side_, event.price_, event.quantity_);
+  auto &level = levels[event.price_];
+  level.queue_.push_back(order);
+  level.quantity_ += event.quantity_;
+  orders_.emplace(event.order_id_, order);
+}
+
+bool MarketByOrderBook::take(const OrderEvent &event, Quantity quantity) {
+  auto it = orders_.find(event.order_id_);
+  if (it == orders_.end())
+    return false;
+  auto *order = it->second;
+  // Executed carries the trade price; the order rests where it was added
+  order->leaves_ = event.kind_ == OrderEventKind::Deleted ? 0 : event.leaves_;
+  if (order->side_ == OrderSide::Buy)
+    take(bids_, order, quantity);
+  else
+    take(asks_, order, quantity);
+  return true;
+}
+
+template <typename Levels>
+void MarketByOrderBook::take(Levels &levels, Resting *order, Quantity quantity) {
+  auto level = levels.find(order->price_);
+  level->second.quantity_ -= quantity;
+  if (order->leaves_ != 0)
+    return;
+  level->second.queue_.erase(order);
+  if (level->second.queue_.empty())
+    levels.erase(level);
+  orders_.erase(order->id_);
+  pool_.deallocate(order);
+}
+
+LevelsInfo MarketByOrderBook::get_order_book() const {
+  LevelsInfo levels;
+  for (const auto &[price, level] : bids_)
+    levels.buy_levels_.emplace_hint(levels.buy_levels_.end(), price,
+                                    LevelInfo{price, level.quantity_, static_cast<int>(level.queue_.size())});
+  for (const auto &[price, level] : asks_)
+    levels.sell_levels_.emplace_hint(levels.sell_levels_.end(), price,
+                                     LevelInfo{price, level.quantity_, static_cast<int>(level.queue_.size())});
+  return levels;
+}
+
+std::ptrdiff_t MarketByOrderBook::queue_position(OrderId id) const {
+  auto it = orders_.find(id);
+  if (it == orders_.end())
+    return -1;
+  auto *order = it->second;
+  std::ptrdiff_t ahead = 0;
+  auto count = [&](const auto &levels) {
+    const auto &queue = levels.find(order->price_)->second.queue_;
+    for (auto *resting = queue.front(); resting != order; resting = queue.next(resting))
+      ++ahead;
+  };
+  if (order->side_ == OrderSide::Buy)
+    count(bids_);
+  else
+    count(asks_);
+  return ahead;
+}
+
+Quantity MarketByOrderBook::leaves(OrderId id) const {
+  auto it = orders_.find(id);
+  return it == orders_.end() ? 0 : it->second->leaves_;
+}
@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "include/OrderBook.hpp"
+#include "include/PooledShared.hpp"
+#include "include/TickSize.hpp"
+
+using namespace std;
+
+// Bulk cancels against the same orders cancelled one cancel_order call at a
+// time. Each case fills a fresh book of --orders resting orders around a
+// 125.00 mid, --cancel of which are the target, then times the one call that
+// removes them and, on an identical book, the per-order loop, which cancels
+// in id order. Orders are entered in shuffled id order, so that, as in a book
+// that has seen some churn, neither the ids nor the levels walk the pool in
+// address order.
+//
+//   mass_cancel_perf [--orders N] [--cancel N] [--participants N] [--ladder] [--direct-index]
+//                    [--level-deltas]
+//
+// 1. Participant: the target orders belong to one of --participants sessions
+//    (cancel on disconnect), interleaved with everyone else's.
+// 2. Side: every bid, --cancel of them.
+// 3. Price range: the bids nearest the mid, holding about --cancel orders.
+
+uint64_t get_time_nanoseconds() {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+}
+
+struct Resting {
+    OrderSide side_;
+    Price price_;
+    ParticipantId participant_;
+};
+
+int main(int argc, char** argv) {
+    const TickSize tick_size{};
+    OrderBookConfig config{.tick_size_ = tick_size};
+    size_t num_orders = 1'000'000;
+    size_t num_cancel = 100'000;
+    uint32_t participants = 10;
+    for (int arg = 1; arg < argc; ++arg) {
+        if (std::strcmp(argv[arg], "--orders") == 0 && arg + 1 < argc)
+            num_orders = std::strtoull(argv[++arg], nullptr, 10);
+        else if (std::strcmp(argv[arg], "--cancel") == 0 && arg + 1 < argc)
+            num_cancel = std::strtoull(argv[++arg], nullptr, 10);
+        else if (std::strcmp(argv[arg], "--participants") == 0 && arg + 1 < argc)
+            participants = std::max<uint32_t>(2, std::strtoul(argv[++arg], nullptr, 10));
+        else if (std::strcmp(argv[arg], "--direct-index") == 0) {
+            config.order_index_mode_ = OrderIndexMode::Direct;
+            config.order_index_base_id_ = 1;
+        } else if (std::strcmp(argv[arg], "--level-deltas") == 0)
+            config.level_delta_capacity_ = 1 << 20;
+        else if (std::strcmp(argv[arg], "--ladder") == 0) {
+            config.ladder_base_price_ = tick_size.to_ticks(20.0);
+            config.ladder_levels_ = 21'000;
+        }
+    }
+    num_cancel = std::min(num_cancel, num_orders / 2);
+    config.expected_orders_ = num_orders;
+
+    const Price mid = tick_size.to_ticks(125.0);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> offset_dist(1, 2'500);
+    std::uniform_int_distribution<uint32_t> participant_dist(2, participants);
+    vector<size_t> entry_order(num_orders);
+    for (size_t i = 0; i < num_orders; ++i)
+        entry_order[i] = i;
+    std::shuffle(entry_order.begin(), entry_order.end(), rng);
+
+    auto run = [&](const char* name, const vector<Resting>& resting, auto&& bulk, auto&& is_target) {
+        vector<OrderId> targets;
+        for (size_t i = 0; i < resting.size(); ++i)
+            if (is_target(resting[i]))
+                targets.push_back(static_cast<OrderId>(i + 1));
+        auto fill = [&](OrderBook& book, MemoryPool<Order>& pool) {
+            for (auto i : entry_order)
+                book.add_order(make_intrusive_pooled_order(&pool, OrderType::GoodTillCancel, resting[i].side_,
+                                                           static_cast<OrderId>(i + 1), resting[i].price_, 100),
+                               [](const TradeInfo&) {}, 0, resting[i].participant_);
+        };
+
+        uint64_t bulk_t = 0;
+        size_t cancelled = 0;
+        {
+            MemoryPool<Order> pool(resting.size());
+            OrderBook book(config);
+            fill(book, pool);
+            const uint64_t start_t = get_time_nanoseconds();
+            cancelled = bulk(book);
+            bulk_t = get_time_nanoseconds() - start_t;
+        }
+        uint64_t loop_t = 0;
+        {
+            MemoryPool<Order> pool(resting.size());
+            OrderBook book(config);
+            fill(book, pool);
+            const uint64_t start_t = get_time_nanoseconds();
+            for (auto id : targets)
+                book.cancel_order(id);
+            loop_t = get_time_nanoseconds() - start_t;
+        }
+        cout << endl << name << ": " << cancelled << " of " << resting.size() << " orders" << endl;
+        cout << "one call: " << bulk_t / 1e6 << " ms (" << static_cast<double>(bulk_t) / max<size_t>(cancelled, 1)
+             << " ns/order)" << endl;
+        cout << "cancel_order per order: " << loop_t / 1e6 << " ms ("
+             << static_cast<double>(loop_t) / max<size_t>(targets.size(), 1) << " ns/order), "
+             << static_cast<double>(loop_t) / max<uint64_t>(bulk_t, 1) << "x slower" << endl;
+    };
+
+    {
+        // Participant 1 every num_orders / num_cancel orders, on both sides;
+        // the rest spread over the others
+        const size_t stride = num_orders / max<size_t>(num_cancel, 1);
+        vector<Resting> resting(num_orders);
+        for (size_t i = 0; i < num_orders; ++i) {
+            const auto side = i % 2 ? OrderSide::Buy : OrderSide::Sell;
+            const Price offset = offset_dist(rng);
+            resting[i] = {side, side == OrderSide::Buy ? mid - offset : mid + offset,
+                          i % stride == 0 ? 1u : participant_dist(rng)};
+        }
+        run("Participant", resting, [](OrderBook& book) { return book.mass_cancel(ParticipantId{1}); },
+            [](const Resting& order) { return order.participant_ == 1; });
+    }
+
+    {
+        // num_cancel bids under the rest of the book on the ask side
+        vector<Resting> resting(num_orders);
+        for (size_t i = 0; i < num_orders; ++i) {
+            const auto side = i < num_cancel ? OrderSide::Buy : OrderSide::Sell;
+            const Price offset = offset_dist(rng);
+            resting[i] = {side, side == OrderSide::Buy ? mid - offset : mid + offset, participant_dist(rng)};
+        }
+        run("Side", resting, [](OrderBook& book) { return book.mass_cancel(OrderSide::Buy); },
+            [](const Resting& order) { return order.side_ == OrderSide::Buy; });
+    }
+
+    {
+        // Bids spread evenly over the 2,500 ticks under the mid: the range
+        // nearest the mid holding num_cancel of them
+        vector<Resting> resting(num_orders);
+        for (size_t i = 0; i < num_orders; ++i) {
+            const auto side = i % 2 ? OrderSide::Buy : OrderSide::Sell;
+            const Price offset = offset_dist(rng);
+            resting[i] = {side, side == OrderSide::Buy ? mid - offset : mid + offset, participant_dist(rng)};
+        }
+        const Price ticks = static_cast<Price>(2'500 * num_cancel / max<size_t>(num_orders / 2, 1));
+        const Price low = mid - ticks;
+        run("Price range", resting, [&](OrderBook& book) { return book.mass_cancel(OrderSide::Buy, low, mid); },
+            [&](const Resting& order) { return order.side_ == OrderSide::Buy && order.price_ >= low; });
+    }
+    return 0;
+}
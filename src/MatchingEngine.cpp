@@ -0,0 +1,189 @@
+#include "include/MatchingEngine.hpp"
+#include "include/ModifyOrder.hpp"
+#include "include/PooledShared.hpp"
+#include <pthread.h>
+#include <sched.h>
+
+namespace {
+
+OrderBookConfig single_writer(OrderBookConfig config) {
+  config.single_writer_ = true;
+  return config;
+}
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+// Commands drained between housekeeping checks (clock, GFD cutoff, stop flag)
+constexpr std::size_t BurstSize = 256;
+// Empty polls spun before yielding the core, for hosts where the producer
+// shares it with the matching thread
+constexpr int SpinsBeforeYield = 1024;
+
+} // namespace
+
+MatchingEngine::MatchingEngine(MatchingEngineConfig config)
+    : config_(config),
+      order_pool_(config_.order_pool_slots_),
+      ingress_(config_.ingress_capacity_),
+      egress_(config_.egress_capacity_),
+      good_for_day_cutoff_(next_good_for_day_cutoff(session_now())) {
+  order_pool_.reserve_slots(config_.order_pool_slots_);
+  if (config_.book_.prefault_)
+    order_pool_.prefault();
+  auto book_config = single_writer(config_.book_);
+  books_.reserve(config_.symbols_.size());
+  for (auto symbol : config_.symbols_) {
+    book_config.symbol_ = symbol; // stamped on journal records
+    books_.try_emplace(symbol, std::make_unique<OrderBook>(book_config));
+  }
+  thread_ = std::thread{[this]() { run(); }};
+}
+
+MatchingEngine::~MatchingEngine() {
+  stop_.store(true, std::memory_order_release);
+  thread_.join();
+}
+
+void MatchingEngine::run() {
+#ifdef __linux__
+  if (config_.core_ >= 0) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(config_.core_, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  }
+#endif
+
+  OrderCommand command;
+  int idle_spins = 0;
+  while (true) {
+    std::size_t drained = 0;
+    while (drained < BurstSize && ingress_.try_pop(command)) {
+      process(command);
+      ++drained;
+    }
+    if (drained != 0) {
+      processed_.fetch_add(drained, std::memory_order_release);
+      idle_spins = 0;
+    } else {
+      // Only stop once the ring is drained, so every submitted command is answered
+      if (stop_.load(std::memory_order_acquire))
+        return;
+      if (++idle_spins < SpinsBeforeYield) {
+        cpu_relax();
+      } else {
+        idle_spins = 0;
+        std::this_thread::yield();
+      }
+    }
+
+    const auto now = session_now();
+    if (!config_.replayed_time_) {
+      const auto time = static_cast<Timestamp>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count());
+      // After a burst, or when idle once the wheel has moved on a tick; an idle
+      // spin within the same tick has nothing to expire
+      const auto tick = time / static_cast<std::uint64_t>(config_.book_.timer_resolution_.count());
+      if (drained != 0 || tick != time_tick_) {
+        time_tick_ = tick;
+        for (auto &[symbol, book] : books_)
+          book->advance_time(time);
+      }
+    }
+    if (now >= good_for_day_cutoff_) [[unlikely]] {
+      for (auto &[symbol, book] : books_)
+        book->begin_good_for_day_expiry();
+      expiring_good_for_day_ = true;
+      good_for_day_cutoff_ = next_good_for_day_cutoff(now + std::chrono::seconds(1));
+    }
+    if (expiring_good_for_day_) [[unlikely]] {
+      // One chunk per book between bursts, so commands keep flowing meanwhile
+      bool pending = false;
+      for (auto &[symbol, book] : books_)
+        pending |= book->expire_good_for_day(config_.book_.good_for_day_expiry_chunk_);
+      expiring_good_for_day_ = pending;
+    }
+  }
+}
+
+OrderBook *MatchingEngine::find_book(SymbolId symbol) {
+  // Flow for one symbol tends to come in runs
+  if (last_book_ != nullptr && symbol == last_symbol_) [[likely]]
+    return last_book_;
+  auto it = books_.find(symbol);
+  if (it == books_.end())
+    return nullptr;
+  last_symbol_ = symbol;
+  last_book_ = it->second.get();
+  return last_book_;
+}
+
+void MatchingEngine::process(const OrderCommand &command) {
+  auto *book = find_book(command.symbol_);
+  if (book == nullptr) [[unlikely]] {
+    emit(EngineEvent{EngineEvent::Kind::Rejected, command.tag_, command.symbol_, command.order_id_});
+    return;
+  }
+
+  // Fills go straight onto the egress ring; nothing is buffered per command
+  EngineEvent event;
+  event.tag_ = command.tag_;
+  event.symbol_ = command.symbol_;
+  event.order_id_ = command.order_id_;
+  event.kind_ = EngineEvent::Kind::Trade;
+  auto on_trade = [this, &event](const TradeInfo &trade) {
+    event.buy_order_id_ = trade.get_buy().id_;
+    event.sell_order_id_ = trade.get_sell().id_;
+    event.price_ = trade.get_trade_price();
+    event.quantity_ = trade.get_quantity();
+    emit(event);
+  };
+  switch (command.command_) {
+  case CommandType::Add:
+    book->add_order(make_intrusive_pooled_order(
+                        &order_pool_, command.order_type_, command.side_, command.order_id_,
+                        command.price_, command.quantity_),
+                    on_trade, command.timestamp_, command.participant_);
+    break;
+  case CommandType::Cancel:
+    book->cancel_order(command.order_id_);
+    break;
+  case CommandType::MassCancel:
+    if (command.participant_ != 0)
+      book->mass_cancel(command.participant_);
+    else
+      book->mass_cancel(command.side_);
+    break;
+  case CommandType::Modify:
+    book->modify_order(OrderModify(&order_pool_, command.order_type_, command.side_,
+                                   command.order_id_, command.price_, command.quantity_),
+                       on_trade, command.timestamp_);
+    break;
+  case CommandType::AdvanceTime:
+    book->advance_time(command.timestamp_);
+    break;
+  }
+  emit(EngineEvent{EngineEvent::Kind::Done, command.tag_, command.symbol_, command.order_id_});
+}
+
+void MatchingEngine::emit(const EngineEvent &event) {
+  // Back-pressure: wait for the consumer, unless we are shutting down and it
+  // may already have stopped polling
+  int spins = 0;
+  while (!egress_.try_push(event)) {
+    if (stop_.load(std::memory_order_acquire))
+      return;
+    if (++spins < SpinsBeforeYield) {
+      cpu_relax();
+    } else {
+      spins = 0;
+      std::this_thread::yield();
+    }
+  }
+}
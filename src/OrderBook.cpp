@@ -7,7 +7,11 @@
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cstring>
+#include <limits>
 #include <mutex>
+#include <stdexcept>
+#include <thread>
 
 
 static inline uint64_t get_time_nanoseconds() {
@@ -16,193 +20,527 @@ static inline uint64_t get_time_nanoseconds() {
   return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
 }
 
-OrderBook::OrderBook()
-    : ordersPruneThread_{[this]() { PruneGoodForDayOrders(); }}, pool(std::make_shared<MemoryPool<ListNode<OrderPointer>>>(3000000)) {
-  std::cout << "Order Book Initialized, has 0 orders currently" << std::endl;
-  // Pre-size for ~3,000,000 orders to avoid rehash spikes
-  orders_.max_load_factor(0.7f);
-  orders_.reserve(3000000);
+OrderBook::OrderBook(OrderBookConfig config)
+    : config_(config),
+      level_memory_(config_.expected_levels_, config_.growth_policy_ == GrowthPolicy::Reserve,
+                    config_.prefault_),
+      bids_(config_.ladder_base_price_, config_.ladder_levels_, config_.ladder_depth_index_,
+            level_memory_.resource()),
+      asks_(config_.ladder_base_price_, config_.ladder_levels_, config_.ladder_depth_index_,
+            level_memory_.resource()),
+      orders_(config_.order_index_mode_, config_.order_index_base_id_,
+              config_.growth_policy_ == GrowthPolicy::Reserve ? config_.expected_orders_ : 0),
+      snapshot_(config_.snapshot_depth_),
+      level_deltas_(config_.level_delta_capacity_),
+      order_events_(config_.order_event_capacity_) {}
+
+std::chrono::system_clock::time_point
+next_good_for_day_cutoff(std::chrono::system_clock::time_point now) {
+  using namespace std::chrono;
+  const auto end = hours(16);
+
+  const auto now_c = system_clock::to_time_t(now);
+  std::tm now_parts;
+  localtime_r(&now_c, &now_parts);
+
+  if (now_parts.tm_hour >= end.count())
+    now_parts.tm_mday += 1;
+
+  now_parts.tm_hour = end.count();
+  now_parts.tm_min = 0;
+  now_parts.tm_sec = 0;
+  return system_clock::from_time_t(mktime(&now_parts));
 }
+
 void OrderBook::PruneGoodForDayOrders() {//have to test.
 
   using namespace std::chrono;
-  const auto end = hours(16);
 
   while (true) {
 
-    const auto now = system_clock::now();
-    const auto now_c = system_clock::to_time_t(now);
-    std::tm now_parts;
-    localtime_r(&now_c, &now_parts);
-
-    if (now_parts.tm_hour >= end.count())
-      now_parts.tm_mday += 1;
-
-    now_parts.tm_hour = end.count();
-    now_parts.tm_min = 0;
-    now_parts.tm_sec = 0;
-    auto next = system_clock::from_time_t(mktime(&now_parts));
-    auto till = next - now + milliseconds(100);
+    const auto now = session_now();
+    auto till = next_good_for_day_cutoff(now) - now + milliseconds(100);
 
     {
       std::unique_lock ordersLock{ordersMutex_};
-      if (shutdown_.load(std::memory_order_acquire) ||
-          shutdownConditionVariable_.wait_for(ordersLock, till) ==
-              std::cv_status::no_timeout)
+      if (shutdownConditionVariable_.wait_for(ordersLock, till, [this]() {
+            return shutdown_.load(std::memory_order_acquire);
+          }))
 
         /*
-          If shutdown_ atomic flag is set to true(during the destruction of the orderbook)
-          or if the thread wakes up from the condition Variable due to notify or Spurious?
-          Return from the function.
+          shutdown_ is set (under the lock, during the destruction of the
+          orderbook): return from the function.
 
           Else timeout has occured, process end of day.
         */
         return;
     }
 
-    OrderIds order_ids;
+    prune_good_for_day_orders();
+  }
+}
+
+void OrderBook::prune_good_for_day_orders() {
+  begin_good_for_day_expiry();
+  while (expire_good_for_day(config_.good_for_day_expiry_chunk_)) {
+    if (!config_.single_writer_)
+      std::this_thread::yield(); // let waiting callers in between chunks
+  }
+}
 
-    {
-      std::scoped_lock prunelock(ordersMutex_);
-      for(const auto& [_,entry]:orders_){
-          const auto & [orderptr , __] = entry;
-          if(orderptr->get_order_type() == OrderType::GoodForDay){
-            order_ids.push_back(orderptr->get_order_id());
-          }
-      }
-    }
+void OrderBook::begin_good_for_day_expiry() {
+  auto expiryLock = lock_book();
+  expiry_last_ = good_for_day_.back();
+  good_for_day_added_ = 0;
+}
 
-    cancel_orders_internal(order_ids);
+bool OrderBook::expire_good_for_day(std::size_t max_orders) {
+  auto expiryLock = lock_book();
+  std::size_t expired = 0;
+  while (expiry_last_ != nullptr && expired < max_orders) {
+    auto *order = good_for_day_.front();
+    const auto side = order->get_order_side();
+    auto &level = side == OrderSide::Buy ? *bids_.find(order->get_price())
+                                         : *asks_.find(order->get_price());
+    // Every order in the level is an expiring GoodForDay order: the level goes
+    // in one message with one level update, instead of shrinking chunk by
+    // chunk. Journaled: replay cannot know when the session ended.
+    if (good_for_day_added_ == 0 && static_cast<int>(level.good_for_day_) == level.count()) {
+      expired += side == OrderSide::Buy ? drop_level(bids_, level, true) : drop_level(asks_, level, true);
+    } else {
+      journal_command(CommandType::Cancel, order->get_order_id());
+      cancel_order_internal(order->get_order_id());
+      ++expired;
+    }
   }
+  end_message();
+  return expiry_last_ != nullptr;
+}
+
+std::size_t OrderBook::good_for_day_count() {
+  auto ordersLock = lock_book();
+  return good_for_day_.size();
+}
+
+std::size_t OrderBook::advance_time(Timestamp now) {
+  auto ordersLock = lock_book();
+  const auto expired = apply_advance_time(now);
+  if (expired != 0)
+    end_message();
+  return expired;
+}
+
+std::size_t OrderBook::apply_advance_time(Timestamp now) {
+  now_ = std::max(now_, now);
+  std::size_t expired = 0;
+  // Deadlines were rounded up, so the tick now falls in is the last one due
+  expiry_timers_.advance(now_ / config_.timer_resolution_.count(), [&](OrderId id) {
+    auto entry = good_till_date_.find(id);
+    if (entry == good_till_date_.end() || entry->second > now_)
+      return; // gone, or re-added with a later expiry
+    journal_command(CommandType::Cancel, id);
+    cancel_order_internal(id);
+    ++expired;
+  });
+  return expired;
+}
+
+Timestamp OrderBook::current_time() {
+  auto ordersLock = lock_book();
+  return now_;
+}
+
+std::size_t OrderBook::good_till_date_count() {
+  auto ordersLock = lock_book();
+  return good_till_date_.size();
 }
 
 TradeInfos OrderBook::add_order (OrderPointer order) {
-  std::scoped_lock ordersLock{ordersMutex_};
-  return add_order_internal(order);
+  TradeInfos trades;
+  add_order(std::move(order), trades);
+  return trades;
 }
 
-TradeInfos OrderBook::add_order_internal(OrderPointer order) {
+void OrderBook::add_order(OrderPointer order, TradeSink trades, Timestamp expiry,
+                          ParticipantId participant) {
+  auto ordersLock = lock_book();
+  add_order_internal(order, trades, true, expiry, participant);
+  end_message();
+}
+
+bool OrderBook::add_order_internal(const OrderPointer &order, TradeSink trades, bool journal,
+                                   Timestamp expiry, ParticipantId participant) {
   auto id = order->get_order_id();
   auto side = order->get_order_side();
   auto price = order->get_price();
 
-  if (orders_.find(id) != orders_.end()) [[unlikely]] {
-    return {};
+  if (orders_.contains(id)) [[unlikely]] {
+    return false;
   }
 
-  if ((order->get_order_type() == OrderType::FillAndKill &&
-      !can_match_order(side, price)))
-    return {};
+  if (!admits(order->get_order_type(), side, price, order->get_quantity(), expiry))
+    return false;
 
-  if (order->get_order_type() == OrderType::FillOrKill &&
-      !can_fully_match_order(side, price, order->get_quantity()))
-    return {};
+  if (journal)
+    journal_command(CommandType::Add, id, side, order->get_order_type(), price, order->get_quantity(),
+                    order->get_order_type() == OrderType::GoodTillDate ? expiry : 0, participant);
 
   if (order->get_order_type() == OrderType::Market) {
     order->market_normalize();
   }
-  price = order->get_price();
-  OrderPointers::iterator it;
-  if (side == OrderSide::Buy) {
-    auto it_level = bids_.find(price);
-    if (it_level == bids_.end()) {
-      it_level = bids_.emplace(price, OrderPointers(pool)).first;
-    }
-    auto &bids_list = it_level->second;
-    it = bids_list.emplace_back(order);
-  } else if (side == OrderSide::Sell) {
-    auto it_level = asks_.find(price);
-    if (it_level == asks_.end()) {
-      it_level = asks_.emplace(price, OrderPointers(pool)).first;
-    }
-    auto &asks_list = it_level->second;
-    it = asks_list.emplace_back(order);
+  if (never_rests(order->get_order_type())) {
+    sweep_order(*order, trades);
+    return true;
   }
-  orders_.try_emplace(id, OrderInfoByID{order, it});
-  OnOrderAdded(order);
+  // The book's reference is dropped by intrusive_ptr_release when the order
+  // leaves the book (fill or cancel)
+  Order *resting = order.get();
+  intrusive_ptr_add_ref(resting);
+  orders_.insert(id, resting);
+  if (participant != 0)
+    track_participant(id, participant);
+  queue_order(resting, expiry);
+
+  match_orders(trades);
+  return true;
+}
 
-  const auto & trades_made=match_orders();
-  return trades_made;
+bool OrderBook::admits(OrderType type, OrderSide side, Price price, Quantity quantity, Timestamp expiry) {
+  if (type == OrderType::FillAndKill)
+    return can_match_order(side, price);
+  if (type == OrderType::FillOrKill)
+    return can_fully_match_order(side, price, quantity);
+  if (type == OrderType::GoodTillDate)
+    return expiry > now_;
+  return true;
+}
+
+void OrderBook::queue_order(Order *order, Timestamp expiry) {
+  const auto side = order->get_order_side();
+  const auto price = order->get_price();
+  auto &level = side == OrderSide::Buy ? bids_.find_or_create(price)
+                                       : asks_.find_or_create(price);
+  level.orders_.push_back(order);
+  // Books that never see a GoodForDay order never pay for the prune thread
+  if (order->get_order_type() == OrderType::GoodForDay) {
+    link_good_for_day(level, order);
+  } else if (order->get_order_type() == OrderType::GoodTillDate) {
+    good_till_date_.insert_or_assign(order->get_order_id(), expiry);
+    expiry_timers_.schedule(expiry_tick(expiry), order->get_order_id());
+  }
+  OnOrderAdded(level, order->get_quantity(), side);
+  emit_order_event(OrderEventKind::Added, *order, price, order->get_quantity(),
+                   order->get_quantity());
 }
 
 void OrderBook::cancel_order(OrderId id) {
-  std::scoped_lock ordersLock{ordersMutex_};
-  if (orders_.find(id) == orders_.end())
-    return;
+  auto ordersLock = lock_book();
+  if (apply_cancel(id))
+    end_message();
+}
+
+bool OrderBook::apply_cancel(OrderId id) {
+  if (!orders_.contains(id))
+    return false;
+  journal_command(CommandType::Cancel, id);
   cancel_order_internal(id);
+  return true;
 }
 
-LevelsInfo OrderBook::get_order_book() { return levels; }
+std::size_t OrderBook::mass_cancel(OrderSide side) {
+  auto ordersLock = lock_book();
+  const auto cancelled = apply_mass_cancel(side);
+  end_message();
+  return cancelled;
+}
 
-std::size_t OrderBook::Size() { return orders_.size(); }
+std::size_t OrderBook::apply_mass_cancel(OrderSide side) {
+  journal_command(CommandType::MassCancel, 0, side);
+  auto drop_all = [this](auto &ladder) {
+    std::size_t cancelled = 0;
+    while (auto *level = ladder.best())
+      cancelled += drop_level(ladder, *level, false);
+    return cancelled;
+  };
+  return side == OrderSide::Buy ? drop_all(bids_) : drop_all(asks_);
+}
 
-TradeInfos OrderBook::modify_order(OrderModify modify_request) {
-  std::scoped_lock modifyorder(ordersMutex_);
+std::size_t OrderBook::mass_cancel(OrderSide side, Price low, Price high) {
+  auto ordersLock = lock_book();
+  // From the level nearest the top of book inward, stopping past the range
+  auto drop_range = [this](auto &ladder, Price from, Price to) {
+    std::size_t cancelled = 0;
+    auto *level = ladder.first_at_or_worse(from);
+    while (level != nullptr && !ladder.better(to, level->price_)) {
+      auto *next = ladder.next(*level);
+      cancelled += drop_level(ladder, *level, true);
+      level = next;
+    }
+    return cancelled;
+  };
+  const auto cancelled = low > high                  ? 0
+                         : side == OrderSide::Buy ? drop_range(bids_, high, low)
+                                                  : drop_range(asks_, low, high);
+  end_message();
+  return cancelled;
+}
 
-  auto id = modify_request.get_order_id();
-  if (orders_.find(id) == orders_.end()) {
-    return {};
+std::size_t OrderBook::mass_cancel(ParticipantId participant) {
+  auto ordersLock = lock_book();
+  const auto cancelled = apply_mass_cancel(participant);
+  end_message();
+  return cancelled;
+}
+
+std::size_t OrderBook::apply_mass_cancel(ParticipantId participant) {
+  auto entry = participant_orders_.find(participant);
+  if (entry == participant_orders_.end() || entry->second.empty())
+    return 0;
+  // Detached from the participant first, so erase_order finds nothing left
+  // to untrack
+  auto &ids = participant_orders_[participant];
+  cancel_scratch_.clear();
+  for (auto id : ids) {
+    cancel_scratch_.push_back(orders_.find(id));
+    participant_slots_.erase(id);
   }
+  ids.clear();
+
+  // Orders a session entered one after the other at one price sit next to
+  // each other in its array: each such run costs one level lookup and one
+  // level update, and empties its level in one step if it is all the level
+  // holds
+  const std::span<Order *const> orders(cancel_scratch_);
+  for (std::size_t begin = 0; begin < orders.size();) {
+    const auto side = orders[begin]->get_order_side();
+    const auto price = orders[begin]->get_price();
+    auto end = begin + 1;
+    while (end < orders.size() && orders[end]->get_price() == price && orders[end]->get_order_side() == side)
+      ++end;
+    if (side == OrderSide::Buy)
+      cancel_on_level(bids_, *bids_.find(price), orders.subspan(begin, end - begin));
+    else
+      cancel_on_level(asks_, *asks_.find(price), orders.subspan(begin, end - begin));
+    begin = end;
+  }
+  return orders.size();
+}
 
-  // Cancel the existing order
-  cancel_order_internal(id);
+std::size_t OrderBook::participant_order_count(ParticipantId participant) {
+  auto ordersLock = lock_book();
+  auto entry = participant_orders_.find(participant);
+  return entry == participant_orders_.end() ? 0 : entry->second.size();
+}
 
-  // Add the modified order
-  return add_order_internal(modify_request.to_order_ptr());
+template <OrderSide Side>
+std::size_t OrderBook::drop_level(PriceLadder<Side> &ladder, PriceLevel &level, bool journal) {
+  const auto count = level.orders_.size();
+  mark_level(level, Side, level.count());
+  ladder.add_quantity(level, -level.quantity_);
+  // Walked rather than unlinked one by one: the queue is emptied at the end
+  for (auto *order = level.orders_.front(); order != nullptr;) {
+    auto *next = OrderPointers::next(order);
+    if (next != nullptr)
+      __builtin_prefetch(next);
+    const auto id = order->get_order_id();
+    if (journal)
+      journal_command(CommandType::Cancel, id);
+    emit_order_event(OrderEventKind::Deleted, *order, level.price_, order->get_quantity(), 0);
+    untrack_expiry(level, order);
+    erase_order(id);
+    intrusive_ptr_release(order);
+    order = next;
+  }
+  level.orders_.clear();
+  ladder.erase(level);
+  return count;
 }
 
-void OrderBook::OnOrderCancelled(Price price, Quantity quantity, OrderSide side) {
-  UpdateLevelData(price, quantity, side, Action::Remove);
+template <OrderSide Side>
+void OrderBook::cancel_on_level(PriceLadder<Side> &ladder, PriceLevel &level, std::span<Order *const> orders) {
+  if (static_cast<int>(orders.size()) == level.count()) {
+    drop_level(ladder, level, true);
+    return;
+  }
+  mark_level(level, Side, level.count());
+  Quantity quantity = 0;
+  for (auto *order : orders) {
+    const auto id = order->get_order_id();
+    journal_command(CommandType::Cancel, id);
+    emit_order_event(OrderEventKind::Deleted, *order, level.price_, order->get_quantity(), 0);
+    quantity += order->get_quantity();
+    untrack_expiry(level, order);
+    level.orders_.erase(order);
+    erase_order(id);
+    intrusive_ptr_release(order);
+  }
+  ladder.add_quantity(level, -quantity);
 }
 
-void OrderBook::OnOrderAdded(OrderPointer order) {
-  UpdateLevelData(order->get_price(), order->get_quantity(),
-                  order->get_order_side(), Action::Add);
+LevelsInfo OrderBook::get_order_book() {
+  // Built on demand from the levels themselves, best to worst on each side
+  auto ordersLock = lock_book();
+  LevelsInfo levels;
+  for (auto *level = bids_.best(); level != nullptr; level = bids_.next(*level)) {
+    levels.buy_levels_.emplace_hint(levels.buy_levels_.end(), level->price_, level->info());
+  }
+  for (auto *level = asks_.best(); level != nullptr; level = asks_.next(*level)) {
+    levels.sell_levels_.emplace_hint(levels.sell_levels_.end(), level->price_, level->info());
+  }
+  return levels;
 }
 
-void OrderBook::OnOrderMatched(Price price, Quantity quantity, OrderSide side) {
-  UpdateLevelData(price, quantity, side, Action::Match);
+std::size_t OrderBook::Size() { return orders_.size(); }
+
+TradeInfos OrderBook::modify_order(OrderModify modify_request) {
+  TradeInfos trades;
+  modify_order(modify_request, trades);
+  return trades;
 }
 
-void OrderBook::UpdateLevelData(Price price, Quantity quantity, OrderSide side,
-                                Action action) {
-  auto &buy_side = levels.buy_levels_;
-  auto &sell_side = levels.sell_levels_;
-  //   auto &data_side = (side == OrderSide::Buy) ? *buy_side : *sell_side;
-  // if (side == OrderSide::Buy and action!=Action::Add and buy_side.find(price) == buy_side.end()) {
-  //   return;
-  // }
-  // if (side == OrderSide::Sell and action!=Action::Add and sell_side.find(price) == sell_side.end()) {
-  //   return;
-  // }
-  auto &data = (side == OrderSide::Buy) ? buy_side[price] : sell_side[price];
+void OrderBook::modify_order(OrderModify modify_request, TradeSink trades, Timestamp expiry) {
+  auto modifyorder = lock_book();
+  if (apply_modify(modify_request, trades, expiry))
+    end_message();
+}
 
-  data.price_ = price;
-  data.count_ += action == Action::Remove ? -1 : action == Action::Add ? 1 : 0;
-  if (action == Action::Remove || action == Action::Match) {
-    data.quantity_ -= quantity;
-  } else {
-    data.quantity_ += quantity;
-  }
-  if (side == OrderSide::Buy and data.count_ == 0) {
-    buy_side.erase(price);
+bool OrderBook::apply_modify(OrderModify &modify_request, TradeSink trades, Timestamp expiry) {
+  auto id = modify_request.get_order_id();
+  auto *order = orders_.find(id);
+  if (order == nullptr) {
+    return false;
   }
-  if (side == OrderSide::Sell and data.count_ == 0) {
-    sell_side.erase(price);
+  const auto type = modify_request.get_order_type();
+  const auto side = modify_request.get_order_side();
+  const auto price = modify_request.get_price();
+  const auto quantity = modify_request.get_quantity();
+
+  Timestamp current_expiry = 0;
+  if (order->get_order_type() == OrderType::GoodTillDate)
+    current_expiry = good_till_date_.find(id)->second;
+  if (type != OrderType::GoodTillDate)
+    expiry = 0;
+  else if (expiry == 0)
+    expiry = current_expiry;
+
+  journal_command(CommandType::Modify, id, side, type, price, quantity, expiry);
+
+  // Same price, side, type and expiry, and smaller: cut in place, keeping
+  // the order's place in the queue. The same quantity changes nothing, so
+  // nothing is published for it.
+  if (price == order->get_price() && side == order->get_order_side() &&
+      type == order->get_order_type() && expiry == current_expiry && quantity > 0 &&
+      quantity <= order->get_quantity()) {
+    if (quantity < order->get_quantity())
+      reduce_order(*order, quantity);
+    return true;
   }
 
+  // Anything else loses priority: the same Order is taken off its level and
+  // queued again as if newly added, without reallocating it
+  unlink_order(order);
+  if (!admits(type, side, price, quantity, expiry)) {
+    erase_order(id);
+    intrusive_ptr_release(order);
+    return true;
+  }
+  order->replace(type, side, price, quantity);
+  if (type == OrderType::Market)
+    order->market_normalize();
+  if (never_rests(type)) {
+    erase_order(id);
+    sweep_order(*order, trades);
+    intrusive_ptr_release(order);
+    return true;
+  }
+  queue_order(order, expiry);
+  match_orders(trades);
+  return true;
 }
 
-bool OrderBook::can_match() { // Returns 1 if OB is not saturated
-  if (bids_.size() == 0 || asks_.size() == 0) {
-    return false;
+void OrderBook::apply_batch(std::span<const OrderCommand> commands, MemoryPool<Order> &order_pool,
+                            std::span<CommandResult> results, TradeSink trades) {
+  if (results.size() < commands.size())
+    throw std::invalid_argument("apply_batch: " + std::to_string(commands.size()) + " commands but room for " +
+                                std::to_string(results.size()) + " results");
+  auto batchLock = lock_book();
+  for (std::size_t i = 0; i < commands.size(); ++i) {
+    const auto &command = commands[i];
+    auto &result = results[i];
+    result = CommandResult{};
+    auto on_trade = [&result, &trades](const TradeInfo &trade) {
+      ++result.trades_;
+      result.filled_ += trade.get_quantity();
+      trades(trade);
+    };
+    switch (command.command_) {
+    case CommandType::Add:
+      result.accepted_ = add_order_internal(
+          make_intrusive_pooled_order(&order_pool, command.order_type_, command.side_, command.order_id_,
+                                      command.price_, command.quantity_),
+          on_trade, true, command.timestamp_, command.participant_);
+      break;
+    case CommandType::Cancel:
+      result.accepted_ = apply_cancel(command.order_id_);
+      break;
+    case CommandType::Modify: {
+      OrderModify modify(&order_pool, command.order_type_, command.side_, command.order_id_, command.price_,
+                         command.quantity_);
+      result.accepted_ = apply_modify(modify, on_trade, command.timestamp_);
+      break;
+    }
+    case CommandType::MassCancel:
+      if (command.participant_ != 0)
+        apply_mass_cancel(command.participant_);
+      else
+        apply_mass_cancel(command.side_);
+      result.accepted_ = true;
+      break;
+    case CommandType::AdvanceTime:
+      apply_advance_time(command.timestamp_);
+      result.accepted_ = true;
+      break;
+    }
   }
-  auto &[buy_price, _] = *bids_.begin();
+  end_message();
+}
 
-  auto &[sell_price, __] = *asks_.begin();
+void OrderBook::reduce_order(Order &order, Quantity leaves) {
+  const auto side = order.get_order_side();
+  const auto price = order.get_price();
+  const auto cut = order.get_quantity() - leaves;
+  auto &level = side == OrderSide::Buy ? *bids_.find(price) : *asks_.find(price);
+  mark_level(level, side, level.count());
+  if (side == OrderSide::Buy)
+    bids_.add_quantity(level, -cut);
+  else
+    asks_.add_quantity(level, -cut);
+  order.reduce_quantity(leaves);
+  emit_order_event(OrderEventKind::Reduced, order, price, cut, leaves);
+}
 
+void OrderBook::OnOrderCancelled(PriceLevel &level, Quantity quantity, OrderSide side) {
+  mark_level(level, side, level.count());
+  if (side == OrderSide::Buy)
+    bids_.add_quantity(level, -quantity);
+  else
+    asks_.add_quantity(level, -quantity);
+}
 
-  return (buy_price >= sell_price);
+void OrderBook::OnOrderAdded(PriceLevel &level, Quantity quantity, OrderSide side) {
+  mark_level(level, side, level.count() - 1);
+  if (side == OrderSide::Buy)
+    bids_.add_quantity(level, quantity);
+  else
+    asks_.add_quantity(level, quantity);
+}
+
+void OrderBook::OnOrderMatched(PriceLevel &level, Quantity quantity, OrderSide side) {
+  mark_level(level, side, level.count());
+  if (side == OrderSide::Buy)
+    bids_.add_quantity(level, -quantity);
+  else
+    asks_.add_quantity(level, -quantity);
 }
 
 bool OrderBook::can_match_order(
@@ -210,19 +548,19 @@ bool OrderBook::can_match_order(
     Price price) { // Can a particular Order be matched- Used to
                    // check FillAndKIll orders before adding them
   if (side == OrderSide::Buy) {
-    if (asks_.size() == 0)
+    auto *best_ask = asks_.best();
+    if (best_ask == nullptr)
       return false;
-    auto &[sell_price, _] = *asks_.begin();
-    if (sell_price <= price)
+    if (best_ask->price_ <= price)
       return true;
     else
       return false;
 
   } else {
-    if (bids_.size() == 0)
+    auto *best_bid = bids_.best();
+    if (best_bid == nullptr)
       return false;
-    auto &[buy_price, _] = *bids_.begin();
-    if (buy_price >= price)
+    if (best_bid->price_ >= price)
       return true;
     else
       return false;
@@ -231,177 +569,394 @@ bool OrderBook::can_match_order(
 
 bool OrderBook::can_fully_match_order(OrderSide side, Price price,
                                       Quantity quantity) {
-  if (side == OrderSide::Buy) {
-    // check in sell side levels if this much quantity can be filled.
-    Quantity can_fill= 0;
-    auto &sell_levels = levels.sell_levels_;
-
-    for (auto [sell_price, levelinfo] : sell_levels) {
-      if (sell_price > price)
-        break;
-      can_fill += levelinfo.quantity_;
-      if (can_fill >= quantity)
-        return true;
-    }
-    if (can_fill >= quantity)
-      return true;
-    else
-      return false;
-  } else if (side == OrderSide::Sell) {
-    // check in buy side levels if this much quantity can be filled.
-    Quantity can_fill= 0;
-    auto &buy_levels = levels.buy_levels_;
-
-    for (auto [buy_price, levelinfo] : buy_levels) {
-      if (buy_price < price)
-        break;
-      can_fill += levelinfo.quantity_;
-      if (can_fill >= quantity)
-        return true;
-    }
-    if (can_fill >= quantity)
-      return true;
-    else
-      return false;
-  }
-
+  // check in the opposite side's levels if this much quantity can be filled.
+  if (side == OrderSide::Buy)
+    return asks_.depth_at_or_better(price, quantity) >= quantity;
   else
-    return false;
+    return bids_.depth_at_or_better(price, quantity) >= quantity;
 }
 
-TradeInfos OrderBook::match_orders() {
-  if (!can_match())
-  return TradeInfos{};
+std::int64_t OrderBook::available_liquidity(OrderSide side, Price limit_price) {
+  auto ordersLock = lock_book();
+  if (side == OrderSide::Buy)
+    return asks_.depth_at_or_better(limit_price);
+  else
+    return bids_.depth_at_or_better(limit_price);
+}
 
-TradeInfos trades_made;
-trades_made.trades_made_.reserve(10);
-while (true) {
-    if (bids_.size() == 0 || asks_.size() == 0) {
-        break;
-      }
-      
-      auto &bids_pair = *bids_.begin();
-      auto &asks_pair = *asks_.begin();
-      auto &bids_list = bids_pair.second;
-      auto &asks_list = asks_pair.second;
-      auto bid_it = bids_list.begin();
-      auto ask_it = asks_list.begin();
-  
-      auto &bid_order = **bid_it;
-      auto &ask_order = **ask_it;
-      
-      if(bids_pair.first < asks_pair.first)
+void OrderBook::match_orders(TradeSink trades_made) {
+  while (true) {
+    auto *bid_level = bids_.best();
+    auto *ask_level = asks_.best();
+    if (bid_level == nullptr || ask_level == nullptr || bid_level->price_ < ask_level->price_)
       break;
-    
-      Quantity trade_quantity =
-      std::min(bid_order.get_quantity(), ask_order.get_quantity());
-      
-      Price trade_price = ask_order.get_price();
-      if (ask_order.get_order_type() == OrderType::Market)
-      trade_price = bid_order.get_price();
-    
-      auto buy_order_id = bid_order.get_order_id();
-      auto sell_order_id = ask_order.get_order_id();
-      trades_made.emplace_back(
-        TradeInfo::SideInfoTrade{buy_order_id, bid_order.get_price()},
-        TradeInfo::SideInfoTrade{sell_order_id, ask_order.get_price()},
-        trade_price, trade_quantity);
-      
-      bid_order.fill_order(trade_quantity);
-      if (bid_order.is_filled()) {
-        // cancel_order_internal(buy_order_id, true);
-        bids_list.erase(bid_it);
-        if (bids_list.empty()) {
-          bids_.erase(bids_pair.first);
-        }
-        OnOrderCancelled(bids_pair.first, trade_quantity, OrderSide::Buy);
-        orders_.erase(buy_order_id);
-      }
-      else{// this won't bring down the level count.
-        OnOrderMatched(bids_pair.first, trade_quantity, OrderSide::Buy);
-        
-      }
-      
-      ask_order.fill_order(trade_quantity);
-      if (ask_order.is_filled()) {
-        // cancel_order_internal(sell_order_id, true);
-        asks_list.erase(ask_it);
-        if (asks_list.empty()) {
-          asks_.erase(asks_pair.first);
-        }
-        OnOrderCancelled(asks_pair.first, trade_quantity, OrderSide::Sell);
-        orders_.erase(sell_order_id);
-      }
-      else{// this won't bring down the level count.
-        OnOrderMatched(asks_pair.first, trade_quantity, OrderSide::Sell);
-      }
+    match_levels(*bid_level, *ask_level, trades_made);
+  }
+}
 
+void OrderBook::match_levels(PriceLevel &bid_level, PriceLevel &ask_level, TradeSink trades_made) {
+  // Both aggregates are marked on the way in and updated once on the way out,
+  // however many fills the two queues trade
+  mark_level(bid_level, OrderSide::Buy, bid_level.count());
+  mark_level(ask_level, OrderSide::Sell, ask_level.count());
+  const Price trade_price = ask_level.price_;
+  Quantity traded = 0;
+  auto *bid_order = bid_level.orders_.front();
+  auto *ask_order = ask_level.orders_.front();
+  while (bid_order != nullptr && ask_order != nullptr) {
+    const Quantity trade_quantity = std::min(bid_order->get_quantity(), ask_order->get_quantity());
+    const auto buy_order_id = bid_order->get_order_id();
+    const auto sell_order_id = ask_order->get_order_id();
+    const TradeInfo trade(TradeInfo::SideInfoTrade{buy_order_id, bid_order->get_price()},
+                          TradeInfo::SideInfoTrade{sell_order_id, ask_order->get_price()}, trade_price,
+                          trade_quantity);
+    trades_made(trade);
+    if (config_.journal_ != nullptr)
+      config_.journal_->append_trade(config_.symbol_, trade);
+    traded += trade_quantity;
+
+    bid_order->fill_order(trade_quantity);
+    ask_order->fill_order(trade_quantity);
+    emit_order_event(OrderEventKind::Executed, *bid_order, trade_price, trade_quantity,
+                     bid_order->get_quantity(), sell_order_id);
+    emit_order_event(OrderEventKind::Executed, *ask_order, trade_price, trade_quantity,
+                     ask_order->get_quantity(), buy_order_id);
+    if (bid_order->is_filled())
+      bid_order = remove_filled(bid_level, bid_order);
+    if (ask_order->is_filled())
+      ask_order = remove_filled(ask_level, ask_order);
   }
-      if (bids_.size() > 0) {
-        auto &[buy_price, bids_list] = *bids_.begin();
-        auto &bids_entry = *bids_list.begin();
-        auto buy_order_id = bids_entry->get_order_id();
+  bids_.add_quantity(bid_level, -traded);
+  asks_.add_quantity(ask_level, -traded);
+  if (bid_level.orders_.empty())
+    bids_.erase_best(bid_level);
+  if (ask_level.orders_.empty())
+    asks_.erase_best(ask_level);
+}
+
+Order *OrderBook::remove_filled(PriceLevel &level, Order *order) {
+  auto *next = OrderPointers::next(order);
+  if (next != nullptr)
+    __builtin_prefetch(next);
+  untrack_expiry(level, order);
+  level.orders_.erase(order);
+  erase_order(order->get_order_id());
+  intrusive_ptr_release(order);
+  return next;
+}
+
+void OrderBook::sweep_order(Order &order, TradeSink trades) {
+  if (order.get_order_side() == OrderSide::Buy)
+    sweep(asks_, order, trades);
+  else
+    sweep(bids_, order, trades);
+}
 
-    if (bids_entry->get_order_type() == OrderType::FillAndKill) {
-      cancel_order_internal(buy_order_id);
+template <OrderSide Side>
+void OrderBook::sweep(PriceLadder<Side> &ladder, Order &order, TradeSink trades) {
+  const auto id = order.get_order_id();
+  const auto limit = order.get_price();
+  // Priced as match_orders prices a cross: at the ask, so a limit sell trades
+  // at its own price and a market sell (priced 0) at the bid
+  const bool at_limit = Side == OrderSide::Buy && order.get_order_type() != OrderType::Market;
+  for (auto *level = ladder.best(); level != nullptr && !order.is_filled() && !ladder.better(limit, level->price_);
+       level = ladder.best()) {
+    // One level at a time, with one aggregate update when leaving it
+    mark_level(*level, Side, level->count());
+    const auto trade_price = at_limit ? limit : level->price_;
+    Quantity traded = 0;
+    for (auto *resting = level->orders_.front(); resting != nullptr && !order.is_filled();) {
+      const auto resting_id = resting->get_order_id();
+      const auto trade_quantity = std::min(order.get_quantity(), resting->get_quantity());
+      const TradeInfo::SideInfoTrade aggressor{id, limit};
+      const TradeInfo::SideInfoTrade passive{resting_id, resting->get_price()};
+      const TradeInfo trade = Side == OrderSide::Sell ? TradeInfo(aggressor, passive, trade_price, trade_quantity)
+                                                      : TradeInfo(passive, aggressor, trade_price, trade_quantity);
+      trades(trade);
+      if (config_.journal_ != nullptr)
+        config_.journal_->append_trade(config_.symbol_, trade);
+      traded += trade_quantity;
+
+      order.fill_order(trade_quantity);
+      resting->fill_order(trade_quantity);
+      // The aggressor never had an Added event, so only the resting side is reported
+      emit_order_event(OrderEventKind::Executed, *resting, trade_price, trade_quantity, resting->get_quantity(), id);
+      if (resting->is_filled())
+        resting = remove_filled(*level, resting);
     }
+    ladder.add_quantity(*level, -traded);
+    if (level->orders_.empty())
+      ladder.erase_best(*level);
   }
+}
 
-  if (asks_.size() > 0) {
-    auto &[sell_price, asks_list] = *asks_.begin();
-    auto &asks_entry = *asks_list.begin();
-    auto sell_order_id = asks_entry->get_order_id();
+void OrderBook::end_message() {
+  if (level_deltas_.enabled()) {
+    level_deltas_.end_message([this](OrderSide side, Price price) {
+      auto *level = side == OrderSide::Buy ? bids_.find(price) : asks_.find(price);
+      return level == nullptr ? LevelInfo{price, 0, 0} : level->info();
+    });
+  }
+  publish_snapshot();
+}
 
-    if (asks_entry->get_order_type() == OrderType::FillAndKill) {
-      cancel_order_internal(sell_order_id);
-    }
+void OrderBook::publish_snapshot() {
+  if (!snapshot_.enabled() || !snapshot_dirty_)
+    return;
+  const auto depth = snapshot_.depth();
+  snapshot_.begin_publish();
+  std::size_t bid_count = 0;
+  Price bid_floor = Constants::InvalidPrice;
+  for (auto *level = bids_.best(); level != nullptr && bid_count < depth;
+       level = bids_.next(*level)) {
+    snapshot_.set_bid(bid_count++, level->info());
+    bid_floor = level->price_;
+  }
+  std::size_t ask_count = 0;
+  Price ask_ceiling = Constants::MarketBuyPrice;
+  for (auto *level = asks_.best(); level != nullptr && ask_count < depth;
+       level = asks_.next(*level)) {
+    snapshot_.set_ask(ask_count++, level->info());
+    ask_ceiling = level->price_;
   }
+  snapshot_.end_publish(bid_count, ask_count);
 
-  return trades_made;
+  // While a side has fewer than depth levels, any new level is visible
+  snapshot_dirty_ = false;
+  snapshot_bid_floor_ = bid_count == depth ? bid_floor : Constants::InvalidPrice;
+  snapshot_ask_ceiling_ = ask_count == depth ? ask_ceiling : Constants::MarketBuyPrice;
 }
 
 OrderBook::~OrderBook() {
-  shutdown_.store(true, std::memory_order_release);
-  shutdownConditionVariable_.notify_one();
-  ordersPruneThread_.join();
+  if (ordersPruneThread_.joinable()) {
+    {
+      // Under the lock, so the prune thread cannot miss it between its check and its wait
+      std::scoped_lock ordersLock{ordersMutex_};
+      shutdown_.store(true, std::memory_order_release);
+    }
+    shutdownConditionVariable_.notify_one();
+    ordersPruneThread_.join();
+  }
+  orders_.for_each([](OrderId, Order *order) { intrusive_ptr_release(order); });
 }
 
 void OrderBook::cancel_order_internal(OrderId id, bool no_update_level) {
+  auto *order = orders_.find(id);
+  unlink_order(order, no_update_level);
+  erase_order(id);
+  intrusive_ptr_release(order);
+}
 
-
-  auto &orderinfo = orders_[id];
-  OrderPointers::iterator it = orderinfo.it_;
-  auto &order = orderinfo.pointer_;
+void OrderBook::unlink_order(Order *order, bool no_update_level) {
   auto price = order->get_price();
   auto quantity = order->get_quantity();
   auto side = order->get_order_side();
+  emit_order_event(OrderEventKind::Deleted, *order, price, quantity, 0);
 
   if (side == OrderSide::Buy) {
-    auto &bids_list = bids_[price];
-    bids_list.erase(it);
-    if (bids_list.empty()) {
-      bids_.erase(price);
+    auto &bid_level = *bids_.find(price);
+    if(!no_update_level)OnOrderCancelled(bid_level, quantity, side);
+    untrack_expiry(bid_level, order);
+    bid_level.orders_.erase(order);
+    if (bid_level.orders_.empty()) {
+      bids_.erase(bid_level);
     }
   } else if (side == OrderSide::Sell) {
-    auto &asks_list = asks_[price];
-    asks_list.erase(it);
-    if (asks_list.empty()) {
-      asks_.erase(price);
+    auto &ask_level = *asks_.find(price);
+    if(!no_update_level)OnOrderCancelled(ask_level, quantity, side);
+    untrack_expiry(ask_level, order);
+    ask_level.orders_.erase(order);
+    if (ask_level.orders_.empty()) {
+      asks_.erase(ask_level);
     }
   }
-  if(!no_update_level)OnOrderCancelled(price, quantity, side);
-  orders_.erase(id);
 }
 
-void OrderBook::cancel_orders_internal(OrderIds ids){
-  std::scoped_lock cancel_lock(ordersMutex_);
-  for(auto order_id: ids){
-    cancel_order_internal(order_id);
-  }
+OrderPointer OrderBook::get_order_by_id(OrderId id){
+  return OrderPointer(orders_.find(id));
+}
+
+namespace {
 
+template <typename Record> Record load_record(const std::byte *data) {
+  Record record;
+  std::memcpy(&record, data, sizeof(Record));
+  return record;
 }
 
-OrderPointer OrderBook::get_order_by_id(OrderId id){
+} // namespace
+
+std::vector<std::byte> OrderBook::save_state(std::uint64_t sequence) {
+  using namespace state_snapshot;
+  auto ordersLock = lock_book();
+  StateHeader header;
+  header.tick_nanos_ = config_.tick_size_.get_tick_nanos();
+  header.sequence_ = sequence;
+  header.bid_levels_ = bids_.size();
+  header.ask_levels_ = asks_.size();
+  header.orders_ = orders_.size();
+  header.timers_ = good_till_date_.size();
+  header.time_ = now_;
+  header.participants_ = participant_slots_.size();
+
+  std::vector<std::byte> image(sizeof(StateHeader) +
+                               (header.bid_levels_ + header.ask_levels_) * sizeof(StateLevel) +
+                               header.orders_ * sizeof(StateOrder) + header.timers_ * sizeof(StateTimer) +
+                               header.participants_ * sizeof(StateParticipant));
+  auto *out = image.data();
+  auto put = [&out](const auto &record) {
+    std::memcpy(out, &record, sizeof(record));
+    out += sizeof(record);
+  };
+  put(header);
+  auto save_side = [&put](auto &ladder) {
+    for (auto *level = ladder.best(); level != nullptr; level = ladder.next(*level)) {
+      StateLevel level_record;
+      level_record.price_ = level->price_;
+      level_record.orders_ = static_cast<std::uint32_t>(level->count());
+      put(level_record);
+      for (auto &order : level->orders_) {
+        StateOrder order_record;
+        order_record.order_id_ = static_cast<std::uint32_t>(order.get_order_id());
+        order_record.initial_quantity_ = static_cast<std::uint32_t>(order.get_initial_quantity());
+        order_record.leaves_ = static_cast<std::uint32_t>(order.get_quantity());
+        order_record.order_type_ = static_cast<std::uint8_t>(order.get_order_type());
+        put(order_record);
+      }
+    }
+  };
+  save_side(bids_);
+  save_side(asks_);
+  for (const auto &[id, expiry] : good_till_date_) {
+    StateTimer timer;
+    timer.order_id_ = static_cast<std::uint32_t>(id);
+    timer.expiry_ = expiry;
+    put(timer);
+  }
+  for (const auto &[participant, ids] : participant_orders_) {
+    for (auto id : ids)
+      put(StateParticipant{static_cast<std::uint32_t>(id), participant});
+  }
+  return image;
+}
+
+std::uint64_t OrderBook::restore_state(std::span<const std::byte> image, MemoryPool<Order> &order_pool) {
+  using namespace state_snapshot;
+  auto ordersLock = lock_book();
+  if (orders_.size() != 0 || !bids_.empty() || !asks_.empty())
+    throw std::invalid_argument("restore_state needs an empty book");
+  if (image.size() < sizeof(StateHeader))
+    throw std::invalid_argument("State snapshot truncated");
+  const auto header = load_record<StateHeader>(image.data());
+  if (header.magic_ != Magic || header.version_ != Version)
+    throw std::invalid_argument("Not a version 3 state snapshot");
+  if (header.tick_nanos_ != config_.tick_size_.get_tick_nanos())
+    throw std::invalid_argument("State snapshot is in another tick size");
+
+  // Check the whole image before touching the book: sizes, level order,
+  // fields, and that order ids, timers and participants are each unique and
+  // refer to orders the image holds, so that loading it cannot fail halfway
+  std::size_t offset = sizeof(StateHeader);
+  std::uint64_t orders = 0;
+  std::uint64_t good_till_date = 0;
+  tsl::robin_map<OrderId, std::uint8_t> image_orders; // id -> OrderType, then flags below
+  constexpr std::uint8_t HasTimer = 0x40;
+  constexpr std::uint8_t HasParticipant = 0x80;
+  image_orders.reserve(header.orders_ <= image.size() / sizeof(StateOrder) ? header.orders_ : 0);
+  auto check_side = [&](auto &ladder, std::uint64_t levels) {
+    Price previous = 0;
+    for (std::uint64_t i = 0; i < levels; ++i) {
+      if (image.size() - offset < sizeof(StateLevel))
+        throw std::invalid_argument("State snapshot truncated");
+      const auto level = load_record<StateLevel>(image.data() + offset);
+      offset += sizeof(StateLevel);
+      if (level.orders_ == 0 || (i != 0 && !ladder.better(previous, level.price_)))
+        throw std::invalid_argument("State snapshot levels out of order");
+      previous = level.price_;
+      if ((image.size() - offset) / sizeof(StateOrder) < level.orders_)
+        throw std::invalid_argument("State snapshot truncated");
+      for (std::uint32_t j = 0; j < level.orders_; ++j, offset += sizeof(StateOrder)) {
+        const auto order = load_record<StateOrder>(image.data() + offset);
+        if (order.order_type_ > static_cast<std::uint8_t>(OrderType::GoodTillDate) || order.leaves_ == 0 ||
+            order.leaves_ > order.initial_quantity_ ||
+            order.order_id_ > static_cast<std::uint32_t>(std::numeric_limits<OrderId>::max()) ||
+            order.initial_quantity_ > static_cast<std::uint32_t>(std::numeric_limits<Quantity>::max()))
+          throw std::invalid_argument("State snapshot has an invalid order");
+        if (!image_orders.insert({static_cast<OrderId>(order.order_id_), order.order_type_}).second)
+          throw std::invalid_argument("State snapshot repeats order id " + std::to_string(order.order_id_));
+        good_till_date += order.order_type_ == static_cast<std::uint8_t>(OrderType::GoodTillDate);
+      }
+      orders += level.orders_;
+    }
+  };
+  check_side(bids_, header.bid_levels_);
+  check_side(asks_, header.ask_levels_);
+  if (orders != header.orders_ || header.timers_ != good_till_date || header.participants_ > orders ||
+      image.size() - offset !=
+          header.timers_ * sizeof(StateTimer) + header.participants_ * sizeof(StateParticipant))
+    throw std::invalid_argument("State snapshot size does not match its header");
+  for (std::uint64_t i = 0; i < header.timers_; ++i, offset += sizeof(StateTimer)) {
+    const auto timer = load_record<StateTimer>(image.data() + offset);
+    auto entry = image_orders.find(static_cast<OrderId>(timer.order_id_));
+    // A second timer for the order finds HasTimer set
+    if (entry == image_orders.end() || entry->second != static_cast<std::uint8_t>(OrderType::GoodTillDate))
+      throw std::invalid_argument("State snapshot has an invalid GoodTillDate expiry");
+    image_orders[entry->first] = entry->second | HasTimer;
+  }
+  for (std::uint64_t i = 0; i < header.participants_; ++i, offset += sizeof(StateParticipant)) {
+    const auto record = load_record<StateParticipant>(image.data() + offset);
+    auto entry = image_orders.find(static_cast<OrderId>(record.order_id_));
+    if (record.participant_ == 0 || entry == image_orders.end() || (entry->second & HasParticipant) != 0)
+      throw std::invalid_argument("State snapshot has an invalid participant");
+    image_orders[entry->first] = entry->second | HasParticipant;
+  }
+
+  order_pool.reserve_slots(header.orders_);
+  orders_.reserve(header.orders_);
+  const auto *in = image.data() + sizeof(StateHeader);
+  auto load_side = [&](auto &ladder, OrderSide side, std::uint64_t levels) {
+    for (std::uint64_t i = 0; i < levels; ++i) {
+      const auto level_record = load_record<StateLevel>(in);
+      in += sizeof(StateLevel);
+      auto &level = ladder.find_or_create(level_record.price_);
+      Quantity quantity = 0;
+      for (std::uint32_t j = 0; j < level_record.orders_; ++j, in += sizeof(StateOrder)) {
+        const auto record = load_record<StateOrder>(in);
+        const auto id = static_cast<OrderId>(record.order_id_);
+        const auto type = static_cast<OrderType>(record.order_type_);
+        auto *order = order_pool.allocate_emplace(&order_pool, type, side, id, level_record.price_,
+                                                  static_cast<Quantity>(record.initial_quantity_));
+        order->fill_order(static_cast<Quantity>(record.initial_quantity_ - record.leaves_));
+        intrusive_ptr_add_ref(order); // the book's reference
+        orders_.insert(id, order);
+        level.orders_.push_back(order);
+        quantity += order->get_quantity();
+        if (type == OrderType::GoodForDay)
+          link_good_for_day(level, order);
+      }
+      ladder.add_quantity(level, quantity);
+    }
+  };
+  load_side(bids_, OrderSide::Buy, header.bid_levels_);
+  load_side(asks_, OrderSide::Sell, header.ask_levels_);
+
+  // The book was empty, so every pending timer entry was stale
+  now_ = header.time_;
+  expiry_timers_ = TimerWheel(now_ / config_.timer_resolution_.count());
+  good_till_date_.reserve(header.timers_);
+  for (std::uint64_t i = 0; i < header.timers_; ++i, in += sizeof(StateTimer)) {
+    const auto timer = load_record<StateTimer>(in);
+    const auto id = static_cast<OrderId>(timer.order_id_);
+    good_till_date_.insert({id, timer.expiry_});
+    expiry_timers_.schedule(expiry_tick(timer.expiry_), id);
+  }
+  participant_slots_.reserve(header.participants_);
+  for (std::uint64_t i = 0; i < header.participants_; ++i, in += sizeof(StateParticipant)) {
+    const auto record = load_record<StateParticipant>(in);
+    track_participant(static_cast<OrderId>(record.order_id_), record.participant_);
+  }
 
-  return orders_[id].pointer_;
+  snapshot_dirty_ = true;
+  publish_snapshot();
+  return header.sequence_;
 }
@@ -1,6 +1,8 @@
+#include "include/BinaryProtocol.hpp"
 #include "include/OrderBook.hpp"
 #include "include/PooledShared.hpp"
 #include "include/MemoryPool.hpp"
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -9,6 +11,9 @@
 #include <iomanip>
 #include <charconv>
 #include <algorithm>
+#include <cstring>
+#include <span>
+#include <string_view>
 
 // ANSI Color codes
 namespace Colors {
@@ -70,13 +75,10 @@ private:
         return static_cast<std::uint32_t>(value);
     }
 
-    double ToPrice(const std::string_view& str) const
+    Price ToPrice(const std::string_view& str) const
     {
-        double value{};
-        auto result = std::from_chars(str.data(), str.data() + str.size(), value);
-        if (result.ec != std::errc{} || value < 0.0)
-            throw std::invalid_argument("Invalid price: " + std::string(str));
-        return value;
+        // Throws std::invalid_argument for malformed, negative or off-tick prices
+        return orderbook_.get_tick_size().to_ticks(str);
     }
 
     std::vector<std::string> Split(const std::string& str, char delimiter = ' ') const
@@ -248,14 +250,14 @@ private:
         for (size_t i = 0; i < max_levels; ++i)
         {
             if (i < bid_levels.size())
-                std::cout << Colors::GREEN << std::setw(8) << std::fixed << std::setprecision(2) << bid_levels[i].price_ << " " << std::setw(5) << bid_levels[i].quantity_ << Colors::RESET;
+                std::cout << Colors::GREEN << std::setw(8) << std::fixed << std::setprecision(2) << orderbook_.get_tick_size().to_double(bid_levels[i].price_) << " " << std::setw(5) << bid_levels[i].quantity_ << Colors::RESET;
             else
                 std::cout << std::setw(14) << "";
             
             std::cout << " | ";
             
             if (i < ask_levels.size())
-                std::cout << Colors::RED << std::setw(8) << std::fixed << std::setprecision(2) << ask_levels[i].price_ << " " << std::setw(5) << ask_levels[i].quantity_ << Colors::RESET;
+                std::cout << Colors::RED << std::setw(8) << std::fixed << std::setprecision(2) << orderbook_.get_tick_size().to_double(ask_levels[i].price_) << " " << std::setw(5) << ask_levels[i].quantity_ << Colors::RESET;
             else
                 std::cout << std::setw(14) << "";
             
@@ -276,7 +278,7 @@ private:
         for (auto& trade : trades.trades_made_)
         {
             std::cout << Colors::CYAN;
-            trade.print();
+            trade.print(orderbook_.get_tick_size());
             std::cout << Colors::RESET;
         }
     }
@@ -307,14 +309,119 @@ private:
             action.quantity_);
     }
 
+    // Applies one decoded binary command; returns the trades it produced
+    std::size_t Apply(const OrderCommand& command, TradeInfos& trades)
+    {
+        trades.trades_made_.clear();
+        switch (command.command_)
+        {
+        case CommandType::Add:
+            orderbook_.add_order(make_intrusive_pooled_order(&order_pool_, command.order_type_, command.side_,
+                                                             command.order_id_, command.price_, command.quantity_),
+                                 trades, command.timestamp_);
+            break;
+        case CommandType::Cancel:
+            orderbook_.cancel_order(command.order_id_);
+            break;
+        case CommandType::Modify:
+            orderbook_.modify_order(OrderModify(&order_pool_, command.order_type_, command.side_,
+                                                command.order_id_, command.price_, command.quantity_),
+                                    trades, command.timestamp_);
+            break;
+        case CommandType::MassCancel:
+            orderbook_.mass_cancel(command.side_);
+            break;
+        case CommandType::AdvanceTime:
+            orderbook_.advance_time(command.timestamp_);
+            break;
+        }
+        return trades.trades_made_.size();
+    }
+
 public:
-    OrderBookApp() : order_pool_(100000), next_order_id_(1000)
+    explicit OrderBookApp(bool interactive = true) : order_pool_(100000), next_order_id_(1000)
     {
+        if (!interactive)
+            return;
         std::cout << Colors::CYAN << Colors::BOLD << "=== Order Book Application ===" << Colors::RESET << "\n";
         std::cout << Colors::YELLOW << "Type 'help' or 'h' for commands." << Colors::RESET << "\n";
         std::cout << Colors::BOLD << "Next Available ID: " << Colors::CYAN << next_order_id_ << Colors::RESET << "\n\n";
     }
 
+    // Reads the stream in large chunks and decodes each chunk in batches of
+    // commands; decode and book time are measured separately. Returns false
+    // if the stream is malformed or ends inside a message.
+    bool RunBinary(std::istream& in)
+    {
+        constexpr std::size_t ChunkBytes = 1 << 20;
+        constexpr std::size_t BatchCommands = 1024;
+        std::vector<std::byte> buffer(ChunkBytes);
+        std::vector<OrderCommand> batch(BatchCommands);
+        TradeInfos trades;
+        trades.trades_made_.reserve(1024);
+
+        std::size_t pending = 0; // undecoded bytes at the front of buffer
+        std::uint64_t commands = 0, trade_count = 0, decode_ns = 0, book_ns = 0;
+        bool malformed = false;
+        while (!malformed)
+        {
+            in.read(reinterpret_cast<char*>(buffer.data() + pending), buffer.size() - pending);
+            const auto read = static_cast<std::size_t>(in.gcount());
+            if (read == 0)
+                break;
+            std::span<const std::byte> chunk(buffer.data(), pending + read);
+            while (!chunk.empty())
+            {
+                uint64_t start_time = get_time_nanoseconds();
+                auto result = wire::decode_batch(chunk, batch);
+                uint64_t decoded_time = get_time_nanoseconds();
+                for (std::size_t i = 0; i < result.commands_; ++i)
+                    trade_count += Apply(batch[i], trades);
+                book_ns += get_time_nanoseconds() - decoded_time;
+                decode_ns += decoded_time - start_time;
+                commands += result.commands_;
+                chunk = chunk.subspan(result.bytes_);
+                if (result.malformed_)
+                {
+                    malformed = true;
+                    break;
+                }
+                if (result.commands_ == 0)
+                    break; // partial message: wait for the next read
+            }
+            pending = chunk.size();
+            std::memmove(buffer.data(), chunk.data(), pending);
+        }
+
+        auto per_second = [](std::uint64_t count, std::uint64_t ns) {
+            return ns == 0 ? 0.0 : static_cast<double>(count) * 1e9 / static_cast<double>(ns);
+        };
+        std::cout << Colors::BOLD << "Commands: " << Colors::CYAN << commands << Colors::RESET
+                  << Colors::BOLD << ", trades: " << Colors::CYAN << trade_count << Colors::RESET << "\n";
+        std::cout << Colors::BOLD << "Decode: " << Colors::RESET << std::fixed << std::setprecision(0)
+                  << per_second(commands, decode_ns) << " msgs/sec ("
+                  << std::setprecision(2) << (commands ? static_cast<double>(decode_ns) / commands : 0.0) << " ns/msg)\n";
+        std::cout << Colors::BOLD << "Match:  " << Colors::RESET << std::setprecision(0)
+                  << per_second(commands, book_ns) << " msgs/sec ("
+                  << std::setprecision(2) << (commands ? static_cast<double>(book_ns) / commands : 0.0) << " ns/msg)\n";
+        ShowOrderBookSummary();
+        if (malformed || pending != 0)
+        {
+            std::cout << Colors::RED << "Error: " << (malformed ? "malformed message" : "stream ends inside a message")
+                      << " after " << commands << " commands" << Colors::RESET << "\n";
+            return false;
+        }
+        return true;
+    }
+
+    void ShowOrderBookSummary()
+    {
+        auto levels = orderbook_.get_order_book();
+        std::cout << Colors::BOLD << "Total Orders: " << Colors::YELLOW << orderbook_.Size() << Colors::RESET
+                  << Colors::BOLD << ", Bid Levels: " << Colors::GREEN << levels.get_bids().size() << Colors::RESET
+                  << Colors::BOLD << ", Ask Levels: " << Colors::RED << levels.get_asks().size() << Colors::RESET << "\n";
+    }
+
     void Run()
     {
         std::string input;
@@ -412,10 +519,25 @@ public:
     }
 };
 
-int main()
+int main(int argc, char** argv)
 {
     try
     {
+        // --binary [file]: ingest a binary order entry stream (BinaryProtocol.hpp)
+        // from file or stdin instead of running the interactive prompt
+        if (argc > 1 && std::string_view(argv[1]) == "--binary")
+        {
+            OrderBookApp app(false);
+            if (argc > 2)
+            {
+                std::ifstream file(argv[2], std::ios::binary);
+                if (!file)
+                    throw std::invalid_argument(std::string("Cannot open ") + argv[2]);
+                return app.RunBinary(file) ? 0 : 1;
+            }
+            return app.RunBinary(std::cin) ? 0 : 1;
+        }
+
         OrderBookApp app;
         app.Run();
     }
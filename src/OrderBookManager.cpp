@@ -0,0 +1,41 @@
+#include "include/OrderBookManager.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+OrderBookManager::OrderBookManager(OrderBookManagerConfig config) {
+  const auto shard_count = std::max<std::size_t>(1, config.shards_);
+  // Each shard appends from its own thread, and a Journal takes one producer
+  if (shard_count > 1 && config.shard_.book_.journal_ != nullptr)
+    throw std::invalid_argument("a journal cannot be shared by more than one shard");
+
+  std::vector<std::vector<SymbolId>> shard_symbols(shard_count);
+  routes_.reserve(config.symbols_.size());
+  for (std::size_t i = 0; i < config.symbols_.size(); ++i) {
+    const auto shard = static_cast<std::uint32_t>(i % shard_count);
+    if (routes_.emplace(config.symbols_[i], shard).second)
+      shard_symbols[shard].push_back(config.symbols_[i]);
+  }
+
+  shards_.reserve(shard_count);
+  for (std::size_t shard = 0; shard < shard_count; ++shard) {
+    auto shard_config = config.shard_;
+    shard_config.symbols_ = std::move(shard_symbols[shard]);
+    shard_config.core_ = shard < config.cores_.size() ? config.cores_[shard] : -1;
+    shards_.push_back(std::make_unique<MatchingEngine>(std::move(shard_config)));
+  }
+}
+
+std::size_t OrderBookManager::shard_of(SymbolId symbol) const {
+  auto it = routes_.find(symbol);
+  if (it == routes_.end())
+    throw std::out_of_range("unknown symbol " + std::to_string(symbol));
+  return it->second;
+}
+
+std::uint64_t OrderBookManager::processed() const {
+  std::uint64_t total = 0;
+  for (const auto &shard : shards_)
+    total += shard->processed();
+  return total;
+}
@@ -0,0 +1,152 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "include/MarketByOrderBook.hpp"
+#include "include/OrderBook.hpp"
+#include "include/OrderEvent.hpp"
+#include "include/PooledShared.hpp"
+#include "include/TickSize.hpp"
+#include "perf_utils/LatencyStats.hpp"
+
+using namespace std;
+
+// Cost of the L3 order event stream, and speed of rebuilding a book from it.
+// The same pre-generated flow runs through a book without the stream and one
+// with it; the consumer drains the ring after every call, outside the timed
+// window, so the latencies differ only by the cost of emitting. A third,
+// untimed run records the events (recording in the timed run would stream
+// the log through the cache), which are then replayed into a MarketByOrderBook.
+//
+//   mbo_perf [--orders N] [--ladder]
+
+uint64_t get_time_nanoseconds() {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+}
+
+struct Action {
+    bool cancel_;
+    OrderType type_;
+    OrderSide side_;
+    OrderId id_;
+    Price price_;
+    Quantity quantity_;
+};
+
+int main(int argc, char** argv) {
+    const TickSize tick_size{};
+    OrderBookConfig config{.tick_size_ = tick_size};
+    int num_orders = 1'000'000;
+    for (int arg = 1; arg < argc; ++arg) {
+        if (std::strcmp(argv[arg], "--orders") == 0 && arg + 1 < argc)
+            num_orders = std::atoi(argv[++arg]);
+        else if (std::strcmp(argv[arg], "--ladder") == 0) {
+            config.ladder_base_price_ = tick_size.to_ticks(20.0);
+            config.ladder_levels_ = 21'000;
+        }
+    }
+    config.expected_orders_ = num_orders;
+
+    // Resting flow on both sides of mid with a crossing tail, cancels and markets
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> action_dist(0, 9);
+    std::uniform_int_distribution<int> side_dist(0, 1);
+    std::uniform_int_distribution<int> qty_dist(100, 1000);
+    std::normal_distribution<double> offset_dist(0.0, 40.0);
+    const Price mid = tick_size.to_ticks(125.0);
+    std::vector<Action> actions(num_orders);
+    OrderId id = 0;
+    for (auto& action : actions) {
+        int kind = action_dist(rng);
+        action.side_ = side_dist(rng) ? OrderSide::Buy : OrderSide::Sell;
+        action.cancel_ = kind >= 7 && id > 0;
+        action.type_ = kind == 6 ? OrderType::Market : OrderType::GoodTillCancel;
+        if (action.cancel_) {
+            action.id_ = std::uniform_int_distribution<OrderId>(1, id)(rng);
+            continue;
+        }
+        action.id_ = ++id;
+        Price offset = 1 + static_cast<Price>(offset_dist(rng));
+        action.price_ = action.side_ == OrderSide::Buy ? mid - offset : mid + offset;
+        action.quantity_ = qty_dist(rng);
+    }
+
+    std::vector<OrderEvent> recorded;
+    // events: emit the stream; record: keep what is drained in 'recorded'
+    auto run = [&](bool events, bool record) {
+        MemoryPool<Order> order_pool(num_orders);
+        auto book_config = config;
+        // Drained after every call, so a small ring that stays in L1 is enough
+        book_config.order_event_capacity_ = events ? 256 : 0;
+        OrderBook book(book_config);
+        TradeInfos trades;
+        trades.trades_made_.reserve(1024);
+        std::vector<uint64_t> latencies;
+        latencies.reserve(actions.size());
+        OrderEvent event;
+        for (const auto& action : actions) {
+            uint64_t start_t;
+            if (action.cancel_) {
+                start_t = get_time_nanoseconds();
+                book.cancel_order(action.id_);
+            } else {
+                auto order = make_intrusive_pooled_order(&order_pool, action.type_, action.side_, action.id_,
+                                                         action.price_, action.quantity_);
+                trades.trades_made_.clear();
+                start_t = get_time_nanoseconds();
+                book.add_order(std::move(order), trades);
+            }
+            latencies.push_back(get_time_nanoseconds() - start_t);
+            while (book.try_poll_order_event(event)) {
+                if (record)
+                    recorded.push_back(event);
+            }
+        }
+        return std::make_pair(computeLatencyStats(latencies), book.get_order_book());
+    };
+
+    auto [plain_stats, plain_levels] = run(false, false);
+    cout << endl << "Matcher without the L3 stream (" << actions.size() << " calls):" << endl;
+    appendLatencyStatsToFile(plain_stats);
+
+    auto [event_stats, event_levels] = run(true, false);
+    cout << endl << "Matcher emitting the L3 stream:" << endl;
+    appendLatencyStatsToFile(event_stats);
+    cout << endl << "p99 cost of the stream: "
+         << (static_cast<double>(event_stats.p99) / plain_stats.p99 - 1.0) * 100.0 << "%, average "
+         << (event_stats.avg / plain_stats.avg - 1.0) * 100.0 << "%" << endl;
+
+    // Consumer side: rebuild the book from the recorded stream
+    recorded.reserve(actions.size() * 3);
+    run(true, true);
+    MarketByOrderBook rebuilt(num_orders);
+    uint64_t start_t = get_time_nanoseconds();
+    bool consistent = true;
+    for (const auto& event : recorded)
+        consistent = rebuilt.apply(event) && consistent;
+    uint64_t elapsed_t = get_time_nanoseconds() - start_t;
+    cout << endl << "MarketByOrderBook: " << recorded.size() << " events in " << elapsed_t / 1e6 << " ms, "
+         << recorded.size() * 1e9 / elapsed_t << " events/sec ("
+         << static_cast<double>(elapsed_t) / recorded.size() << " ns/event)" << endl;
+
+    const auto rebuilt_levels = rebuilt.get_order_book();
+    bool same = consistent && rebuilt_levels.get_bids().size() == event_levels.get_bids().size() &&
+                rebuilt_levels.get_asks().size() == event_levels.get_asks().size();
+    for (const auto& [price, level] : event_levels.get_bids()) {
+        auto it = rebuilt_levels.get_bids().find(price);
+        same = same && it != rebuilt_levels.get_bids().end() && it->second.quantity_ == level.quantity_ &&
+               it->second.count_ == level.count_;
+    }
+    for (const auto& [price, level] : event_levels.get_asks()) {
+        auto it = rebuilt_levels.get_asks().find(price);
+        same = same && it != rebuilt_levels.get_asks().end() && it->second.quantity_ == level.quantity_ &&
+               it->second.count_ == level.count_;
+    }
+    cout << "Rebuilt book " << (same ? "matches" : "DOES NOT match") << " the matcher's ("
+         << rebuilt.size() << " resting orders)" << endl;
+    return same ? 0 : 1;
+}
@@ -4,6 +4,11 @@
 #include <chrono>
 #include <string>
 #include <memory>
+#include <cstring>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+#include <thread>
 
 // Include all necessary headers
 #include "include/OrderBook.hpp"
@@ -14,6 +19,7 @@
 #include "include/constants.hpp"
 #include "perf_utils/LatencyStats.hpp"
 #include "include/PooledShared.hpp"
+#include "include/TickSize.hpp"
 
 using namespace std;
 
@@ -26,6 +32,19 @@ uint64_t get_time_nanoseconds() {
 
 // LatencyStats helpers are now in perf_utils/LatencyStats.*
 
+// Global operator new is counted so each section can report how many heap
+// allocations its timed calls made (the steady-state matching ones should make none)
+static std::atomic<uint64_t> heap_allocations{0};
+
+void* operator new(std::size_t size) {
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc{};
+}
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
 // Helper function to generate normal distribution with custom parameters
 std::vector<double> generateNormalDistribution(std::mt19937& rng, double mid, double leftRange, double rightRange, int totalValues) {
     double min_val = mid - leftRange;
@@ -50,7 +69,7 @@ std::vector<double> generateNormalDistribution(std::mt19937& rng, double mid, do
     return values;
 }
 
-int main(){
+int main(int argc, char** argv){
 // Random engine setup
 std::mt19937 rng(std::random_device{}()); // Mersenne Twister
 std::uniform_int_distribution<int> qty_dist(100, 1000);
@@ -62,13 +81,67 @@ MemoryPool<Order> order_pool(1'000'000);
 order_pool.reserve_slots(expected_orders);
 // Warm-up: fault pages
 for (int i = 0; i < 1000; ++i) {
-    Order* tmp = order_pool.allocate_emplace(&order_pool, OrderType::GoodTillCancel, OrderSide::Buy, -1, 0.0, 0);
+    Order* tmp = order_pool.allocate_emplace(&order_pool, OrderType::GoodTillCancel, OrderSide::Buy, -1, Price{0}, 0);
     order_pool.deallocate(tmp);
 }
 
-auto ob = OrderBook();
+// Prices are generated in ticks; doubles only appear where the edge would parse them
+const TickSize tick_size{}; // 0.01
+OrderBookConfig config{.tick_size_ = tick_size};
+config.expected_orders_ = 3'000'000; // sized for the steady state below
+config.expected_levels_ = 20'000;
+int snapshot_readers = 0;
+bool level_deltas = false;
+for (int arg = 1; arg < argc; ++arg) {
+    // --ladder: dense price ladder over 20.00-230.00, which covers every price generated below
+    if (std::strcmp(argv[arg], "--ladder") == 0) {
+        config.ladder_base_price_ = tick_size.to_ticks(20.0);
+        config.ladder_levels_ = 21'000;
+    }
+    // --direct-index: ids below are assigned monotonically from 1
+    if (std::strcmp(argv[arg], "--direct-index") == 0) {
+        config.order_index_mode_ = OrderIndexMode::Direct;
+        config.order_index_base_id_ = 1;
+    }
+    // --snapshot-readers N: publish top-10 depth after every event and keep N
+    // threads reading it for the whole run, so matcher latency below includes
+    // the publish cost and reader throughput is reported at the end
+    if (std::strcmp(argv[arg], "--snapshot-readers") == 0 && arg + 1 < argc) {
+        snapshot_readers = std::atoi(argv[++arg]);
+        config.snapshot_depth_ = 10;
+    }
+    // --level-deltas: emit the L2 delta feed; a publisher drains it after
+    // every call (outside the timed window), so latencies include emitting it
+    if (std::strcmp(argv[arg], "--level-deltas") == 0) {
+        level_deltas = true;
+        config.level_delta_capacity_ = 1024;
+    }
+}
+auto ob = OrderBook(config);
+
+uint64_t deltas_forwarded = 0;
+auto forward_deltas = [&]() {
+    if (level_deltas)
+        ob.drain_level_deltas([&deltas_forwarded](const LevelDelta&) { ++deltas_forwarded; });
+};
+
+std::atomic<bool> readers_done{false};
+std::vector<std::atomic<uint64_t>> reader_counts(snapshot_readers);
+std::vector<std::thread> readers;
+for (int reader = 0; reader < snapshot_readers; ++reader) {
+    readers.emplace_back([&, reader]() {
+        BookSnapshot snapshot{config.snapshot_depth_};
+        uint64_t reads = 0;
+        while (!readers_done.load(std::memory_order_relaxed)) {
+            ob.read_snapshot(snapshot);
+            ++reads;
+        }
+        reader_counts[reader].store(reads);
+    });
+}
+uint64_t readers_start_t = get_time_nanoseconds();
 
-double start_buy_price = 123.0;
+Price start_buy_price = tick_size.to_ticks(123.0);
 
 std::vector<uint64_t> init_buy_latencies;
 init_buy_latencies.reserve(10000 * 100);
@@ -79,14 +152,15 @@ OrderId id = 0;
 
 
 for (int level = 0; level < 10000; ++level) {
-    double price = start_buy_price - (level/100.0); // e.g. 123, 122.99, ...
+    Price price = start_buy_price - level; // e.g. 123, 122.99, ...
     for (int j = 0; j < 100; ++j) {
         id++;
         int quantity = qty_dist(rng);
         uint64_t start_t = get_time_nanoseconds();
         OrderPointer order = make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Buy, id,price, quantity );
-        auto trades = ob.add_order(order);
+        auto trades = ob.add_order(std::move(order));
         uint64_t end_t = get_time_nanoseconds();
+        forward_deltas();
         populate_time_init += end_t- start_t;
         init_buy_latencies.push_back(end_t - start_t);
     }
@@ -102,16 +176,17 @@ cout<<endl;
 
 
 
-double start_sell_price = 125.0;
+Price start_sell_price = tick_size.to_ticks(125.0);
 for (int level = 0; level < 10000; ++level) {
-    double price = start_sell_price + (level/100.0); // e.g. 125, 125.01, ...
+    Price price = start_sell_price + level; // e.g. 125, 125.01, ...
     for (int j = 0; j < 100; ++j) {
         id++;
         int quantity = qty_dist(rng);
         uint64_t start_t = get_time_nanoseconds();
         OrderPointer order = make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, OrderSide::Sell, id,price, quantity );
-        auto trades = ob.add_order(order);
+        auto trades = ob.add_order(std::move(order));
         uint64_t end_t = get_time_nanoseconds();
+        forward_deltas();
         populate_time_init += end_t- start_t;
         init_sell_latencies.push_back(end_t - start_t);
 
@@ -135,18 +210,24 @@ limit_latencies.reserve(NUM_LIMIT_ORDERS);
 std::uniform_int_distribution<int> market_qty_dist(100, 2000);
 // Generate prices using normal distribution around 124 with range [100, 150]
 auto prices = generateNormalDistribution(rng, 124.0, 24.0, 26.0, NUM_LIMIT_ORDERS);
+// One trade buffer for the whole run: its capacity is reused, not reallocated
+TradeInfos trades;
+trades.trades_made_.reserve(1024);
+uint64_t allocations_before = heap_allocations.load();
 
 for (int i = 0; i < NUM_LIMIT_ORDERS; ++i) {
     // Random side (buy or sell)
     id++;
     OrderSide side = (side_dist(rng) == 0) ? OrderSide::Buy : OrderSide::Sell;
     int qty = market_qty_dist(rng);
-    double price = prices[i]; // Use pre-generated price
+    Price price = tick_size.to_ticks(prices[i]); // Use pre-generated price
 
     uint64_t start_t = get_time_nanoseconds();
     OrderPointer order = make_intrusive_pooled_order(&order_pool, OrderType::GoodTillCancel, side, id, price, qty);
-    auto trades = ob.add_order(order);
+    trades.trades_made_.clear();
+    ob.add_order(std::move(order), trades);
     uint64_t end_t = get_time_nanoseconds();
+    forward_deltas();
 
     uint64_t duration = end_t - start_t;
     total_limit_ns += duration;
@@ -154,6 +235,7 @@ for (int i = 0; i < NUM_LIMIT_ORDERS; ++i) {
 }
 double avg_limit_ns = static_cast<double>(total_limit_ns) / NUM_LIMIT_ORDERS;
     cout<<endl<<"Stats for "<<NUM_LIMIT_ORDERS<<" "<<"Limit Orders:"<<endl;
+    cout<<"heap allocations: "<<heap_allocations.load() - allocations_before<<endl;
 
     auto limit_stats = computeLatencyStats(limit_latencies);
     appendLatencyStatsToFile(limit_stats);
@@ -193,18 +275,30 @@ double avg_limit_ns = static_cast<double>(total_limit_ns) / NUM_LIMIT_ORDERS;
     std::uniform_int_distribution<int> market_qty_dist(100, 2000);
     // Generate prices using normal distribution around 124 with range [100, 150]
     auto prices = generateNormalDistribution(rng, 124.0, 24.0, 26.0, NUM_MARKET_ORDERS);
+    TradeInfos trades;
+    trades.trades_made_.reserve(1024);
+    // Market orders sweep the other side without ever resting: no level at
+    // the 0 / max price, no order table entry, and any remainder is dropped,
+    // which the counts below (taken outside the timed window) show
+    uint64_t fills = 0;
+    int left_resting = 0;
+    uint64_t allocations_before = heap_allocations.load();
     
     for (int i = 0; i < NUM_MARKET_ORDERS; ++i) {
         // Random side (buy or sell)
         id++;
         OrderSide side = (side_dist(rng) == 0) ? OrderSide::Buy : OrderSide::Sell;
         int qty = market_qty_dist(rng);
-        double price = prices[i]; // Use pre-generated price
+        Price price = tick_size.to_ticks(prices[i]); // Use pre-generated price
     
         uint64_t start_t = get_time_nanoseconds();
         OrderPointer order = make_intrusive_pooled_order(&order_pool, OrderType::Market, side, id, Constants::InvalidPrice, qty);
-        auto trades = ob.add_order(order);
+        trades.trades_made_.clear();
+        ob.add_order(std::move(order), trades);
         uint64_t end_t = get_time_nanoseconds();
+        forward_deltas();
+        fills += trades.trades_made_.size();
+        left_resting += ob.get_order_by_id(id) != nullptr;
     
         uint64_t duration = end_t - start_t;
         total_mkt_ns += duration;
@@ -213,6 +307,8 @@ double avg_limit_ns = static_cast<double>(total_limit_ns) / NUM_LIMIT_ORDERS;
     }
     double avg_mkt_ns = static_cast<double>(total_mkt_ns) / NUM_MARKET_ORDERS;
         cout<<endl<<"Stats for "<<NUM_MARKET_ORDERS<<" "<<"Market Orders:"<<endl;
+        cout<<"heap allocations: "<<heap_allocations.load() - allocations_before<<endl;
+        cout<<"fills: "<<fills<<" ("<<static_cast<double>(fills) / NUM_MARKET_ORDERS<<" per order), left resting: "<<left_resting<<endl;
         auto market_stats = computeLatencyStats(market_latencies);
         appendLatencyStatsToFile(market_stats);
 
@@ -241,4 +337,114 @@ double avg_limit_ns = static_cast<double>(total_limit_ns) / NUM_LIMIT_ORDERS;
 }
     
 
+
+{
+    // FillOrKill orders too large to ever fill: the feasibility check has to
+    // account for every level up to the limit before rejecting them
+    const int NUM_FOK_ORDERS = 50000;
+    std::vector<uint64_t> fok_latencies;
+    fok_latencies.reserve(NUM_FOK_ORDERS);
+    auto prices = generateNormalDistribution(rng, 124.0, 24.0, 26.0, NUM_FOK_ORDERS);
+
+    for (int i = 0; i < NUM_FOK_ORDERS; ++i) {
+        id++;
+        OrderSide side = (side_dist(rng) == 0) ? OrderSide::Buy : OrderSide::Sell;
+        Price price = tick_size.to_ticks(prices[i]);
+
+        uint64_t start_t = get_time_nanoseconds();
+        OrderPointer order = make_intrusive_pooled_order(&order_pool, OrderType::FillOrKill, side, id, price, 2'000'000'000);
+        auto trades = ob.add_order(std::move(order));
+        uint64_t end_t = get_time_nanoseconds();
+        forward_deltas();
+        fok_latencies.push_back(end_t - start_t);
+    }
+    cout<<endl<<"Stats for "<<NUM_FOK_ORDERS<<" "<<"rejected FillOrKill Orders:"<<endl;
+    auto fok_stats = computeLatencyStats(fok_latencies);
+    appendLatencyStatsToFile(fok_stats);
+}
+
+{
+    // Modifies of resting orders, picked at random (outside the timed window)
+    // among those still in the book: size-downs at the same price, which keep
+    // their place in the queue, then moves a few ticks away from the touch
+    const int NUM_MODIFIES = 50000;
+    std::uniform_int_distribution<OrderId> id_dist(1, id);
+    std::uniform_int_distribution<int> tick_dist(1, 5);
+    TradeInfos trades;
+    trades.trades_made_.reserve(1024);
+    auto run_modifies = [&](bool reprice, const char* name) {
+        std::vector<uint64_t> modify_latencies;
+        modify_latencies.reserve(NUM_MODIFIES);
+        uint64_t allocations_before = heap_allocations.load();
+        while (static_cast<int>(modify_latencies.size()) < NUM_MODIFIES) {
+            const OrderId modify_id = id_dist(rng);
+            OrderSide side;
+            Price price;
+            Quantity quantity;
+            {
+                auto resting = ob.get_order_by_id(modify_id);
+                if (!resting || resting->get_quantity() < 2)
+                    continue;
+                side = resting->get_order_side();
+                price = resting->get_price();
+                quantity = resting->get_quantity();
+            }
+            if (reprice)
+                price += side == OrderSide::Buy ? -tick_dist(rng) : tick_dist(rng);
+            else
+                quantity /= 2;
+            trades.trades_made_.clear();
+            uint64_t start_t = get_time_nanoseconds();
+            ob.modify_order(OrderModify(&order_pool, OrderType::GoodTillCancel, side, modify_id, price, quantity), trades);
+            uint64_t end_t = get_time_nanoseconds();
+            forward_deltas();
+            modify_latencies.push_back(end_t - start_t);
+        }
+        cout<<endl<<"Stats for "<<NUM_MODIFIES<<" "<<name<<":"<<endl;
+        cout<<"heap allocations: "<<heap_allocations.load() - allocations_before<<endl;
+        appendLatencyStatsToFile(computeLatencyStats(modify_latencies));
+    };
+    run_modifies(false, "same-price size-down Modifies");
+    run_modifies(true, "reprice Modifies");
+}
+
+{
+    // Cancel-heavy flow: random ids from everything issued so far, so a share
+    // of them has already traded away and misses the order table
+    const int NUM_CANCELS = 50000;
+    std::vector<uint64_t> cancel_latencies;
+    cancel_latencies.reserve(NUM_CANCELS);
+    std::uniform_int_distribution<OrderId> id_dist(1, id);
+
+    for (int i = 0; i < NUM_CANCELS; ++i) {
+        OrderId cancel_id = id_dist(rng);
+        uint64_t start_t = get_time_nanoseconds();
+        ob.cancel_order(cancel_id);
+        uint64_t end_t = get_time_nanoseconds();
+        forward_deltas();
+        cancel_latencies.push_back(end_t - start_t);
+    }
+    cout<<endl<<"Stats for "<<NUM_CANCELS<<" "<<"Cancels:"<<endl;
+    auto cancel_stats = computeLatencyStats(cancel_latencies);
+    appendLatencyStatsToFile(cancel_stats);
+}
+
+if (level_deltas) {
+    cout<<endl<<"Level deltas forwarded: "<<deltas_forwarded<<" (sequence "
+        <<ob.level_delta_sequence()<<")"<<endl;
+}
+
+if (snapshot_readers > 0) {
+    readers_done.store(true, std::memory_order_relaxed);
+    uint64_t elapsed_t = get_time_nanoseconds() - readers_start_t;
+    for (auto& reader : readers)
+        reader.join();
+    uint64_t total_reads = 0;
+    for (auto& count : reader_counts)
+        total_reads += count.load();
+    cout<<endl<<"Snapshot readers: "<<snapshot_readers<<", "<<total_reads<<" reads, "
+        <<(total_reads * 1e9 / elapsed_t)<<" reads/sec ("<<snapshot_readers<<" threads, "
+        <<ob.snapshot_sequence()<<" publications)"<<endl;
+}
+
 }
@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "include/BinaryProtocol.hpp"
+#include "include/OrderBook.hpp"
+#include "include/PooledShared.hpp"
+#include "include/TickSize.hpp"
+
+using namespace std;
+
+// Order entry parse throughput, text vs binary, measured apart from matching.
+// One pre-generated command stream is rendered both as the REPL's text lines
+// (A/C/M) and as BinaryProtocol messages. The text lines go through the
+// tokenizing parse the interactive app uses; the binary stream through
+// wire::decode_batch. The decoded commands are then applied to a book on
+// their own, so msgs/sec for parsing and for matching are reported separately.
+//
+//   protocol_perf [--messages N] [--write FILE]
+//
+// --write also saves the binary stream, e.g. for OrderBookApp --binary FILE.
+
+uint64_t get_time_nanoseconds() {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+}
+
+// The interactive app's text path: stringstream tokens, lowercased verb
+OrderCommand parse_text(const string& line, const TickSize& tick_size) {
+    vector<string> tokens;
+    stringstream ss(line);
+    string token;
+    while (getline(ss, token, ' '))
+        if (!token.empty())
+            tokens.push_back(token);
+    string verb = tokens[0];
+    transform(verb.begin(), verb.end(), verb.begin(), ::tolower);
+    auto number = [](const string& str) {
+        int value = 0;
+        from_chars(str.data(), str.data() + str.size(), value);
+        return value;
+    };
+    OrderCommand command;
+    if (verb == "a") {
+        command.side_ = tokens[1] == "B" ? OrderSide::Buy : OrderSide::Sell;
+        command.order_type_ = tokens[2] == "MKT" ? OrderType::Market : OrderType::GoodTillCancel;
+        command.price_ = tick_size.to_ticks(tokens[3]);
+        command.quantity_ = number(tokens[4]);
+        command.order_id_ = number(tokens[5]);
+    } else if (verb == "c") {
+        command.command_ = CommandType::Cancel;
+        command.order_id_ = number(tokens[1]);
+    } else {
+        command.command_ = CommandType::Modify;
+        command.order_id_ = number(tokens[1]);
+        command.side_ = tokens[2] == "B" ? OrderSide::Buy : OrderSide::Sell;
+        command.price_ = tick_size.to_ticks(tokens[3]);
+        command.quantity_ = number(tokens[4]);
+    }
+    return command;
+}
+
+int main(int argc, char** argv) {
+    size_t num_messages = 2'000'000;
+    const char* write_path = nullptr;
+    for (int arg = 1; arg < argc; ++arg) {
+        if (std::strcmp(argv[arg], "--messages") == 0 && arg + 1 < argc)
+            num_messages = std::strtoull(argv[++arg], nullptr, 10);
+        else if (std::strcmp(argv[arg], "--write") == 0 && arg + 1 < argc)
+            write_path = argv[++arg];
+    }
+
+    const TickSize tick_size{};
+    const Price mid = tick_size.to_ticks(100.0);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> action_dist(0, 9);
+    std::uniform_int_distribution<int> side_dist(0, 1);
+    std::uniform_int_distribution<int> qty_dist(1, 1000);
+    std::normal_distribution<double> offset_dist(0.0, 20.0);
+
+    vector<OrderCommand> commands(num_messages);
+    OrderId id = 0;
+    for (auto& command : commands) {
+        int action = action_dist(rng);
+        command.side_ = side_dist(rng) ? OrderSide::Buy : OrderSide::Sell;
+        if (action < 2 && id > 0) {
+            command.command_ = CommandType::Cancel;
+            command.order_id_ = std::uniform_int_distribution<OrderId>(1, id)(rng);
+        } else if (action == 2 && id > 0) {
+            command.command_ = CommandType::Modify;
+            command.order_id_ = std::uniform_int_distribution<OrderId>(1, id)(rng);
+        } else {
+            command.order_id_ = ++id;
+        }
+        if (command.command_ != CommandType::Cancel) {
+            Price offset = 1 + static_cast<Price>(offset_dist(rng));
+            command.price_ = command.side_ == OrderSide::Buy ? mid - offset : mid + offset;
+            command.quantity_ = qty_dist(rng);
+        }
+    }
+
+    vector<string> lines;
+    lines.reserve(num_messages);
+    vector<std::byte> stream(num_messages * wire::MaxMessageSize);
+    size_t stream_bytes = 0;
+    for (const auto& command : commands) {
+        const char* side = command.side_ == OrderSide::Buy ? "B" : "S";
+        const string price = to_string(command.price_ / 100) + "." + (command.price_ % 100 < 10 ? "0" : "") +
+                             to_string(command.price_ % 100);
+        if (command.command_ == CommandType::Add)
+            lines.push_back("A " + string(side) + " GTC " + price + " " + to_string(command.quantity_) + " " +
+                            to_string(command.order_id_));
+        else if (command.command_ == CommandType::Cancel)
+            lines.push_back("C " + to_string(command.order_id_));
+        else
+            lines.push_back("M " + to_string(command.order_id_) + " " + side + " " + price + " " +
+                            to_string(command.quantity_));
+        stream_bytes += wire::encode(command, stream.data() + stream_bytes);
+    }
+    stream.resize(stream_bytes);
+    if (write_path != nullptr) {
+        ofstream out(write_path, ios::binary);
+        out.write(reinterpret_cast<const char*>(stream.data()), static_cast<streamsize>(stream.size()));
+        cout << "Wrote " << stream.size() << " bytes (" << num_messages << " messages) to " << write_path << endl;
+    }
+
+    auto report = [&](const char* what, uint64_t ns) {
+        cout << what << num_messages * 1e9 / ns << " msgs/sec (" << static_cast<double>(ns) / num_messages
+             << " ns/msg)" << endl;
+    };
+
+    // Text: one line at a time, as the REPL does
+    vector<OrderCommand> text_decoded(num_messages);
+    uint64_t start_t = get_time_nanoseconds();
+    for (size_t i = 0; i < num_messages; ++i)
+        text_decoded[i] = parse_text(lines[i], tick_size);
+    report("Text parse:    ", get_time_nanoseconds() - start_t);
+
+    // Binary: batches of 1024 commands out of the contiguous stream
+    vector<OrderCommand> decoded(num_messages);
+    size_t decoded_count = 0;
+    std::span<const std::byte> remaining(stream);
+    start_t = get_time_nanoseconds();
+    while (!remaining.empty()) {
+        auto out = std::span<OrderCommand>(decoded).subspan(decoded_count, std::min<size_t>(1024, num_messages - decoded_count));
+        auto result = wire::decode_batch(remaining, out);
+        decoded_count += result.commands_;
+        remaining = remaining.subspan(result.bytes_);
+        if (result.malformed_ || result.commands_ == 0)
+            break;
+    }
+    report("Binary decode: ", get_time_nanoseconds() - start_t);
+
+    bool same = decoded_count == num_messages;
+    for (size_t i = 0; same && i < num_messages; ++i)
+        same = decoded[i].command_ == text_decoded[i].command_ && decoded[i].order_id_ == text_decoded[i].order_id_ &&
+               decoded[i].price_ == text_decoded[i].price_ && decoded[i].quantity_ == text_decoded[i].quantity_;
+    cout << "Decoded commands " << (same ? "match" : "DO NOT match") << " the text parse" << endl;
+
+    // Matching alone, on the decoded commands
+    MemoryPool<Order> order_pool(num_messages);
+    OrderBookConfig config{.tick_size_ = tick_size};
+    config.expected_orders_ = num_messages;
+    OrderBook book(config);
+    TradeInfos trades;
+    trades.trades_made_.reserve(1024);
+    start_t = get_time_nanoseconds();
+    for (const auto& command : decoded) {
+        trades.trades_made_.clear();
+        switch (command.command_) {
+        case CommandType::Add:
+            book.add_order(make_intrusive_pooled_order(&order_pool, command.order_type_, command.side_,
+                                                       command.order_id_, command.price_, command.quantity_),
+                           trades, command.timestamp_);
+            break;
+        case CommandType::Cancel:
+            book.cancel_order(command.order_id_);
+            break;
+        case CommandType::Modify:
+            book.modify_order(OrderModify(&order_pool, command.order_type_, command.side_, command.order_id_,
+                                          command.price_, command.quantity_),
+                              trades, command.timestamp_);
+            break;
+        case CommandType::MassCancel:
+            book.mass_cancel(command.side_);
+            break;
+        case CommandType::AdvanceTime:
+            book.advance_time(command.timestamp_);
+            break;
+        }
+    }
+    report("Match:         ", get_time_nanoseconds() - start_t);
+    return same ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+
+#include "include/CommandLog.hpp"
+#include "include/OrderBook.hpp"
+#include "include/TickSize.hpp"
+
+using namespace std;
+
+// Replays a recorded command log against a fresh book as fast as it can:
+// the file is mapped, parsed in place and matched on this thread. Reports
+// msgs/sec over the whole log, per-command latency percentiles and the final
+// book checksum (equal logs and configs must give equal checksums).
+//
+//   replay [--binary] [--ladder] [--direct-index] [--sample N] [--orders N] LOG
+//
+// LOG holds A/C/M text lines (OrderbookTest/TestFiles) or, with --binary,
+// BinaryProtocol messages (e.g. from protocol_perf --write). --sample N times
+// every Nth command, 0 none; --orders sizes the pool and order table.
+
+int main(int argc, char** argv) {
+    const TickSize tick_size{};
+    OrderBookConfig config{.tick_size_ = tick_size};
+    ReplayOptions options;
+    size_t expected_orders = 1'000'000;
+    const char* path = nullptr;
+    for (int arg = 1; arg < argc; ++arg) {
+        if (std::strcmp(argv[arg], "--binary") == 0)
+            options.format_ = LogFormat::Binary;
+        else if (std::strcmp(argv[arg], "--ladder") == 0) {
+            // Same band as the other benchmarks: 20.00-230.00
+            config.ladder_base_price_ = tick_size.to_ticks(20.0);
+            config.ladder_levels_ = 21'000;
+        } else if (std::strcmp(argv[arg], "--direct-index") == 0)
+            config.order_index_mode_ = OrderIndexMode::Direct;
+        else if (std::strcmp(argv[arg], "--sample") == 0 && arg + 1 < argc)
+            options.latency_sample_ = static_cast<uint32_t>(std::strtoul(argv[++arg], nullptr, 10));
+        else if (std::strcmp(argv[arg], "--orders") == 0 && arg + 1 < argc)
+            expected_orders = std::strtoull(argv[++arg], nullptr, 10);
+        else
+            path = argv[arg];
+    }
+    if (path == nullptr) {
+        cerr << "usage: replay [--binary] [--ladder] [--direct-index] [--sample N] [--orders N] LOG" << endl;
+        return 2;
+    }
+    config.expected_orders_ = expected_orders;
+    config.single_writer_ = true; // only this thread touches the book
+
+    try {
+        MappedFile log(path);
+        MemoryPool<Order> order_pool(expected_orders);
+        OrderBook book(config);
+        const auto stats = replay_command_log(book, order_pool, log.bytes(), options);
+
+        cout << "Replayed " << stats.messages_ << " commands from " << path << " (" << log.bytes().size()
+             << " bytes) in " << stats.elapsed_ns_ / 1e6 << " ms" << endl;
+        cout << "Throughput: " << stats.messages_per_second() << " msgs/sec ("
+             << static_cast<double>(stats.elapsed_ns_) / max<uint64_t>(stats.messages_, 1) << " ns/msg)" << endl;
+        cout << "Trades: " << stats.trades_ << ", resting orders: " << book.Size() << endl;
+        if (stats.skipped_ != 0)
+            cout << "Skipped lines: " << stats.skipped_ << endl;
+        if (stats.malformed_)
+            cout << "Stopped at a malformed or truncated message" << endl;
+
+        const char* names[] = {"Add", "Cancel", "Modify", "MassCancel", "AdvanceTime"};
+        if (options.latency_sample_ != 0)
+            cout << endl << "Latency (ns)  samples        avg     p50     p99   p99.9  p99.99      max" << endl;
+        for (size_t type = 0; type < stats.latency_.size(); ++type) {
+            const auto& latency = stats.latency_[type];
+            if (latency.count() == 0)
+                continue;
+            cout << left << setw(11) << names[type] << right << setw(10) << latency.count() << setw(11) << fixed
+                 << setprecision(1) << latency.mean() << setw(8) << latency.percentile(50) << setw(8)
+                 << latency.percentile(99) << setw(8) << latency.percentile(99.9) << setw(8)
+                 << latency.percentile(99.99) << setw(9) << latency.max() << endl;
+        }
+        cout << endl << "Book checksum: 0x" << hex << setw(16) << setfill('0') << stats.checksum_ << dec << endl;
+        return stats.malformed_ ? 1 : 0;
+    } catch (const std::exception& error) {
+        cerr << "replay: " << error.what() << endl;
+        return 1;
+    }
+}
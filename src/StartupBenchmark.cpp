@@ -0,0 +1,158 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "include/OrderBook.hpp"
+#include "include/OrderBookConfig.hpp"
+#include "include/PooledShared.hpp"
+#include "include/TickSize.hpp"
+
+using namespace std;
+
+// Construction time and resident memory per OrderBook for a few capacity
+// configurations. Books of each configuration are kept alive together, so the
+// RSS delta divided by the count is what one more such book costs. Each case
+// runs in its own process so it cannot reuse heap freed by the previous one.
+// Then a book of N resting orders is rebuilt two ways: replaying its adds
+// through add_order, and restore_state() from a save_state() image.
+//
+//   startup_perf [--restore-orders N]
+
+uint64_t get_time_nanoseconds() {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+}
+
+size_t resident_bytes() {
+    size_t pages = 0, resident = 0;
+    std::ifstream statm("/proc/self/statm");
+    statm >> pages >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+struct StartupCase {
+    string name_;
+    OrderBookConfig config_;
+    int books_;
+};
+
+// Fills a book with num_orders non-crossing orders, then times rebuilding it
+void restore_benchmark(size_t num_orders) {
+    const TickSize tick_size{};
+    OrderBookConfig config{.tick_size_ = tick_size};
+    config.ladder_base_price_ = tick_size.to_ticks(20.0);
+    config.ladder_levels_ = 21'000;
+    config.expected_orders_ = num_orders;
+
+    struct Add {
+        OrderSide side_;
+        Price price_;
+        Quantity quantity_;
+    };
+    std::mt19937 rng(42);
+    std::normal_distribution<double> offset_dist(0.0, 200.0);
+    std::uniform_int_distribution<int> qty_dist(1, 1000);
+    const Price mid = tick_size.to_ticks(125.0);
+    vector<Add> adds(num_orders);
+    for (size_t i = 0; i < num_orders; ++i) {
+        adds[i].side_ = i % 2 ? OrderSide::Buy : OrderSide::Sell;
+        const Price offset = 1 + static_cast<Price>(std::abs(offset_dist(rng)));
+        adds[i].price_ = adds[i].side_ == OrderSide::Buy ? mid - offset : mid + offset;
+        adds[i].quantity_ = qty_dist(rng);
+    }
+
+    MemoryPool<Order> replay_pool(num_orders);
+    OrderBook replayed(config);
+    uint64_t start_t = get_time_nanoseconds();
+    for (size_t i = 0; i < num_orders; ++i)
+        replayed.add_order(make_intrusive_pooled_order(&replay_pool, OrderType::GoodTillCancel, adds[i].side_,
+                                                       static_cast<OrderId>(i + 1), adds[i].price_, adds[i].quantity_));
+    const uint64_t replay_t = get_time_nanoseconds() - start_t;
+
+    start_t = get_time_nanoseconds();
+    const auto image = replayed.save_state();
+    const uint64_t save_t = get_time_nanoseconds() - start_t;
+
+    MemoryPool<Order> restore_pool(num_orders);
+    OrderBook restored(config);
+    start_t = get_time_nanoseconds();
+    restored.restore_state(image, restore_pool);
+    const uint64_t restore_t = get_time_nanoseconds() - start_t;
+
+    cout << endl << "Rebuilding a book of " << replayed.Size() << " resting orders:" << endl;
+    cout << "replay through add_order: " << replay_t / 1e6 << " ms" << endl;
+    cout << "save_state: " << save_t / 1e6 << " ms, " << image.size() / (1024.0 * 1024.0) << " MiB" << endl;
+    cout << "restore_state: " << restore_t / 1e6 << " ms ("
+         << static_cast<double>(restore_t) / max<size_t>(restored.Size(), 1) << " ns/order), "
+         << (restored.save_state() == image ? "identical" : "DIFFERENT") << " state" << endl;
+}
+
+int main(int argc, char** argv) {
+    size_t restore_orders = 3'000'000;
+    for (int arg = 1; arg < argc; ++arg) {
+        if (std::strcmp(argv[arg], "--restore-orders") == 0 && arg + 1 < argc)
+            restore_orders = std::strtoull(argv[++arg], nullptr, 10);
+    }
+    const TickSize tick_size{};
+    vector<StartupCase> cases;
+
+    OrderBookConfig lazy;
+    lazy.growth_policy_ = GrowthPolicy::Lazy;
+    cases.push_back({"lazy (illiquid)", lazy, 2000});
+
+    cases.push_back({"default (4k orders, 256 levels)", OrderBookConfig{}, 2000});
+
+    OrderBookConfig large;
+    large.expected_orders_ = 3'000'000;
+    large.expected_levels_ = 20'000;
+    cases.push_back({"reserve 3M orders, 20k levels", large, 4});
+
+    OrderBookConfig large_prefault = large;
+    large_prefault.prefault_ = true;
+    cases.push_back({"reserve 3M orders, 20k levels, prefault", large_prefault, 4});
+
+    OrderBookConfig ladder;
+    ladder.ladder_base_price_ = tick_size.to_ticks(20.0);
+    ladder.ladder_levels_ = 21'000;
+    cases.push_back({"default + 21k-tick ladder", ladder, 50});
+
+    OrderBookConfig direct;
+    direct.order_index_mode_ = OrderIndexMode::Direct;
+    direct.order_index_base_id_ = 1;
+    direct.expected_orders_ = 1'000'000;
+    cases.push_back({"direct index, 1M ids reserved", direct, 4});
+
+    for (const auto& startup_case : cases) {
+        cout.flush();
+        pid_t child = fork();
+        if (child != 0) {
+            waitpid(child, nullptr, 0);
+            continue;
+        }
+
+        vector<unique_ptr<OrderBook>> books;
+        books.reserve(startup_case.books_);
+        size_t rss_before = resident_bytes();
+        uint64_t start_t = get_time_nanoseconds();
+        for (int i = 0; i < startup_case.books_; ++i)
+            books.push_back(make_unique<OrderBook>(startup_case.config_));
+        uint64_t elapsed_t = get_time_nanoseconds() - start_t;
+        size_t rss_after = resident_bytes();
+
+        cout << startup_case.name_ << ": " << startup_case.books_ << " books, "
+             << elapsed_t / 1000.0 / startup_case.books_ << " us/book, "
+             << (rss_after - rss_before) / 1024.0 / startup_case.books_ << " KiB RSS/book" << endl;
+        _exit(0);
+    }
+    cout.flush();
+    restore_benchmark(restore_orders);
+    return 0;
+}
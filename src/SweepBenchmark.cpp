@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "include/OrderBook.hpp"
+#include "include/PooledShared.hpp"
+#include "include/TickSize.hpp"
+#include "perf_utils/LatencyStats.hpp"
+
+using namespace std;
+
+// Deep sweeps: one aggressive order that trades through --levels ask levels
+// of --per-level resting orders each, --rounds times. Before every round the
+// ask side is refilled outside the timed window; only the one aggressive call
+// is timed. Reported as fills/sec and ns per fill.
+//
+//   sweep_perf [--levels N] [--per-level N] [--rounds N] [--ladder] [--level-deltas] [--order-events]
+//
+// 1. Limit: a GoodTillCancel buy priced at the last level, sized to take the
+//    whole side, which is queued and then matched level against level.
+// 2. Market: a market buy of the same size, which sweeps without resting.
+
+uint64_t get_time_nanoseconds() {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+}
+
+int main(int argc, char** argv) {
+    const TickSize tick_size{};
+    OrderBookConfig config{.tick_size_ = tick_size};
+    size_t levels = 20;
+    size_t per_level = 50;
+    size_t rounds = 2'000;
+    for (int arg = 1; arg < argc; ++arg) {
+        if (std::strcmp(argv[arg], "--levels") == 0 && arg + 1 < argc)
+            levels = std::max<size_t>(1, std::strtoull(argv[++arg], nullptr, 10));
+        else if (std::strcmp(argv[arg], "--per-level") == 0 && arg + 1 < argc)
+            per_level = std::max<size_t>(1, std::strtoull(argv[++arg], nullptr, 10));
+        else if (std::strcmp(argv[arg], "--rounds") == 0 && arg + 1 < argc)
+            rounds = std::max<size_t>(1, std::strtoull(argv[++arg], nullptr, 10));
+        else if (std::strcmp(argv[arg], "--level-deltas") == 0)
+            config.level_delta_capacity_ = 1 << 16;
+        else if (std::strcmp(argv[arg], "--order-events") == 0)
+            config.order_event_capacity_ = 1 << 20;
+        else if (std::strcmp(argv[arg], "--ladder") == 0) {
+            config.ladder_base_price_ = tick_size.to_ticks(20.0);
+            config.ladder_levels_ = 21'000;
+        }
+    }
+    const size_t resting = levels * per_level;
+    config.expected_orders_ = resting + 1;
+    const Price mid = tick_size.to_ticks(125.0);
+    const Quantity order_quantity = 100;
+    const auto sweep_quantity = static_cast<Quantity>(resting * order_quantity);
+
+    auto run = [&](OrderType type, const char* name) {
+        MemoryPool<Order> pool(resting + 1);
+        OrderBook book(config);
+        std::vector<uint64_t> sweeps;
+        sweeps.reserve(rounds);
+        uint64_t total_ns = 0;
+        size_t fills = 0;
+        size_t deltas = 0;
+        OrderEvent event;
+        auto count_fill = [&fills](const TradeInfo&) { ++fills; };
+        OrderId id = 0;
+        for (size_t round = 0; round < rounds; ++round) {
+            for (size_t level = 0; level < levels; ++level)
+                for (size_t i = 0; i < per_level; ++i)
+                    book.add_order(make_intrusive_pooled_order(&pool, OrderType::GoodTillCancel, OrderSide::Sell, ++id,
+                                                               mid + static_cast<Price>(level), order_quantity));
+            if (config.level_delta_capacity_ != 0)
+                book.drain_level_deltas([&deltas](const auto&) { ++deltas; });
+            while (book.try_poll_order_event(event)) {
+            }
+
+            auto order = make_intrusive_pooled_order(&pool, type, OrderSide::Buy, ++id,
+                                                     mid + static_cast<Price>(levels - 1), sweep_quantity);
+            const uint64_t start_t = get_time_nanoseconds();
+            book.add_order(std::move(order), count_fill);
+            const uint64_t elapsed = get_time_nanoseconds() - start_t;
+            sweeps.push_back(elapsed);
+            total_ns += elapsed;
+            if (config.level_delta_capacity_ != 0)
+                book.drain_level_deltas([&deltas](const auto&) { ++deltas; });
+            while (book.try_poll_order_event(event)) {
+            }
+        }
+        cout << endl << name << ": " << fills << " fills in " << total_ns / 1e6 << " ms, "
+             << fills * 1e9 / max<uint64_t>(total_ns, 1) << " fills/sec, "
+             << static_cast<double>(total_ns) / max<size_t>(fills, 1) << " ns/fill, " << book.Size()
+             << " left resting" << endl;
+        cout << "Sweep latency (ns):" << endl;
+        appendLatencyStatsToFile(computeLatencyStats(sweeps));
+    };
+
+    cout << rounds << " sweeps through " << levels << " levels x " << per_level << " orders"
+         << (config.ladder_levels_ != 0 ? ", dense ladder" : "")
+         << (config.level_delta_capacity_ != 0 ? ", L2 delta feed on" : "")
+         << (config.order_event_capacity_ != 0 ? ", L3 events on" : "") << endl;
+    run(OrderType::GoodTillCancel, "Limit (queued, then matched)");
+    run(OrderType::Market, "Market (swept)");
+    return 0;
+}
@@ -0,0 +1,304 @@
+#pragma once
+#include "OrderCommand.hpp"
+#include "OrderSide.hpp"
+#include "OrderType.hpp"
+#include "Usings.hpp"
+#include "constants.hpp"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <type_traits>
+
+// Binary order entry: fixed-layout little-endian messages, back to back in a
+// byte stream with no framing beyond the leading type byte. Every field sits at
+// its natural alignment, so the structs below are the wire layout; they are
+// copied out of the buffer with memcpy and need no alignment from it.
+namespace wire {
+
+enum class MessageType : std::uint8_t {
+  Add = 'A',
+  AddGoodTillDate = 'D',
+  Cancel = 'X',
+  Modify = 'M',
+  MassCancel = 'Q',
+  Time = 'T'
+};
+
+// side_ values; MassCancel also accepts BothSides
+constexpr std::uint8_t Buy = 0;
+constexpr std::uint8_t Sell = 1;
+constexpr std::uint8_t BothSides = 2;
+
+struct AddMessage {
+  MessageType type_ = MessageType::Add;
+  std::uint8_t order_type_ = 0; // OrderType
+  std::uint8_t side_ = Buy;
+  std::uint8_t reserved_ = 0;
+  std::uint32_t symbol_ = 0;
+  std::uint32_t order_id_ = 0;
+  std::uint32_t quantity_ = 0;
+  std::int64_t price_ = 0; // ticks
+};
+
+// A GoodTillDate order with its expiry; Modify keeps the order's expiry
+struct AddGoodTillDateMessage {
+  MessageType type_ = MessageType::AddGoodTillDate;
+  std::uint8_t order_type_ = 0;
+  std::uint8_t side_ = Buy;
+  std::uint8_t reserved_ = 0;
+  std::uint32_t symbol_ = 0;
+  std::uint32_t order_id_ = 0;
+  std::uint32_t quantity_ = 0;
+  std::int64_t price_ = 0;
+  std::uint64_t expiry_ = 0; // nanoseconds since the Unix epoch
+};
+
+struct CancelMessage {
+  MessageType type_ = MessageType::Cancel;
+  std::uint8_t reserved_[3] = {};
+  std::uint32_t symbol_ = 0;
+  std::uint32_t order_id_ = 0;
+};
+
+// Same layout as Add: the order is replaced with these fields
+struct ModifyMessage {
+  MessageType type_ = MessageType::Modify;
+  std::uint8_t order_type_ = 0;
+  std::uint8_t side_ = Buy;
+  std::uint8_t reserved_ = 0;
+  std::uint32_t symbol_ = 0;
+  std::uint32_t order_id_ = 0;
+  std::uint32_t quantity_ = 0;
+  std::int64_t price_ = 0;
+};
+
+struct MassCancelMessage {
+  MessageType type_ = MessageType::MassCancel;
+  std::uint8_t side_ = BothSides;
+  std::uint8_t reserved_[2] = {};
+  std::uint32_t symbol_ = 0;
+};
+
+// Replayed clock: moves the symbol's book to timestamp_
+struct TimeMessage {
+  MessageType type_ = MessageType::Time;
+  std::uint8_t reserved_[3] = {};
+  std::uint32_t symbol_ = 0;
+  std::uint64_t timestamp_ = 0; // nanoseconds since the Unix epoch
+};
+
+static_assert(sizeof(AddMessage) == 24 && std::is_trivially_copyable_v<AddMessage>);
+static_assert(sizeof(AddGoodTillDateMessage) == 32 && std::is_trivially_copyable_v<AddGoodTillDateMessage>);
+static_assert(sizeof(CancelMessage) == 12 && std::is_trivially_copyable_v<CancelMessage>);
+static_assert(sizeof(ModifyMessage) == 24 && std::is_trivially_copyable_v<ModifyMessage>);
+static_assert(sizeof(MassCancelMessage) == 8 && std::is_trivially_copyable_v<MassCancelMessage>);
+static_assert(sizeof(TimeMessage) == 16 && std::is_trivially_copyable_v<TimeMessage>);
+
+// Wire size of a message starting with type, 0 if the type is unknown
+constexpr std::size_t message_size(std::uint8_t type) {
+  switch (static_cast<MessageType>(type)) {
+  case MessageType::Add: return sizeof(AddMessage);
+  case MessageType::AddGoodTillDate: return sizeof(AddGoodTillDateMessage);
+  case MessageType::Cancel: return sizeof(CancelMessage);
+  case MessageType::Modify: return sizeof(ModifyMessage);
+  case MessageType::MassCancel: return sizeof(MassCancelMessage);
+  case MessageType::Time: return sizeof(TimeMessage);
+  }
+  return 0;
+}
+
+// Little-endian <-> host; a no-op on little-endian hosts
+template <typename T> constexpr T little_endian(T value) {
+  if constexpr (std::endian::native == std::endian::little || sizeof(T) == 1) {
+    return value;
+  } else {
+    using Bits = std::make_unsigned_t<T>;
+    auto bits = static_cast<Bits>(value);
+    Bits swapped = 0;
+    for (std::size_t byte = 0; byte < sizeof(T); ++byte, bits >>= 8)
+      swapped = static_cast<Bits>((swapped << 8) | (bits & 0xff));
+    return static_cast<T>(swapped);
+  }
+}
+
+struct DecodeResult {
+  std::size_t commands_ = 0; // commands written
+  std::size_t bytes_ = 0;    // bytes consumed: whole messages only
+  bool malformed_ = false;   // stopped at an unknown type or an out-of-range field
+};
+
+namespace detail {
+
+inline bool valid_order_type(std::uint8_t type) {
+  return type <= static_cast<std::uint8_t>(OrderType::GoodTillDate);
+}
+
+// The unsigned wire fields must fit the engine's signed Quantity and OrderId:
+// a quantity of 1 to INT32_MAX, an id up to INT32_MAX, and a price in ticks
+// from 0 (market sell) up to below Constants::MarketBuyPrice
+inline bool valid_order_id(std::uint32_t order_id) {
+  return order_id <= static_cast<std::uint32_t>(std::numeric_limits<OrderId>::max());
+}
+
+inline bool valid_order_fields(std::uint32_t order_id, std::uint32_t quantity, std::int64_t price) {
+  return valid_order_id(order_id) && quantity != 0 &&
+         quantity <= static_cast<std::uint32_t>(std::numeric_limits<Quantity>::max()) && price >= 0 &&
+         price < Constants::MarketBuyPrice;
+}
+
+template <typename Message> Message load(const std::byte *data) {
+  Message message;
+  std::memcpy(&message, data, sizeof(Message));
+  return message;
+}
+
+} // namespace detail
+
+// Decodes as many whole messages from buffer as fit in out. A message cut off
+// at the end of buffer, or one that would not fit in out, is left unconsumed
+// for the next call. A MassCancel for both sides becomes two commands.
+inline DecodeResult decode_batch(std::span<const std::byte> buffer, std::span<OrderCommand> out) {
+  DecodeResult result;
+  const auto *data = buffer.data();
+  const auto size = buffer.size();
+  while (result.bytes_ < size && result.commands_ < out.size()) {
+    const auto *message = data + result.bytes_;
+    const auto type = std::to_integer<std::uint8_t>(message[0]);
+    const auto length = message_size(type);
+    if (length == 0) [[unlikely]] {
+      result.malformed_ = true;
+      break;
+    }
+    if (size - result.bytes_ < length)
+      break;
+
+    auto &command = out[result.commands_];
+    command = OrderCommand{};
+    switch (static_cast<MessageType>(type)) {
+    case MessageType::Add:
+    case MessageType::AddGoodTillDate:
+    case MessageType::Modify: {
+      // Identical layouts, up to the GoodTillDate expiry
+      auto add = detail::load<AddMessage>(message);
+      if (add.side_ > Sell || !detail::valid_order_type(add.order_type_) ||
+          !detail::valid_order_fields(little_endian(add.order_id_), little_endian(add.quantity_),
+                                      little_endian(add.price_))) [[unlikely]] {
+        result.malformed_ = true;
+        return result;
+      }
+      command.command_ = type == static_cast<std::uint8_t>(MessageType::Modify) ? CommandType::Modify
+                                                                                 : CommandType::Add;
+      command.order_type_ = static_cast<OrderType>(add.order_type_);
+      command.side_ = static_cast<OrderSide>(add.side_);
+      command.symbol_ = little_endian(add.symbol_);
+      command.order_id_ = static_cast<OrderId>(little_endian(add.order_id_));
+      command.quantity_ = static_cast<Quantity>(little_endian(add.quantity_));
+      command.price_ = little_endian(add.price_);
+      if (type == static_cast<std::uint8_t>(MessageType::AddGoodTillDate))
+        command.timestamp_ = little_endian(detail::load<AddGoodTillDateMessage>(message).expiry_);
+      break;
+    }
+    case MessageType::Cancel: {
+      auto cancel = detail::load<CancelMessage>(message);
+      if (!detail::valid_order_id(little_endian(cancel.order_id_))) [[unlikely]] {
+        result.malformed_ = true;
+        return result;
+      }
+      command.command_ = CommandType::Cancel;
+      command.symbol_ = little_endian(cancel.symbol_);
+      command.order_id_ = static_cast<OrderId>(little_endian(cancel.order_id_));
+      break;
+    }
+    case MessageType::MassCancel: {
+      auto mass = detail::load<MassCancelMessage>(message);
+      if (mass.side_ > BothSides) [[unlikely]] {
+        result.malformed_ = true;
+        return result;
+      }
+      command.command_ = CommandType::MassCancel;
+      command.symbol_ = little_endian(mass.symbol_);
+      command.side_ = mass.side_ == Sell ? OrderSide::Sell : OrderSide::Buy;
+      if (mass.side_ == BothSides) {
+        if (result.commands_ + 2 > out.size())
+          return result; // retried with room for both halves
+        auto &sell = out[result.commands_ + 1];
+        sell = command;
+        sell.side_ = OrderSide::Sell;
+        ++result.commands_;
+      }
+      break;
+    }
+    case MessageType::Time: {
+      auto time = detail::load<TimeMessage>(message);
+      command.command_ = CommandType::AdvanceTime;
+      command.symbol_ = little_endian(time.symbol_);
+      command.timestamp_ = little_endian(time.timestamp_);
+      break;
+    }
+    }
+    ++result.commands_;
+    result.bytes_ += length;
+  }
+  return result;
+}
+
+// Appends the wire form of command to out, which must have room for the
+// largest message; returns the bytes written
+inline std::size_t encode(const OrderCommand &command, std::byte *out) {
+  switch (command.command_) {
+  case CommandType::Add:
+  case CommandType::Modify: {
+    if (command.command_ == CommandType::Add && command.order_type_ == OrderType::GoodTillDate) {
+      AddGoodTillDateMessage message;
+      message.order_type_ = static_cast<std::uint8_t>(command.order_type_);
+      message.side_ = command.side_ == OrderSide::Sell ? Sell : Buy;
+      message.symbol_ = little_endian(command.symbol_);
+      message.order_id_ = little_endian(static_cast<std::uint32_t>(command.order_id_));
+      message.quantity_ = little_endian(static_cast<std::uint32_t>(command.quantity_));
+      message.price_ = little_endian(command.price_);
+      message.expiry_ = little_endian(command.timestamp_);
+      std::memcpy(out, &message, sizeof(message));
+      return sizeof(message);
+    }
+    AddMessage message;
+    message.type_ = command.command_ == CommandType::Add ? MessageType::Add : MessageType::Modify;
+    message.order_type_ = static_cast<std::uint8_t>(command.order_type_);
+    message.side_ = command.side_ == OrderSide::Sell ? Sell : Buy;
+    message.symbol_ = little_endian(command.symbol_);
+    message.order_id_ = little_endian(static_cast<std::uint32_t>(command.order_id_));
+    message.quantity_ = little_endian(static_cast<std::uint32_t>(command.quantity_));
+    message.price_ = little_endian(command.price_);
+    std::memcpy(out, &message, sizeof(message));
+    return sizeof(message);
+  }
+  case CommandType::Cancel: {
+    CancelMessage message;
+    message.symbol_ = little_endian(command.symbol_);
+    message.order_id_ = little_endian(static_cast<std::uint32_t>(command.order_id_));
+    std::memcpy(out, &message, sizeof(message));
+    return sizeof(message);
+  }
+  case CommandType::MassCancel: {
+    MassCancelMessage message;
+    message.side_ = command.side_ == OrderSide::Sell ? Sell : Buy;
+    message.symbol_ = little_endian(command.symbol_);
+    std::memcpy(out, &message, sizeof(message));
+    return sizeof(message);
+  }
+  case CommandType::AdvanceTime: {
+    TimeMessage message;
+    message.symbol_ = little_endian(command.symbol_);
+    message.timestamp_ = little_endian(command.timestamp_);
+    std::memcpy(out, &message, sizeof(message));
+    return sizeof(message);
+  }
+  }
+  return 0;
+}
+
+constexpr std::size_t MaxMessageSize = sizeof(AddGoodTillDateMessage);
+
+} // namespace wire
@@ -0,0 +1,109 @@
+#pragma once
+#include "LevelInfo.hpp"
+#include "Usings.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Reader-side copy of the published top-N depth, best level first per side.
+// Keep one per reader thread: reads only write into its preallocated storage.
+struct BookSnapshot {
+  std::uint64_t sequence_ = 0; // publications so far, 0 = nothing published yet
+  std::size_t bid_count_ = 0;
+  std::size_t ask_count_ = 0;
+  std::vector<LevelInfo> bids_;
+  std::vector<LevelInfo> asks_;
+
+  explicit BookSnapshot(std::size_t depth = 0) : bids_(depth), asks_(depth) {}
+};
+
+// Seqlock over a flat top-N depth array. The single thread that mutates the
+// book publishes after each event; any number of readers copy a consistent
+// view without touching the book mutex and without allocating. Slots are
+// relaxed atomics, so a read that overlaps a publish is caught by the sequence
+// check and retried instead of being a data race.
+class SnapshotPublisher {
+public:
+  explicit SnapshotPublisher(std::size_t depth)
+      : depth_(depth), bids_(depth ? std::make_unique<Slot[]>(depth) : nullptr),
+        asks_(depth ? std::make_unique<Slot[]>(depth) : nullptr) {}
+
+  std::size_t depth() const { return depth_; }
+  bool enabled() const { return depth_ != 0; }
+
+  // Writer: begin_publish(), set_bid/set_ask for slots [0, count), end_publish()
+  void begin_publish() {
+    auto sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  void set_bid(std::size_t slot, const LevelInfo &level) { bids_[slot].store(level); }
+  void set_ask(std::size_t slot, const LevelInfo &level) { asks_[slot].store(level); }
+
+  void end_publish(std::size_t bid_count, std::size_t ask_count) {
+    bid_count_.store(bid_count, std::memory_order_relaxed);
+    ask_count_.store(ask_count, std::memory_order_relaxed);
+    sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  // Returns false if a publish was in progress or landed during the copy
+  bool try_read(BookSnapshot &out) const {
+    auto before = sequence_.load(std::memory_order_acquire);
+    if (before & 1)
+      return false;
+    if (out.bids_.size() < depth_) { // only on a snapshot sized for a smaller depth
+      out.bids_.resize(depth_);
+      out.asks_.resize(depth_);
+    }
+    auto bid_count = bid_count_.load(std::memory_order_relaxed);
+    auto ask_count = ask_count_.load(std::memory_order_relaxed);
+    for (std::size_t slot = 0; slot < bid_count; ++slot)
+      out.bids_[slot] = bids_[slot].load();
+    for (std::size_t slot = 0; slot < ask_count; ++slot)
+      out.asks_[slot] = asks_[slot].load();
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence_.load(std::memory_order_relaxed) != before)
+      return false;
+    out.sequence_ = before / 2;
+    out.bid_count_ = bid_count;
+    out.ask_count_ = ask_count;
+    return true;
+  }
+
+  void read(BookSnapshot &out) const {
+    while (!try_read(out)) {
+    }
+  }
+
+  // Completed publications; cheap check for "anything new since my last read"
+  std::uint64_t sequence() const { return sequence_.load(std::memory_order_acquire) / 2; }
+
+private:
+  struct Slot {
+    std::atomic<Price> price_{0};
+    std::atomic<Quantity> quantity_{0};
+    std::atomic<int> count_{0};
+
+    void store(const LevelInfo &level) {
+      price_.store(level.price_, std::memory_order_relaxed);
+      quantity_.store(level.quantity_, std::memory_order_relaxed);
+      count_.store(level.count_, std::memory_order_relaxed);
+    }
+    LevelInfo load() const {
+      return LevelInfo{price_.load(std::memory_order_relaxed),
+                       quantity_.load(std::memory_order_relaxed),
+                       count_.load(std::memory_order_relaxed)};
+    }
+  };
+
+  std::size_t depth_;
+  std::unique_ptr<Slot[]> bids_;
+  std::unique_ptr<Slot[]> asks_;
+  std::atomic<std::size_t> bid_count_{0};
+  std::atomic<std::size_t> ask_count_{0};
+  // Odd while a publish is in progress; on its own line away from the writer's slots
+  alignas(64) std::atomic<std::uint64_t> sequence_{0};
+};
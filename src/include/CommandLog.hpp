@@ -0,0 +1,103 @@
+#pragma once
+#include "MemoryPool.hpp"
+#include "Order.hpp"
+#include "OrderCommand.hpp"
+#include "Usings.hpp"
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+class OrderBook;
+
+// Recorded command logs, replayed straight out of a read-only file mapping:
+// lines and messages are parsed in place, never copied out of the page cache.
+enum class LogFormat : std::uint8_t {
+  Text,  // A/C/M/T lines as in OrderbookTest/TestFiles; R and unknown lines are skipped
+  Binary // BinaryProtocol messages back to back
+};
+
+// Whole file mapped read-only for sequential access. Throws std::system_error
+// if the file cannot be opened or mapped.
+class MappedFile {
+public:
+  explicit MappedFile(const std::filesystem::path &path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  std::span<const std::byte> bytes() const { return {data_, size_}; }
+
+private:
+  const std::byte *data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+// Log-linear latency histogram in fixed memory, so a 100M-message replay
+// records every sample without storing them: exact below 16ns, then 16
+// buckets per power of two (values within 1/16 of their bucket).
+class LatencyHistogram {
+public:
+  void record(std::uint64_t ns) {
+    ++counts_[bucket(ns)];
+    ++count_;
+    total_ += ns;
+    max_ = ns > max_ ? ns : max_;
+  }
+
+  std::uint64_t count() const { return count_; }
+  std::uint64_t max() const { return max_; }
+  double mean() const { return count_ == 0 ? 0.0 : static_cast<double>(total_) / count_; }
+  // Upper bound of the bucket holding the pct-th percentile sample
+  std::uint64_t percentile(double pct) const;
+
+private:
+  static constexpr unsigned SubBits = 4;
+  static constexpr std::size_t Buckets = (64 - SubBits + 1) << SubBits;
+
+  static std::size_t bucket(std::uint64_t ns) {
+    if (ns < (1u << SubBits))
+      return static_cast<std::size_t>(ns);
+    const unsigned msb = std::bit_width(ns) - 1;
+    const unsigned shift = msb - SubBits;
+    return ((msb - SubBits + 1) << SubBits) + static_cast<std::size_t>((ns >> shift) & ((1u << SubBits) - 1));
+  }
+
+  std::array<std::uint64_t, Buckets> counts_{};
+  std::uint64_t count_ = 0;
+  std::uint64_t total_ = 0;
+  std::uint64_t max_ = 0;
+};
+
+struct ReplayOptions {
+  LogFormat format_ = LogFormat::Text;
+  // Time every Nth command into ReplayStats::latency_; 0 = no timing (two
+  // clock reads per command are a measurable share of a ~300ns add)
+  std::uint32_t latency_sample_ = 1;
+};
+
+struct ReplayStats {
+  std::uint64_t messages_ = 0; // commands applied
+  std::uint64_t skipped_ = 0;  // text lines that are not A/C/M/T commands
+  std::uint64_t trades_ = 0;
+  std::uint64_t elapsed_ns_ = 0; // parse + match, whole log
+  bool malformed_ = false;       // binary log stopped at a bad or truncated message
+  std::array<LatencyHistogram, 5> latency_; // by CommandType, match only
+  std::uint64_t checksum_ = 0;              // book_checksum() after the last command
+
+  double messages_per_second() const {
+    return elapsed_ns_ == 0 ? 0.0 : messages_ * 1e9 / static_cast<double>(elapsed_ns_);
+  }
+};
+
+// Feeds every command in log to book, allocating orders from order_pool.
+// Fills are counted, not kept.
+ReplayStats replay_command_log(OrderBook &book, MemoryPool<Order> &order_pool,
+                               std::span<const std::byte> log, const ReplayOptions &options = {});
+
+// FNV-1a over both sides' levels (price, quantity, order count) best first,
+// and the resting order count: equal books give equal checksums.
+std::uint64_t book_checksum(OrderBook &book);
@@ -48,6 +48,29 @@ public:
             // std::cout<<"DLL 3"<<std::endl;
         }
 
+    // Nodes are owned by exactly one list: moves steal them, copies are not allowed
+    CustomLinkedList(const CustomLinkedList&) = delete;
+    CustomLinkedList& operator=(const CustomLinkedList&) = delete;
+
+    CustomLinkedList(CustomLinkedList&& other) noexcept
+        : pool_(other.pool_), head_(other.head_), tail_(other.tail_), size_(other.size_) {
+            other.head_ = other.tail_ = nullptr;
+            other.size_ = 0;
+        }
+
+    CustomLinkedList& operator=(CustomLinkedList&& other) noexcept {
+        if (this != &other) {
+            clear();
+            pool_ = other.pool_;
+            head_ = other.head_;
+            tail_ = other.tail_;
+            size_ = other.size_;
+            other.head_ = other.tail_ = nullptr;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
     ~CustomLinkedList() { clear(); }
 
     auto push_back(const T& value) {
@@ -159,4 +182,88 @@ public:
     // Pool stats (from the current pool)
     size_t pool_capacity() const { return pool_->total_capacity(); }
     size_t pool_chunks() const { return pool_->chunk_count(); }
-};
\ No newline at end of file
+};
+
+// Links for IntrusiveLinkedList, embedded in the element itself. Tag lets one
+// type carry several independent hooks (one per list it can be a member of).
+template<typename T, typename Tag = void>
+struct IntrusiveListHook {
+    T* prev_ = nullptr;
+    T* next_ = nullptr;
+};
+
+// Intrusive FIFO variant of CustomLinkedList: no nodes are allocated, the
+// prev/next links live inside T. The list does not own its elements.
+template<typename T, typename Tag = void>
+class IntrusiveLinkedList {
+private:
+    using Hook = IntrusiveListHook<T, Tag>;
+    static Hook& hook(T* element) { return static_cast<Hook&>(*element); }
+
+    T* head_ = nullptr;
+    T* tail_ = nullptr;
+    size_t size_ = 0;
+
+public:
+    IntrusiveLinkedList() = default;
+    IntrusiveLinkedList(const IntrusiveLinkedList&) = delete;
+    IntrusiveLinkedList& operator=(const IntrusiveLinkedList&) = delete;
+
+    IntrusiveLinkedList(IntrusiveLinkedList&& other) noexcept
+        : head_(other.head_), tail_(other.tail_), size_(other.size_) {
+            other.head_ = other.tail_ = nullptr;
+            other.size_ = 0;
+        }
+
+    void push_back(T* element) {
+        auto& links = hook(element);
+        links.next_ = nullptr;
+        links.prev_ = tail_;
+        if (!tail_) {
+            head_ = tail_ = element;
+        } else {
+            hook(tail_).next_ = element;
+            tail_ = element;
+        }
+        size_++;
+    }
+
+    // Unlinks element, which must be in this list
+    void erase(T* element) {
+        auto& links = hook(element);
+        if (links.prev_) hook(links.prev_).next_ = links.next_; else head_ = links.next_;
+        if (links.next_) hook(links.next_).prev_ = links.prev_; else tail_ = links.prev_;
+        links.prev_ = links.next_ = nullptr;
+        size_--;
+    }
+
+    // Empties the list in O(1) without touching the elements, whose links are
+    // left stale; for a caller that is discarding all of them
+    void clear() {
+        head_ = tail_ = nullptr;
+        size_ = 0;
+    }
+
+    T* front() const { return head_; }
+    T* back() const { return tail_; }
+    static T* next(T* element) { return hook(element).next_; }
+    static T* prev(T* element) { return hook(element).prev_; }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    class iterator {
+    private:
+        T* current_;
+    public:
+        explicit iterator(T* element = nullptr) : current_(element) {}
+        T& operator*() const { return *current_; }
+        T* operator->() const { return current_; }
+        iterator& operator++() { current_ = hook(current_).next_; return *this; }
+        bool operator!=(const iterator& other) const { return current_ != other.current_; }
+        bool operator==(const iterator& other) const { return current_ == other.current_; }
+    };
+
+    iterator begin() const { return iterator(head_); }
+    iterator end() const { return iterator(nullptr); }
+};
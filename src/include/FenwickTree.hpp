@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Binary indexed tree over a fixed number of slots: point update and prefix
+// sum in O(log n).
+class FenwickTree {
+public:
+  explicit FenwickTree(std::size_t size = 0) : tree_(size + 1, 0) {}
+
+  bool empty() const { return tree_.size() <= 1; }
+  std::size_t size() const { return tree_.size() - 1; }
+
+  void add(std::size_t index, std::int64_t delta) {
+    total_ += delta;
+    for (auto i = index + 1; i < tree_.size(); i += i & (~i + 1)) {
+      tree_[i] += delta;
+    }
+  }
+
+  // Sum of slots [0, index]
+  std::int64_t prefix(std::size_t index) const {
+    std::int64_t sum = 0;
+    for (auto i = index + 1; i > 0; i -= i & (~i + 1)) {
+      sum += tree_[i];
+    }
+    return sum;
+  }
+
+  std::int64_t total() const { return total_; }
+
+private:
+  std::vector<std::int64_t> tree_; // 1-based
+  std::int64_t total_ = 0;
+};
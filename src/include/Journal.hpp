@@ -0,0 +1,208 @@
+#pragma once
+#include "MemoryPool.hpp"
+#include "Order.hpp"
+#include "OrderCommand.hpp"
+#include "OrderSide.hpp"
+#include "OrderType.hpp"
+#include "SpscRing.hpp"
+#include "TradeInfo.hpp"
+#include "Usings.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class OrderBook;
+
+enum class JournalRecordKind : std::uint8_t {
+  Command, // an accepted add/cancel/modify/mass cancel, as the book applied it
+  Trade    // a fill it caused: order_id_ bought from contra_id_
+};
+
+// Layout of JournalRecord; records of another version end a read
+constexpr std::uint8_t JournalVersion = 2;
+
+// Fixed 56-byte journal record, written to the file as is. Commands are
+// enough to rebuild the book; trades are kept for audit. GoodTillDate
+// expiries are journaled as the cancels they cause, not as time.
+struct JournalRecord {
+  std::uint64_t sequence_ = 0; // 1, 2, ... per journal; 0 = past the end of the log
+  Price price_ = 0;            // command price, or trade price
+  union {
+    Timestamp expiry_ = 0;     // Command: a GoodTillDate add/modify's expiry
+    OrderId contra_id_;        // Trade: the sell order
+  };
+  OrderId order_id_ = 0;       // command's order, or the buy order of a trade
+  Quantity quantity_ = 0;
+  SymbolId symbol_ = 0;
+  ParticipantId participant_ = 0; // Add: the order's participant, 0 = none
+  JournalRecordKind kind_ = JournalRecordKind::Command;
+  CommandType command_ = CommandType::Add;
+  std::uint8_t order_type_ = 0; // OrderType, as a byte to keep the record compact
+  std::uint8_t side_ = 0;       // OrderSide
+  std::uint8_t version_ = JournalVersion;
+  std::uint8_t reserved_[7] = {};
+  std::uint32_t checksum_ = 0;  // journal_checksum(), filled in by the writer
+};
+static_assert(std::is_trivially_copyable_v<JournalRecord>);
+static_assert(sizeof(JournalRecord) == 56);
+
+// FNV-1a over every byte of the record before checksum_, so a record torn by
+// a crash (part of it written, the rest zeros or an older write) is caught
+inline std::uint32_t journal_checksum(const JournalRecord &record) {
+  const auto *bytes = reinterpret_cast<const unsigned char *>(&record);
+  std::uint32_t hash = 2166136261u;
+  for (std::size_t i = 0; i < offsetof(JournalRecord, checksum_); ++i) {
+    hash ^= bytes[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+enum class Durability : std::uint8_t {
+  // write() every batch: survives a crash of the process, not of the machine
+  Buffered,
+  // write() every batch, fdatasync() at most once per sync_interval_
+  Periodic,
+  // fdatasync() after every batch write (group commit): everything up to
+  // durable_sequence() is on disk
+  GroupCommit
+};
+
+struct JournalConfig {
+  std::filesystem::path path_; // truncated on open
+  Durability durability_ = Durability::GroupCommit;
+  std::chrono::microseconds sync_interval_{1'000}; // Periodic only
+  // Records between the matching thread and the writer. The matching thread
+  // waits for room when it is full, so size it for the longest sync stall.
+  std::size_t ring_capacity_ = 1 << 16;
+  // Most records handed to one write() call
+  std::size_t batch_records_ = 4'096;
+  // Bytes reserved with fallocate up front, so group commits do not also
+  // have to persist a growing file size. 0 = grow as written.
+  std::size_t preallocate_bytes_ = 0;
+  // Writer's sleep when the ring is empty
+  std::chrono::microseconds idle_wait_{50};
+  // CPU the writer thread is pinned to; -1 leaves placement to the scheduler.
+  // Keep it off the matching thread's core.
+  int core_ = -1;
+};
+
+// Write-ahead journal. The matching thread (or whoever holds the book lock)
+// appends records to a preallocated SPSC ring, which costs a copy and a
+// release store; a background writer drains the ring in batches to the file
+// and syncs per Durability. Attach it with OrderBookConfig::journal_.
+// Throws std::system_error if the file cannot be opened. A failed write
+// is reported through error(); later records are then discarded.
+class Journal {
+public:
+  explicit Journal(JournalConfig config);
+  // Drains and syncs everything appended, then stops the writer
+  ~Journal();
+
+  Journal(const Journal &) = delete;
+  Journal &operator=(const Journal &) = delete;
+
+  // Producer side
+  void append_command(SymbolId symbol, CommandType command, OrderType type, OrderSide side, OrderId id,
+                      Price price, Quantity quantity, Timestamp expiry = 0, ParticipantId participant = 0) {
+    JournalRecord record;
+    record.price_ = price;
+    record.expiry_ = expiry;
+    record.order_id_ = id;
+    record.quantity_ = quantity;
+    record.symbol_ = symbol;
+    record.participant_ = participant;
+    record.command_ = command;
+    record.order_type_ = static_cast<std::uint8_t>(type);
+    record.side_ = static_cast<std::uint8_t>(side);
+    append(record);
+  }
+  void append_trade(SymbolId symbol, const TradeInfo &trade) {
+    JournalRecord record;
+    record.price_ = trade.get_trade_price();
+    record.order_id_ = trade.get_buy().id_;
+    record.contra_id_ = trade.get_sell().id_;
+    record.quantity_ = trade.get_quantity();
+    record.symbol_ = symbol;
+    record.kind_ = JournalRecordKind::Trade;
+    append(record);
+  }
+
+  // Producer side: waits until every record appended so far is durable
+  void flush();
+
+  // Last sequence appended (producer side), and times the producer waited on
+  // a full ring (any thread)
+  std::uint64_t appended_sequence() const { return sequence_; }
+  std::uint64_t stalls() const { return stalls_.load(std::memory_order_relaxed); }
+
+  // Any thread
+  std::uint64_t written_sequence() const { return written_.load(std::memory_order_acquire); }
+  std::uint64_t durable_sequence() const { return durable_.load(std::memory_order_acquire); }
+  std::uint64_t batches() const { return batches_.load(std::memory_order_relaxed); }
+  std::uint64_t syncs() const { return syncs_.load(std::memory_order_relaxed); }
+  int error() const { return error_.load(std::memory_order_acquire); } // errno, 0 = none
+
+private:
+  void append(JournalRecord &record) {
+    record.sequence_ = ++sequence_;
+    if (!ring_.try_push(record)) [[unlikely]]
+      wait_for_room(record);
+  }
+  // Back-pressure: the journal must not lose records, so the producer waits
+  // for the writer rather than dropping
+  void wait_for_room(const JournalRecord &record) {
+    stalls_.fetch_add(1, std::memory_order_relaxed);
+    while (!ring_.try_push(record))
+      std::this_thread::yield();
+  }
+  void run();
+  void write_batch(std::size_t count);
+  void sync();
+
+  JournalConfig config_;
+  int fd_ = -1;
+  std::uint64_t sequence_ = 0; // producer
+  std::atomic<std::uint64_t> stalls_{0}; // producer, read anywhere
+  SpscRing<JournalRecord> ring_;
+  std::vector<JournalRecord> batch_; // writer
+  std::atomic<std::uint64_t> written_{0};
+  std::atomic<std::uint64_t> durable_{0};
+  std::atomic<std::uint64_t> batches_{0};
+  std::atomic<std::uint64_t> syncs_{0};
+  std::atomic<int> error_{0};
+  std::atomic<bool> sync_requested_{false};
+  std::atomic<bool> stop_{false};
+  std::thread writer_;
+};
+
+// Hands visitor each record of a journal file's bytes (e.g. a MappedFile),
+// in order, up to the first record that is not the next in sequence, of
+// another version or failing its checksum: the preallocated tail, or a
+// record torn by a crash. Returns the count visited.
+template <typename Visitor> std::size_t read_journal(std::span<const std::byte> bytes, Visitor &&visitor) {
+  std::size_t count = 0;
+  for (std::size_t offset = 0; offset + sizeof(JournalRecord) <= bytes.size(); offset += sizeof(JournalRecord)) {
+    JournalRecord record;
+    std::memcpy(&record, bytes.data() + offset, sizeof(record));
+    if (record.sequence_ != count + 1 || record.version_ != JournalVersion ||
+        record.checksum_ != journal_checksum(record))
+      break;
+    visitor(record);
+    ++count;
+  }
+  return count;
+}
+
+// Rebuilds book from the journal's commands for symbol, allocating orders
+// from order_pool; returns the commands applied. The book must not itself
+// journal into the file being read.
+std::size_t recover_from_journal(OrderBook &book, MemoryPool<Order> &order_pool, std::span<const std::byte> bytes,
+                                 SymbolId symbol = 0);
@@ -0,0 +1,149 @@
+#pragma once
+#include "LevelInfo.hpp"
+#include "OrderSide.hpp"
+#include "Usings.hpp"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class LevelAction : std::uint8_t {
+  New,    // level appeared
+  Change, // quantity and/or order count changed
+  Delete  // level emptied
+};
+
+// One market-by-price update. quantity_ and count_ are the level's state after
+// the message (0 for Delete).
+struct LevelDelta {
+  std::uint64_t sequence_ = 0; // 1, 2, ... across both sides of the book
+  Price price_ = 0;
+  Quantity quantity_ = 0;
+  int count_ = 0;
+  OrderSide side_ = OrderSide::Buy;
+  LevelAction action_ = LevelAction::Change;
+  bool end_of_message_ = false; // last delta caused by one inbound call
+};
+
+// Incremental L2 feed. While a message (add/cancel/modify/prune) is processed
+// the book reports each level before changing it; the first report of a level
+// keeps its state from before the message. At the end of the message every
+// touched level is compared with its final state and at most one delta is
+// emitted for it, so N fills against one level become a single Change and a
+// level created and emptied within the message emits nothing. Deltas collect
+// in a buffer preallocated to 'capacity' until the consumer drains them.
+// Not thread-safe: driven under the book lock.
+class LevelDeltaFeed {
+public:
+  explicit LevelDeltaFeed(std::size_t capacity) : enabled_(capacity != 0) {
+    if (enabled_) {
+      deltas_.reserve(capacity);
+      touched_.reserve(InitialBuckets / 2);
+      buckets_.assign(InitialBuckets, Empty);
+    }
+  }
+
+  bool enabled() const { return enabled_; }
+
+  // Before a change to the level at price; quantity/count are its current
+  // aggregates (count 0 = the level does not exist yet)
+  void touch(OrderSide side, Price price, Quantity quantity, int count) {
+    auto bucket = find_bucket(side, price);
+    if (buckets_[bucket] != Empty)
+      return;
+    buckets_[bucket] = static_cast<std::uint32_t>(touched_.size());
+    touched_.push_back(Touched{price, quantity, count, side, bucket});
+    if (touched_.size() * 2 > buckets_.size()) [[unlikely]]
+      rehash(buckets_.size() * 2);
+  }
+
+  // current(side, price) returns the level's LevelInfo after the message,
+  // with count_ 0 if it is gone
+  template <typename Lookup> void end_message(Lookup &&current) {
+    if (touched_.empty())
+      return;
+    const auto first = deltas_.size();
+    for (const auto &level : touched_) {
+      buckets_[level.bucket_] = Empty;
+      LevelInfo after = current(level.side_, level.price_);
+      LevelDelta delta;
+      delta.price_ = level.price_;
+      delta.side_ = level.side_;
+      if (level.count_ == 0 && after.count_ == 0)
+        continue;
+      if (level.count_ == 0) {
+        delta.action_ = LevelAction::New;
+      } else if (after.count_ == 0) {
+        delta.action_ = LevelAction::Delete;
+      } else if (after.quantity_ != level.quantity_ || after.count_ != level.count_) {
+        delta.action_ = LevelAction::Change;
+      } else {
+        continue;
+      }
+      if (after.count_ != 0) {
+        delta.quantity_ = after.quantity_;
+        delta.count_ = after.count_;
+      }
+      delta.sequence_ = ++sequence_;
+      deltas_.push_back(delta);
+    }
+    touched_.clear();
+    if (deltas_.size() != first)
+      deltas_.back().end_of_message_ = true;
+  }
+
+  // Hands every pending delta to visitor, oldest first, and empties the
+  // buffer (keeping its capacity)
+  template <typename Visitor> void drain(Visitor &&visitor) {
+    for (const auto &delta : deltas_)
+      visitor(delta);
+    deltas_.clear();
+  }
+
+  std::size_t pending() const { return deltas_.size(); }
+  // Sequence number of the last delta emitted
+  std::uint64_t sequence() const { return sequence_; }
+
+private:
+  static constexpr std::uint32_t Empty = ~std::uint32_t{0};
+  static constexpr std::size_t InitialBuckets = 64;
+
+  struct Touched {
+    Price price_;
+    Quantity quantity_; // state before the message
+    int count_;
+    OrderSide side_;
+    std::size_t bucket_;
+  };
+
+  // Open addressing on (side, price): the bucket holding it, or the empty one
+  // it would go in
+  std::size_t find_bucket(OrderSide side, Price price) const {
+    const auto mask = buckets_.size() - 1;
+    auto key = static_cast<std::uint64_t>(price) * 2 + (side == OrderSide::Sell);
+    auto bucket = static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    while (buckets_[bucket] != Empty) {
+      const auto &level = touched_[buckets_[bucket]];
+      if (level.price_ == price && level.side_ == side)
+        return bucket;
+      bucket = (bucket + 1) & mask;
+    }
+    return bucket;
+  }
+
+  // Only when one message touches more levels than any before it
+  void rehash(std::size_t buckets) {
+    buckets_.assign(std::bit_ceil(buckets), Empty);
+    for (std::uint32_t slot = 0; slot < touched_.size(); ++slot) {
+      auto bucket = find_bucket(touched_[slot].side_, touched_[slot].price_);
+      buckets_[bucket] = slot;
+      touched_[slot].bucket_ = bucket;
+    }
+  }
+
+  bool enabled_;
+  std::uint64_t sequence_ = 0;
+  std::vector<LevelDelta> deltas_;
+  std::vector<Touched> touched_;       // levels changed by the current message
+  std::vector<std::uint32_t> buckets_; // (side, price) -> touched_ slot
+};
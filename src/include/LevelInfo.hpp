@@ -1,5 +1,6 @@
 #pragma once
 #include "Usings.hpp"
+#include "TickSize.hpp"
 #include <functional>
 #include <iostream>
 #include <map>
@@ -9,8 +10,8 @@ struct LevelInfo{//single level's worth
     Quantity quantity_;
     int count_;
     
-    void display() const{//format later.
-        std::cout<<"Price: "<<price_<<" "<<"Quantity: "<<quantity_<<" "<<"Number of Orders: "<<count_<<std::endl;
+    void display(const TickSize& tick_size = TickSize{}) const{//format later.
+        std::cout<<"Price: "<<tick_size.to_double(price_)<<" "<<"Quantity: "<<quantity_<<" "<<"Number of Orders: "<<count_<<std::endl;
     }
     
     };
@@ -18,25 +19,25 @@ struct LevelInfo{//single level's worth
 struct LevelsInfo{//contains two vectors one each for buy and sell
     std::map<Price,LevelInfo, std::greater<Price>> buy_levels_;
     std::map<Price,LevelInfo,std::less<Price>> sell_levels_;
-    void display_buy_levels() const{
+    void display_buy_levels(const TickSize& tick_size = TickSize{}) const{
         std::cout<<"[Buy Orders in the system]"<<std::endl;
         std::cout<<"#"<<buy_levels_.size()<<std::endl;
         for (auto [_,level]: buy_levels_){
-            level.display();
+            level.display(tick_size);
         }
     } 
-    void display_sell_levels() const{
+    void display_sell_levels(const TickSize& tick_size = TickSize{}) const{
         std::cout<<"[Sell Orders in the system]"<<std::endl;
         std::cout<<"#"<<sell_levels_.size()<<std::endl;
 
         for (auto it = sell_levels_.rbegin(); it != sell_levels_.rend(); ++it){
-            it->second.display(); 
+            it->second.display(tick_size); 
         }
     }
-    void display_all_levels() const{
+    void display_all_levels(const TickSize& tick_size = TickSize{}) const{
         std::cout<<"-------------------------------------------------------------------------------------------------------"<<std::endl;
-        display_sell_levels();
-        display_buy_levels();
+        display_sell_levels(tick_size);
+        display_buy_levels(tick_size);
         std::cout<<"-------------------------------------------------------------------------------------------------------"<<std::endl;
 
     }
@@ -0,0 +1,67 @@
+#pragma once
+#include "CustomDLL.hpp"
+#include "LevelInfo.hpp"
+#include "MemoryPool.hpp"
+#include "OrderEvent.hpp"
+#include "OrderSide.hpp"
+#include "Usings.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include "tsl/robin_map.h"
+
+// Consumer side of the L3 stream: rebuilds a book, order by order and in
+// queue priority, from nothing but OrderEvents. Lives on the consumer thread;
+// shares no state with the OrderBook that produced the events.
+class MarketByOrderBook {
+public:
+  explicit MarketByOrderBook(std::size_t expected_orders = 4096);
+  ~MarketByOrderBook();
+
+  MarketByOrderBook(const MarketByOrderBook &) = delete;
+  MarketByOrderBook &operator=(const MarketByOrderBook &) = delete;
+
+  // Applies event; false if it does not follow on from the events applied so
+  // far (sequence gap, unknown or duplicate order id). Gapped events are still
+  // applied as far as they can be.
+  bool apply(const OrderEvent &event);
+
+  // Same shape as OrderBook::get_order_book(), for comparison
+  LevelsInfo get_order_book() const;
+
+  // Orders ahead of id in its level's queue, -1 if id is not resting
+  std::ptrdiff_t queue_position(OrderId id) const;
+  // Remaining quantity of id, 0 if it is not resting
+  Quantity leaves(OrderId id) const;
+
+  std::size_t size() const { return orders_.size(); }
+  // Sequence number of the last event applied
+  std::uint64_t sequence() const { return sequence_; }
+
+private:
+  struct Resting : IntrusiveListHook<Resting> {
+    OrderId id_;
+    OrderSide side_;
+    Price price_;
+    Quantity leaves_;
+
+    Resting(OrderId id, OrderSide side, Price price, Quantity leaves)
+        : id_(id), side_(side), price_(price), leaves_(leaves) {}
+  };
+
+  struct Level {
+    Quantity quantity_ = 0;
+    IntrusiveLinkedList<Resting> queue_;
+  };
+
+  template <typename Levels> void add(Levels &levels, const OrderEvent &event);
+  template <typename Levels> void take(Levels &levels, Resting *order, Quantity quantity);
+  bool take(const OrderEvent &event, Quantity quantity);
+
+  std::uint64_t sequence_ = 0;
+  MemoryPool<Resting> pool_;
+  tsl::robin_map<OrderId, Resting *> orders_;
+  std::map<Price, Level, std::greater<Price>> bids_;
+  std::map<Price, Level, std::less<Price>> asks_;
+};
@@ -0,0 +1,116 @@
+#pragma once
+#include "BookSnapshot.hpp"
+#include "MemoryPool.hpp"
+#include "Order.hpp"
+#include "OrderBook.hpp"
+#include "OrderBookConfig.hpp"
+#include "OrderCommand.hpp"
+#include "SpscRing.hpp"
+#include "Usings.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "tsl/robin_map.h"
+
+// What the matching thread reports back, in the order it happened. Every
+// command ends with exactly one Done event, preceded by the trades it caused,
+// or with a single Rejected event if the engine does not host its symbol.
+struct EngineEvent {
+  enum class Kind : std::uint8_t { Trade, Done, Rejected };
+
+  Kind kind_ = Kind::Done;
+  std::uint64_t tag_ = 0;     // tag_ of the command that produced the event
+  SymbolId symbol_ = 0;       // the command's symbol
+  OrderId order_id_ = 0;      // the command's order id
+  // Trade only
+  OrderId buy_order_id_ = 0;
+  OrderId sell_order_id_ = 0;
+  Price price_ = 0;
+  Quantity quantity_ = 0;
+};
+
+struct MatchingEngineConfig {
+  // One book per symbol, all built from book_ (single_writer_ is forced on:
+  // the matching thread is the books' only user; symbol_ is set per book, so
+  // a book_.journal_ is shared by all of them)
+  std::vector<SymbolId> symbols_{0};
+  OrderBookConfig book_{};
+  std::size_t ingress_capacity_ = 1 << 16;
+  std::size_t egress_capacity_ = 1 << 16;
+  std::size_t order_pool_slots_ = 1'000'000;
+  // CPU the matching thread is pinned to; -1 leaves placement to the scheduler
+  int core_ = -1;
+  // GoodTillDate expiry runs on the books' clocks. false: the matching thread
+  // moves them to the session clock between bursts. true: only AdvanceTime
+  // commands move them, e.g. timestamps recorded with the flow being replayed.
+  bool replayed_time_ = false;
+};
+
+// Optional engine mode: a dedicated thread owns its OrderBooks exclusively and
+// is fed through lock-free SPSC rings, so no call ever waits on a book mutex.
+// One producer thread submits, one consumer thread polls; either may also be
+// the same thread. All books share one Order pool only the matching thread
+// touches, one GoodForDay expiry check and one clock for GoodTillDate expiry.
+// OrderBookManager runs one engine per shard.
+class MatchingEngine {
+public:
+  explicit MatchingEngine(MatchingEngineConfig config = MatchingEngineConfig{});
+  ~MatchingEngine();
+
+  MatchingEngine(const MatchingEngine&) = delete;
+  MatchingEngine& operator=(const MatchingEngine&) = delete;
+
+  // Producer thread only; false when the ingress ring is full
+  bool try_submit(const OrderCommand &command) { return ingress_.try_push(command); }
+
+  // Consumer thread only; false when nothing is pending. The matching thread
+  // waits for room when the egress ring is full, so keep polling.
+  bool try_poll(EngineEvent &event) { return egress_.try_pop(event); }
+
+  // Published depth, from any thread (needs book_.snapshot_depth_ > 0).
+  // Throws std::out_of_range for a symbol the engine does not host.
+  void read_snapshot(BookSnapshot &out, SymbolId symbol = 0) const {
+    auto it = books_.find(symbol);
+    if (it == books_.end())
+      throw std::out_of_range("unknown symbol " + std::to_string(symbol));
+    it->second->read_snapshot(out);
+  }
+
+  bool hosts(SymbolId symbol) const { return books_.find(symbol) != books_.end(); }
+
+  // Commands taken off the ingress ring so far
+  std::uint64_t processed() const { return processed_.load(std::memory_order_acquire); }
+
+private:
+  void run();
+  void process(const OrderCommand &command);
+  OrderBook *find_book(SymbolId symbol);
+  void emit(const EngineEvent &event);
+  std::chrono::system_clock::time_point session_now() const {
+    return config_.book_.session_clock_ ? config_.book_.session_clock_() : std::chrono::system_clock::now();
+  }
+
+  MatchingEngineConfig config_;
+  // Declared before books_ so it outlives the orders resting in them
+  MemoryPool<Order> order_pool_;
+  // Filled before the thread starts and never changed after, so readers can
+  // look books up without synchronisation
+  tsl::robin_map<SymbolId, std::unique_ptr<OrderBook>> books_;
+  SymbolId last_symbol_ = 0;
+  OrderBook *last_book_ = nullptr;
+  SpscRing<OrderCommand> ingress_;
+  SpscRing<EngineEvent> egress_;
+  std::chrono::system_clock::time_point good_for_day_cutoff_;
+  bool expiring_good_for_day_ = false;
+  // Timer wheel tick the books were last advanced to from the session clock
+  std::uint64_t time_tick_ = 0;
+  std::atomic<std::uint64_t> processed_{0};
+  std::atomic<bool> stop_{false};
+  std::thread thread_;
+};
@@ -94,4 +94,13 @@ public:
     }
 
     size_t chunk_count() const { return chunks_.size(); }
+
+    // Touch every page of the not-yet-handed-out storage so first use does not fault
+    void prefault() {
+        for (auto& c : chunks_) {
+            const size_t bytes = c->capacity * sizeof(T);
+            for (size_t offset = c->used * sizeof(T); offset < bytes; offset += 4096)
+                c->buffer[offset] = std::byte{0};
+        }
+    }
 };
\ No newline at end of file
@@ -28,6 +28,10 @@ class OrderModify{
              return id_;
          }
 
+        Quantity get_quantity(){
+             return quantity_order_;
+         }
+
         OrderPointer to_order_ptr() {
             return make_intrusive_pooled_order(pool_ptr_, type_, side_, id_, price_, quantity_order_);
         }
@@ -0,0 +1,100 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Hierarchical occupancy bitmap. Layer 0 has one bit per slot, every layer
+// above has one bit per non-zero word of the layer below, up to a single root
+// word. Finding the first/last/next set bit is one tzcnt/lzcnt per layer.
+class OccupancyBitmap {
+public:
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    explicit OccupancyBitmap(std::size_t bits = 0) : bits_(bits) {
+        std::size_t words = (bits + 63) / 64;
+        while (words > 0) {
+            layers_.emplace_back(words, 0);
+            if (words == 1) break;
+            words = (words + 63) / 64;
+        }
+    }
+
+    std::size_t size() const { return bits_; }
+
+    bool test(std::size_t pos) const {
+        return (layers_[0][pos >> 6] >> (pos & 63)) & 1;
+    }
+
+    void set(std::size_t pos) {
+        for (auto &layer : layers_) {
+            auto &word = layer[pos >> 6];
+            bool was_empty = word == 0;
+            word |= std::uint64_t{1} << (pos & 63);
+            if (!was_empty) return;
+            pos >>= 6;
+        }
+    }
+
+    void reset(std::size_t pos) {
+        for (auto &layer : layers_) {
+            auto &word = layer[pos >> 6];
+            word &= ~(std::uint64_t{1} << (pos & 63));
+            if (word != 0) return;
+            pos >>= 6;
+        }
+    }
+
+    std::size_t find_first() const { return find_next(0); }
+
+    std::size_t find_last() const { return bits_ == 0 ? npos : find_prev(bits_ - 1); }
+
+    // Lowest set bit >= pos
+    std::size_t find_next(std::size_t pos) const {
+        if (pos >= bits_) return npos;
+        std::size_t layer = 0;
+        while (true) {
+            std::size_t word = pos >> 6;
+            if (word >= layers_[layer].size()) return npos;
+            std::uint64_t bits = layers_[layer][word] & (~std::uint64_t{0} << (pos & 63));
+            if (bits) {
+                pos = (word << 6) + std::countr_zero(bits);
+                break;
+            }
+            if (++layer == layers_.size()) return npos;
+            pos = word + 1;
+        }
+        while (layer > 0) {
+            --layer;
+            pos = (pos << 6) + std::countr_zero(layers_[layer][pos]);
+        }
+        return pos;
+    }
+
+    // Highest set bit <= pos
+    std::size_t find_prev(std::size_t pos) const {
+        if (bits_ == 0) return npos;
+        if (pos >= bits_) pos = bits_ - 1;
+        std::size_t layer = 0;
+        while (true) {
+            std::size_t word = pos >> 6;
+            std::uint64_t bits = layers_[layer][word] & (~std::uint64_t{0} >> (63 - (pos & 63)));
+            if (bits) {
+                pos = (word << 6) + 63 - std::countl_zero(bits);
+                break;
+            }
+            if (word == 0 || ++layer == layers_.size()) return npos;
+            pos = word - 1;
+        }
+        while (layer > 0) {
+            --layer;
+            pos = (pos << 6) + 63 - std::countl_zero(layers_[layer][pos]);
+        }
+        return pos;
+    }
+
+private:
+    std::size_t bits_;
+    std::vector<std::vector<std::uint64_t>> layers_; // layers_[0] = leaves, back() = root
+};
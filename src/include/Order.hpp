@@ -2,18 +2,25 @@
 #include "Usings.hpp"
 #include "OrderType.hpp"
 #include "OrderSide.hpp"
+#include "constants.hpp"
 #include<memory>
 #include <list>
 #include <stdexcept>
 #include <atomic>
 #include <boost/intrusive_ptr.hpp>
 #include "CustomDLL.hpp"
+#include "RefCount.hpp"
 
 // Forward declare MemoryPool
 template <typename T>
 class MemoryPool;
 
-class Order{
+// Hook tag for the book's list of resting GoodForDay orders
+struct GoodForDayTag;
+
+// Resting orders are linked into their price level through the embedded hook,
+// and GoodForDay orders also into the book's expiry list
+class Order : public IntrusiveListHook<Order>, public IntrusiveListHook<Order, GoodForDayTag> {
 
     public:
         // Pool-aware constructor
@@ -43,6 +50,10 @@ class Order{
             return quantity_order_left_;
         }
 
+        Quantity get_initial_quantity(){
+            return quantity_order_;
+        }
+
         Price get_price(){
              return price_;
          }
@@ -55,6 +66,22 @@ class Order{
              quantity_order_left_ -= quantity;
          }
 
+         // Modify in place, same price: cuts the remaining quantity, keeping
+         // what has already traded
+         void reduce_quantity(Quantity leaves){
+             quantity_order_ -= quantity_order_left_ - leaves;
+             quantity_order_left_ = leaves;
+         }
+
+         // Modify in place otherwise: the order starts over as if just entered
+         void replace(OrderType type, OrderSide side, Price price, Quantity quantity){
+             type_ = type;
+             side_ = side;
+             price_ = price;
+             quantity_order_ = quantity;
+             quantity_order_left_ = quantity;
+         }
+
          bool order_filled_partial_or_full(){
             return quantity_order_left_ < quantity_order_;
          }
@@ -63,7 +90,7 @@ class Order{
                 throw std::runtime_error("Order type is not Market in market_to_gtc()");
             }
             // type_ = OrderType::GoodTillCancel;
-            price_ = (get_order_side()==OrderSide::Buy)? 1e18:0;
+            price_ = (get_order_side()==OrderSide::Buy)? Constants::MarketBuyPrice : Constants::MarketSellPrice;
 
          }
 
@@ -72,10 +99,10 @@ class Order{
 
          // Intrusive pointer hooks
          friend inline void intrusive_ptr_add_ref(Order* p) {
-             p->ref_count_.fetch_add(1, std::memory_order_relaxed);
+             p->ref_count_.add_ref();
          }
          friend inline void intrusive_ptr_release(Order* p) {
-             if (p->ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+             if (p->ref_count_.release()) {
                  if (p->pool_ != nullptr) {
                      // MemoryPool::deallocate will run the destructor
                      p->pool_->deallocate(p);
@@ -88,17 +115,20 @@ class Order{
 
     private:
 
+    // Packed so that, with both hooks, an Order is one 64-byte cache line
     OrderType type_;
     OrderSide side_;
+    mutable OrderRefCount ref_count_;
     OrderId id_;
     mutable Price price_;
     Quantity quantity_order_;
     Quantity quantity_order_left_;
-    mutable std::atomic<uint32_t> ref_count_{0};
     MemoryPool<Order>* pool_;
 };
 
+static_assert(sizeof(Order) <= 64);
+
 
 using OrderPointer = boost::intrusive_ptr<Order> ;
-using OrderPointers = CustomLinkedList<OrderPointer> ;
+using OrderPointers = IntrusiveLinkedList<Order> ;
 using OrderList = std::pmr::list<OrderPointer>;
\ No newline at end of file
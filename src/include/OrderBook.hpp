@@ -1,8 +1,19 @@
 #pragma once
+#include "BookSnapshot.hpp"
+#include "Journal.hpp"
+#include "LevelDelta.hpp"
 #include "LevelInfo.hpp"
+#include "MemoryPool.hpp"
 #include "ModifyOrder.hpp"
+#include "OrderCommand.hpp"
+#include "OrderEvent.hpp"
 #include "Order.hpp"
+#include "OrderBookConfig.hpp"
 #include "OrderSide.hpp"
+#include "PriceLadder.hpp"
+#include "StateSnapshot.hpp"
+#include "TickSize.hpp"
+#include "TimerWheel.hpp"
 #include "TradeInfo.hpp"
 #include "Usings.hpp"
 #include "map"
@@ -14,67 +25,322 @@
 #include <ctime>
 #include <chrono>
 #include <memory>
+#include <span>
+#include <vector>
 #include <boost/unordered/unordered_flat_map.hpp>
 #include "CustomDLL.hpp"
+#include "constants.hpp"
 #include "tsl/robin_map.h"
 #include "absl/container/btree_map.h"
 
+// End of the trading session (16:00 local) after now, when GoodForDay orders expire
+std::chrono::system_clock::time_point
+next_good_for_day_cutoff(std::chrono::system_clock::time_point now);
+
 class OrderBook {
 public:
-  OrderBook();
+  explicit OrderBook(OrderBookConfig config = OrderBookConfig{});
 
   TradeInfos add_order(OrderPointer order);
+  // Fills go to trades (a reused TradeInfos or a per-fill callback) instead of
+  // a fresh TradeInfos, so steady-state matching allocates nothing. expiry is
+  // for GoodTillDate orders only: one whose expiry is not after current_time()
+  // is rejected. participant, if not 0, is the session the order belongs
+  // to, for mass_cancel(ParticipantId); it stays with the order until it
+  // leaves the book, modifies included.
+  void add_order(OrderPointer order, TradeSink trades, Timestamp expiry = 0,
+                 ParticipantId participant = 0);
 
   void cancel_order(OrderId);
+  // Bulk cancels; each returns the orders cancelled and is one message, with
+  // one level update per price it touches. Cancels every resting order on
+  // side, a level at a time.
+  std::size_t mass_cancel(OrderSide side);
+  // Every resting order on side priced from low to high, both included; whole
+  // levels are dropped at once. Journaled as one Cancel per order.
+  std::size_t mass_cancel(OrderSide side, Price low, Price high);
+  // Every resting order entered by participant (cancel on disconnect), in
+  // O(orders cancelled): the book keeps each participant's orders in a dense
+  // array. Journaled as one Cancel per order.
+  std::size_t mass_cancel(ParticipantId participant);
+  std::size_t participant_order_count(ParticipantId participant);
 
   LevelsInfo get_order_book();
 
   std::size_t Size();
   
+  // Modifies the resting order in place, so order pointers held elsewhere see
+  // the change. At the same price, side and type, a quantity below the
+  // remaining one is cut in O(1) and keeps the order's place in the queue (an
+  // L3 Reduced event), and the same quantity is a no-op that publishes
+  // nothing; anything else requeues the same Order at the back of
+  // its new level, as a fresh add would. A GoodTillDate replacement keeps the
+  // order's expiry unless given a new one.
   TradeInfos modify_order(OrderModify modify_request);
+  void modify_order(OrderModify modify_request, TradeSink trades, Timestamp expiry = 0);
+
+  // Applies commands in order under one hold of the book lock, as if each
+  // had been its own call, and writes the outcome of commands[i] to
+  // results[i]; throws std::invalid_argument, applying nothing, if results is
+  // shorter than commands. Fills go to trades. The whole batch is one
+  // message: one flush of the L2 delta feed and one snapshot publish. Orders
+  // are built in order_pool; symbol_ is ignored.
+  void apply_batch(std::span<const OrderCommand> commands, MemoryPool<Order> &order_pool,
+                   std::span<CommandResult> results, TradeSink trades);
 
+  // A counted handle to the resting order, or null. Orders count references
+  // in 16 bits (see RefCount.hpp): hold at most MaxRefCount handles to one
+  // order at a time, the book's own reference included.
   OrderPointer get_order_by_id(OrderId );
+
+  // Resting quantity an incoming order on 'side' limited at limit_price could
+  // trade against, i.e. asks at or below it for Buy, bids at or above for Sell
+  std::int64_t available_liquidity(OrderSide side, Price limit_price);
+
+  // Copies the last published top-N depth into out without taking the book
+  // lock; safe from any thread. Needs config snapshot_depth_ > 0.
+  void read_snapshot(BookSnapshot &out) const { snapshot_.read(out); }
+  std::uint64_t snapshot_sequence() const { return snapshot_.sequence(); }
+
+  // Hands visitor every L2 delta emitted since the last drain, oldest first
+  // (see LevelDeltaFeed). Needs config level_delta_capacity_ > 0.
+  template <typename Visitor> void drain_level_deltas(Visitor &&visitor) {
+    auto ordersLock = lock_book();
+    level_deltas_.drain(visitor);
+  }
+  std::uint64_t level_delta_sequence() const { return level_deltas_.sequence(); }
+
+  // L3 stream: one consumer thread polls the book's order events without the
+  // book lock (see OrderEventStream). Needs config order_event_capacity_ > 0.
+  bool try_poll_order_event(OrderEvent &event) { return order_events_.try_poll(event); }
+  std::uint64_t order_events_dropped() const { return order_events_.dropped(); }
+
+  // Cancels every resting GoodForDay order, good_for_day_expiry_chunk_ orders
+  // per hold of the book lock; run by the prune thread at the end of the
+  // session. Only GoodForDay orders are visited.
+  void prune_good_for_day_orders();
+  // The same in steps, for an owner that interleaves expiry with live flow
+  // (single-writer mode): begin_ marks every GoodForDay order resting now as
+  // expiring (later ones wait for the next session), then each expire_ call
+  // cancels up to max_orders of them and returns true while some remain.
+  // A level holding only expiring orders is dropped in one step, with one
+  // level update.
+  void begin_good_for_day_expiry();
+  bool expire_good_for_day(std::size_t max_orders);
+  std::size_t good_for_day_count();
+
+  // Moves the book's clock to now (never back) and cancels every GoodTillDate
+  // order whose expiry is at or before it, on the timer_resolution_ grid;
+  // returns the orders expired. Driven by the owner's clock (MatchingEngine)
+  // or by recorded AdvanceTime commands on replay, so expiry is deterministic.
+  // A call with nothing due costs one comparison.
+  std::size_t advance_time(Timestamp now);
+  Timestamp current_time();
+  std::size_t good_till_date_count();
+
+  const TickSize& get_tick_size() const { return config_.tick_size_; }
+
+  // Every resting order, level by level in queue order, as a compact binary
+  // image (see StateSnapshot.hpp). sequence is stored for the caller, e.g.
+  // the journal sequence the state corresponds to.
+  std::vector<std::byte> save_state(std::uint64_t sequence = 0);
+  // Loads a save_state() image into this book, which must be empty: orders
+  // are built in order_pool and linked straight into their levels and the
+  // order table, skipping add_order and the matching checks. Nothing is
+  // emitted on the L2/L3 feeds or the journal. Returns the image's sequence.
+  // Throws std::invalid_argument, leaving the book untouched, if the image is
+  // malformed or in another tick size, repeats an order id, has an expiry
+  // for an order that is not GoodTillDate, or a participant for an order it
+  // does not hold or that already has one.
+  std::uint64_t restore_state(std::span<const std::byte> image, MemoryPool<Order> &order_pool);
   
   ~OrderBook();
 private:
-  struct OrderInfoByID {
-    OrderPointer pointer_; // points to the actual Order object
-    OrderPointers::iterator
-        it_; // this is the Order's iterator in a asks_ or bids_ list
-  };
-
-  enum class Action {
-    Add,
-    Remove,
-    Match,
-  };
-
-  std::shared_ptr<MemoryPool<ListNode<OrderPointer>>> pool;
+  OrderBookConfig config_;
 
-  std::map<Price, OrderPointers, std::greater<Price>> bids_;
-  std::map<Price, OrderPointers, std::less<Price>> asks_;
-  tsl::robin_map<OrderId, OrderInfoByID> orders_;
-  LevelsInfo levels;
+  // Before the ladders, whose map levels live in it
+  LevelMemory level_memory_;
+  PriceLadder<OrderSide::Buy> bids_;
+  PriceLadder<OrderSide::Sell> asks_;
+  // Resting orders; the book holds one reference on each (see add_order_internal)
+  OrderIndex orders_;
+  SnapshotPublisher snapshot_;
+  // Set when a level at or inside the published top-N changes; levels beyond
+  // the last published price cannot alter the snapshot, so they skip publishing
+  bool snapshot_dirty_ = false;
+  Price snapshot_bid_floor_ = Constants::InvalidPrice;
+  Price snapshot_ask_ceiling_ = Constants::MarketBuyPrice;
+  LevelDeltaFeed level_deltas_;
+  OrderEventStream order_events_;
   mutable std::mutex ordersMutex_;
-  std::thread ordersPruneThread_;
+  std::thread ordersPruneThread_; // started by the first GoodForDay order
   std::condition_variable shutdownConditionVariable_;
   std::atomic<bool> shutdown_{ false };
+  // Resting GoodForDay orders, oldest first
+  IntrusiveLinkedList<Order, GoodForDayTag> good_for_day_;
+  // Newest order of the running expiry; nullptr when none is running
+  Order *expiry_last_ = nullptr;
+  // GoodForDay orders added since the running expiry began. While there are
+  // none, every GoodForDay level is expiring as a whole.
+  std::size_t good_for_day_added_ = 0;
+  // Resting GoodTillDate orders and their expiries. The wheel holds one entry
+  // per order added, in timer_resolution_ ticks; entries of orders that have
+  // left (or were re-added later) are skipped when they fire.
+  tsl::robin_map<OrderId, Timestamp> good_till_date_;
+  TimerWheel expiry_timers_;
+  Timestamp now_ = 0;
+  // Resting orders entered with a participant (Order has no room for one):
+  // each participant's order ids, and where each order sits in its array, so
+  // an order leaves in O(1) by swapping in the array's last id. Arrays keep
+  // their capacity when emptied, for the session's next orders.
+  struct ParticipantSlot {
+    ParticipantId participant_;
+    std::uint32_t index_;
+  };
+  tsl::robin_map<ParticipantId, OrderIds> participant_orders_;
+  tsl::robin_map<OrderId, ParticipantSlot> participant_slots_;
+  std::vector<Order *> cancel_scratch_;
+  std::uint64_t expiry_tick(Timestamp expiry) const {
+    return (expiry + config_.timer_resolution_.count() - 1) / config_.timer_resolution_.count();
+  }
   void PruneGoodForDayOrders();
-  void OnOrderCancelled(Price price, Quantity quantity, OrderSide side);
-
-  void OnOrderAdded(OrderPointer order);
+  std::chrono::system_clock::time_point session_now() const {
+    return config_.session_clock_ ? config_.session_clock_() : std::chrono::system_clock::now();
+  }
+  // Holds ordersMutex_, except in single-writer mode where it holds nothing
+  std::unique_lock<std::mutex> lock_book() {
+    return config_.single_writer_ ? std::unique_lock<std::mutex>{}
+                                  : std::unique_lock<std::mutex>{ordersMutex_};
+  }
+  // Level aggregate upkeep; called while the order is still queued on level
+  void OnOrderCancelled(PriceLevel &level, Quantity quantity, OrderSide side);
 
-  void OnOrderMatched(Price price, Quantity quantity, OrderSide side);
+  void OnOrderAdded(PriceLevel &level, Quantity quantity, OrderSide side);
 
-  void UpdateLevelData(Price price, Quantity quantity, OrderSide side,
-                       Action action);
+  void OnOrderMatched(PriceLevel &level, Quantity quantity, OrderSide side);
 
-  bool can_match();
   bool can_match_order(OrderSide side, Price price);
   bool can_fully_match_order(OrderSide side, Price price, Quantity quantity);
-  void cancel_orders_internal(OrderIds);
   void cancel_order_internal(OrderId, bool no_update_level = false);
-  TradeInfos add_order_internal(OrderPointer order);
-  TradeInfos match_orders();
+  // Takes order off its level and out of expiry tracking; the order table
+  // entry and the book's reference stay
+  void unlink_order(Order *order, bool no_update_level = false);
+  // Type rules for an incoming order: FillAndKill and FillOrKill need
+  // liquidity, GoodTillDate an expiry after now_
+  bool admits(OrderType type, OrderSide side, Price price, Quantity quantity, Timestamp expiry);
+  // Queues order at the back of its level and tracks its expiry
+  void queue_order(Order *order, Timestamp expiry);
+  // Same-price size-down of a resting order to leaves
+  void reduce_order(Order &order, Quantity leaves);
+  // Tracks a GoodForDay order that now rests on level; starts the prune
+  // thread for the first one of a locked book
+  void link_good_for_day(PriceLevel &level, Order *order) {
+    ++level.good_for_day_;
+    good_for_day_.push_back(order);
+    if (expiry_last_ != nullptr)
+      ++good_for_day_added_;
+    if (!config_.single_writer_ && !ordersPruneThread_.joinable()) [[unlikely]]
+      ordersPruneThread_ = std::thread{[this]() { PruneGoodForDayOrders(); }};
+  }
+  // Before a GoodForDay order leaves level
+  void unlink_good_for_day(PriceLevel &level, Order *order) {
+    --level.good_for_day_;
+    if (order == expiry_last_)
+      expiry_last_ = good_for_day_.prev(order);
+    good_for_day_.erase(order);
+  }
+  // Before an order that may carry an expiry leaves level
+  void untrack_expiry(PriceLevel &level, Order *order) {
+    if (order->get_order_type() == OrderType::GoodForDay)
+      unlink_good_for_day(level, order);
+    else if (order->get_order_type() == OrderType::GoodTillDate)
+      good_till_date_.erase(order->get_order_id());
+  }
+  // By reference: the book takes its own single reference when the order rests.
+  // journal = false when the caller has journaled the command itself (modify)
+  // Returns false when the order was not admitted
+  bool add_order_internal(const OrderPointer &order, TradeSink trades, bool journal = true,
+                          Timestamp expiry = 0, ParticipantId participant = 0);
+  // Bodies of the public calls without the lock and end_message(), shared
+  // with apply_batch. cancel and modify return false for an unknown id.
+  bool apply_cancel(OrderId id);
+  bool apply_modify(OrderModify &modify_request, TradeSink trades, Timestamp expiry);
+  std::size_t apply_mass_cancel(OrderSide side);
+  std::size_t apply_mass_cancel(ParticipantId participant);
+  // Takes every order off level with one level update and drops it.
+  // journal: one Cancel record per order
+  template <OrderSide Side> std::size_t drop_level(PriceLadder<Side> &ladder, PriceLevel &level, bool journal);
+  // Cancels orders, all resting on level, with one level update; the level
+  // goes with them if they were all it held
+  template <OrderSide Side>
+  void cancel_on_level(PriceLadder<Side> &ladder, PriceLevel &level, std::span<Order *const> orders);
+  // Out of the order table and its participant's array; the caller releases
+  // the book's reference
+  void erase_order(OrderId id) {
+    orders_.erase(id);
+    if (!participant_slots_.empty()) [[unlikely]]
+      untrack_participant(id);
+  }
+  void track_participant(OrderId id, ParticipantId participant) {
+    auto &ids = participant_orders_[participant];
+    participant_slots_.insert_or_assign(id, ParticipantSlot{participant, static_cast<std::uint32_t>(ids.size())});
+    ids.push_back(id);
+  }
+  void untrack_participant(OrderId id) {
+    auto slot = participant_slots_.find(id);
+    if (slot == participant_slots_.end())
+      return;
+    const auto [participant, index] = slot->second;
+    participant_slots_.erase(slot);
+    auto &ids = participant_orders_[participant];
+    if (index + 1 != ids.size()) {
+      ids[index] = ids.back();
+      participant_slots_[ids[index]].index_ = index;
+    }
+    ids.pop_back();
+  }
+  std::size_t apply_advance_time(Timestamp now);
+  void match_orders(TradeSink trades);
+  // Trades the two best levels' queues against each other until one of them
+  // is empty or both are done, then updates each level once
+  void match_levels(PriceLevel &bid_level, PriceLevel &ask_level, TradeSink trades);
+  // Takes a filled order off the front of level, without touching the
+  // level's quantity, and returns the order queued behind it (prefetched)
+  Order *remove_filled(PriceLevel &level, Order *order);
+  // Market, FillAndKill and FillOrKill orders trade against the other side
+  // without ever resting: no level, order table entry or L3 Added event, and
+  // whatever is left unfilled is dropped
+  static bool never_rests(OrderType type) {
+    return type == OrderType::Market || type == OrderType::FillAndKill || type == OrderType::FillOrKill;
+  }
+  void sweep_order(Order &order, TradeSink trades);
+  // Fills order against ladder, the other side, best level first, up to its price
+  template <OrderSide Side> void sweep(PriceLadder<Side> &ladder, Order &order, TradeSink trades);
+  void emit_order_event(OrderEventKind kind, Order &order, Price price, Quantity quantity,
+                        Quantity leaves, OrderId contra_id = 0) {
+    if (order_events_.enabled())
+      order_events_.emit(kind, order.get_order_side(), order.get_order_id(), price, quantity,
+                         leaves, contra_id);
+  }
+  void journal_command(CommandType command, OrderId id, OrderSide side = OrderSide::Buy,
+                       OrderType type = OrderType::GoodTillCancel, Price price = 0,
+                       Quantity quantity = 0, Timestamp expiry = 0, ParticipantId participant = 0) {
+    if (config_.journal_ != nullptr)
+      config_.journal_->append_command(config_.symbol_, command, type, side, id, price, quantity, expiry,
+                                       participant);
+  }
+  // Called under the lock at the end of every mutating call: closes the
+  // message for the L2 delta feed, then publishes the snapshot
+  void end_message();
+  void publish_snapshot();
+  // Before every change to level's aggregates; count_before excludes an order
+  // already queued by the change
+  void mark_level(PriceLevel &level, OrderSide side, int count_before) {
+    if (side == OrderSide::Buy ? level.price_ >= snapshot_bid_floor_
+                               : level.price_ <= snapshot_ask_ceiling_)
+      snapshot_dirty_ = true;
+    if (level_deltas_.enabled())
+      level_deltas_.touch(side, level.price_, level.quantity_, count_before);
+  }
 
 };
@@ -0,0 +1,83 @@
+#pragma once
+#include "OrderIndex.hpp"
+#include "TickSize.hpp"
+#include "Usings.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+class Journal;
+
+// Wall clock that decides when the trading session ends (GoodForDay expiry).
+// Tests and benchmarks inject their own, e.g. one shifted to just before the
+// cutoff; an empty one means std::chrono::system_clock::now.
+using SessionClock = std::function<std::chrono::system_clock::time_point()>;
+
+enum class GrowthPolicy : std::uint8_t {
+  // Allocate the expected capacities at construction; a book sized for its
+  // peak never grows (or rehashes) mid-session
+  Reserve,
+  // Start empty and grow on demand; a quiet instrument costs almost nothing
+  Lazy
+};
+
+struct OrderBookConfig {
+  TickSize tick_size_{};
+
+  // Dense price ladder band, in ticks: prices in
+  // [ladder_base_price_, ladder_base_price_ + ladder_levels_) are array-indexed
+  // per side, anything outside falls back to a sorted map. 0 levels = map only.
+  Price ladder_base_price_ = 0;
+  std::size_t ladder_levels_ = 0;
+  // Fenwick tree over the band for O(log n) FillOrKill / available_liquidity
+  // queries; costs an O(log n) update per level quantity change.
+  bool ladder_depth_index_ = true;
+
+  // Id -> order table. Direct indexes ids >= order_index_base_id_ into a paged
+  // array (ids assigned monotonically by a gateway); Hashed handles any id space.
+  OrderIndexMode order_index_mode_ = OrderIndexMode::Hashed;
+  OrderId order_index_base_id_ = 0;
+
+  // Capacity hints: resting orders (order table) and out-of-band price levels
+  // (level node arena). See GrowthPolicy.
+  std::size_t expected_orders_ = 4096;
+  std::size_t expected_levels_ = 256;
+  GrowthPolicy growth_policy_ = GrowthPolicy::Reserve;
+  // Touch reserved memory at construction so page faults are paid at startup,
+  // not by the first orders
+  bool prefault_ = false;
+
+  // Top-N levels per side published after every event for lock-free readers
+  // (see read_snapshot). 0 = no publication.
+  std::size_t snapshot_depth_ = 0;
+
+  // Incremental L2 feed: coalesced New/Change/Delete level deltas per inbound
+  // message, buffered until drain_level_deltas(). The buffer is preallocated
+  // for this many deltas between drains. 0 = no feed.
+  std::size_t level_delta_capacity_ = 0;
+
+  // Market-by-order (L3) stream: Added/Executed/Reduced/Deleted events on a
+  // ring of this many slots, polled with try_poll_order_event(). 0 = no stream.
+  std::size_t order_event_capacity_ = 0;
+
+  // Write-ahead journal (not owned) that every accepted command and every
+  // fill is appended to, stamped with symbol_. Books sharing a journal must
+  // share the producer thread too (e.g. one MatchingEngine). nullptr = none.
+  Journal *journal_ = nullptr;
+  SymbolId symbol_ = 0;
+
+  // One thread owns the book (see MatchingEngine): calls skip the mutex and no
+  // GFD prune thread is started; the owner calls prune_good_for_day_orders().
+  bool single_writer_ = false;
+
+  // GoodForDay expiry at the session cutoff: orders expired per hold of the
+  // book lock, so live flow gets in between chunks (a whole level of
+  // GoodForDay orders is never split, so a chunk may run over by one level)
+  std::size_t good_for_day_expiry_chunk_ = 1024;
+  SessionClock session_clock_{};
+
+  // GoodTillDate expiries are rounded up to this grid: an order expires at
+  // the first advance_time() at or after its rounded expiry
+  std::chrono::nanoseconds timer_resolution_{std::chrono::milliseconds(1)};
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include "BookSnapshot.hpp"
+#include "MatchingEngine.hpp"
+#include "OrderCommand.hpp"
+#include "Usings.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "tsl/robin_map.h"
+
+struct OrderBookManagerConfig {
+  // Symbols are dealt round-robin across shards in this order
+  std::vector<SymbolId> symbols_;
+  std::size_t shards_ = 1;
+  // cores_[i] pins shard i's matching thread; shards past the end are unpinned
+  std::vector<int> cores_;
+  // Template for every shard; its symbols_ and core_ are filled in per shard.
+  // book_ applies to every book, so size expected_orders_ per symbol, not per process.
+  // A book_.journal_ is only allowed with one shard (it takes one producer thread).
+  MatchingEngineConfig shard_{};
+};
+
+// Hosts many instruments in one process: each shard is a MatchingEngine (one
+// worker thread, one Order pool, one GoodForDay expiry check) owning the books
+// of the symbols routed to it. Commands are routed by OrderCommand::symbol_.
+// One producer thread submits; each shard's events are polled by one consumer.
+class OrderBookManager {
+public:
+  // Throws std::invalid_argument for a journal shared by more than one shard
+  explicit OrderBookManager(OrderBookManagerConfig config);
+
+  std::size_t shard_count() const { return shards_.size(); }
+
+  // Throws std::out_of_range for a symbol the manager was not configured with
+  std::size_t shard_of(SymbolId symbol) const;
+
+  // False when the owning shard's ingress ring is full
+  bool try_submit(const OrderCommand &command) {
+    return shards_[shard_of(command.symbol_)]->try_submit(command);
+  }
+
+  bool try_poll(std::size_t shard, EngineEvent &event) { return shards_[shard]->try_poll(event); }
+
+  void read_snapshot(SymbolId symbol, BookSnapshot &out) const {
+    shards_[shard_of(symbol)]->read_snapshot(out, symbol);
+  }
+
+  // Commands taken off the ingress rings so far, over all shards
+  std::uint64_t processed() const;
+
+private:
+  tsl::robin_map<SymbolId, std::uint32_t> routes_;
+  std::vector<std::unique_ptr<MatchingEngine>> shards_;
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include "OrderSide.hpp"
+#include "OrderType.hpp"
+#include "Usings.hpp"
+#include <cstdint>
+
+enum class CommandType : std::uint8_t {
+    Add,
+    Cancel,
+    Modify,
+    MassCancel, // every resting order on side_, or of participant_ if set
+    AdvanceTime // moves the book's clock to timestamp_, expiring GoodTillDate orders
+};
+
+// Fixed-size, trivially copyable order entry request: what producers hand to
+// the matching thread instead of a pooled Order (see MatchingEngine). Cancel
+// only uses symbol_ and order_id_, MassCancel symbol_ and side_ or
+// participant_, AdvanceTime symbol_ and timestamp_; Add uses every field and
+// Modify all but participant_ (an order keeps its participant).
+struct OrderCommand {
+    CommandType command_ = CommandType::Add;
+    OrderType order_type_ = OrderType::GoodTillCancel;
+    OrderSide side_ = OrderSide::Buy;
+    SymbolId symbol_ = 0; // book the command is for, see OrderBookManager
+    OrderId order_id_ = 0;
+    Quantity quantity_ = 0;
+    ParticipantId participant_ = 0; // see OrderBook::mass_cancel(ParticipantId)
+    Price price_ = 0;
+    std::uint64_t tag_ = 0; // opaque to the engine, echoed on every event the command produces
+    // Add/Modify of a GoodTillDate order: its expiry (0 on a Modify keeps the
+    // order's own). AdvanceTime: the new time.
+    Timestamp timestamp_ = 0;
+};
+
+// Outcome of one command in OrderBook::apply_batch. accepted_: an Add was
+// admitted (new id, passed its type's checks), a Cancel or Modify found the
+// order resting; MassCancel and AdvanceTime always are. trades_ and filled_
+// count the fills the command took as the incoming order.
+struct CommandResult {
+    std::uint32_t trades_ = 0;
+    Quantity filled_ = 0;
+    bool accepted_ = false;
+};
@@ -0,0 +1,71 @@
+#pragma once
+#include "OrderSide.hpp"
+#include "SpscRing.hpp"
+#include "Usings.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+enum class OrderEventKind : std::uint8_t {
+  Added,    // order queued at the back of its level with quantity_
+  Executed, // quantity_ traded at price_ against contra_id_; leaves_ 0 = order gone
+  Reduced,  // resting quantity cut by quantity_ without trading, keeps its place
+  Deleted   // order left the book unfilled (cancel, modify, expiry)
+};
+
+// Market-by-order (L3) event: fixed 40-byte binary record, trivially
+// copyable, so it can be written to a ring, a file or a socket as is.
+// Market, FillAndKill and FillOrKill orders never rest, so they have no
+// events of their own: they appear as the contra_id_ of the resting orders
+// they execute against.
+struct OrderEvent {
+  std::uint64_t sequence_ = 0; // 1, 2, ... per book; a gap means events were dropped
+  Price price_ = 0;            // resting price (Added/Reduced/Deleted), trade price (Executed)
+  OrderId order_id_ = 0;
+  OrderId contra_id_ = 0;      // Executed only: the order on the other side of the fill
+  Quantity quantity_ = 0;      // added / executed / reduced / deleted quantity
+  Quantity leaves_ = 0;        // order's remaining quantity after the event
+  OrderEventKind kind_ = OrderEventKind::Added;
+  OrderSide side_ = OrderSide::Buy;
+};
+static_assert(std::is_trivially_copyable_v<OrderEvent>);
+static_assert(sizeof(OrderEvent) == 40);
+
+// Producer end of a book's L3 stream: events go on an SPSC ring that one
+// consumer thread polls. The producer is whoever holds the book (its mutex
+// orders successive producer threads). A full ring never blocks the matcher:
+// the event is dropped and counted, and the consumer sees a sequence gap.
+class OrderEventStream {
+public:
+  explicit OrderEventStream(std::size_t capacity)
+      : enabled_(capacity != 0), ring_(capacity) {}
+
+  bool enabled() const { return enabled_; }
+
+  void emit(OrderEventKind kind, OrderSide side, OrderId id, Price price, Quantity quantity,
+            Quantity leaves, OrderId contra_id = 0) {
+    OrderEvent event;
+    event.sequence_ = ++sequence_;
+    event.price_ = price;
+    event.order_id_ = id;
+    event.contra_id_ = contra_id;
+    event.quantity_ = quantity;
+    event.leaves_ = leaves;
+    event.kind_ = kind;
+    event.side_ = side;
+    if (!ring_.try_push(event)) [[unlikely]]
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Consumer thread only; false when nothing is pending
+  bool try_poll(OrderEvent &event) { return ring_.try_pop(event); }
+
+  std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+  bool enabled_;
+  std::uint64_t sequence_ = 0;
+  SpscRing<OrderEvent> ring_;
+  std::atomic<std::uint64_t> dropped_{0};
+};
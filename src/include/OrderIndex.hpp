@@ -0,0 +1,177 @@
+#pragma once
+#include "Order.hpp"
+#include "Usings.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "tsl/robin_map.h"
+
+enum class OrderIndexMode {
+  Hashed, // tsl::robin_map, any id space
+  Direct, // paged array keyed on id - base, for dense monotonically assigned ids
+};
+
+// Paged slab of Order* indexed directly by (id - base). Pages are allocated on
+// first use and returned to a free list once every id on them is dead, so a
+// monotonically advancing id space only keeps the live window mapped.
+class DirectOrderIndex {
+public:
+  static constexpr std::size_t PageBits = 12;
+  static constexpr std::size_t PageSize = std::size_t{1} << PageBits;
+
+  explicit DirectOrderIndex(OrderId base_id) : base_id_(base_id) {}
+
+  bool covers(OrderId id) const { return id >= base_id_; }
+
+  Order *find(OrderId id) const {
+    auto offset = to_offset(id);
+    auto page = offset >> PageBits;
+    if (page >= pages_.size() || pages_[page] == nullptr)
+      return nullptr;
+    return pages_[page]->slots_[offset & (PageSize - 1)];
+  }
+
+  // Returns false if id is already present
+  bool insert(OrderId id, Order *order) {
+    auto offset = to_offset(id);
+    auto page_number = offset >> PageBits;
+    if (page_number >= pages_.size())
+      pages_.resize(page_number + 1, nullptr);
+    auto *&page = pages_[page_number];
+    if (page == nullptr)
+      page = acquire_page();
+    auto &slot = page->slots_[offset & (PageSize - 1)];
+    if (slot != nullptr)
+      return false;
+    slot = order;
+    ++page->live_;
+    ++size_;
+    return true;
+  }
+
+  void erase(OrderId id) {
+    auto offset = to_offset(id);
+    auto page_number = offset >> PageBits;
+    if (page_number >= pages_.size() || pages_[page_number] == nullptr)
+      return;
+    auto *&page = pages_[page_number];
+    auto &slot = page->slots_[offset & (PageSize - 1)];
+    if (slot == nullptr)
+      return;
+    slot = nullptr;
+    --size_;
+    if (--page->live_ == 0) {
+      free_pages_.push_back(page); // all slots are null again, ready for reuse
+      page = nullptr;
+    }
+  }
+
+  // Pre-allocates pages for 'ids' ids so steady state never allocates
+  void reserve(std::size_t ids) {
+    std::size_t pages = (ids + PageSize - 1) / PageSize;
+    pages_.reserve(pages);
+    while (storage_.size() < pages) {
+      storage_.push_back(std::make_unique<Page>());
+      free_pages_.push_back(storage_.back().get());
+    }
+  }
+
+  std::size_t size() const { return size_; }
+
+  template <typename Visitor> void for_each(Visitor &&visitor) const {
+    for (std::size_t page = 0; page < pages_.size(); ++page) {
+      if (pages_[page] == nullptr)
+        continue;
+      for (std::size_t i = 0; i < PageSize; ++i) {
+        if (auto *order = pages_[page]->slots_[i])
+          visitor(static_cast<OrderId>(base_id_ + (page << PageBits) + i), order);
+      }
+    }
+  }
+
+private:
+  struct Page {
+    std::array<Order *, PageSize> slots_{};
+    std::uint32_t live_ = 0;
+  };
+
+  std::size_t to_offset(OrderId id) const {
+    return static_cast<std::size_t>(static_cast<std::int64_t>(id) - base_id_);
+  }
+
+  Page *acquire_page() {
+    if (free_pages_.empty()) {
+      storage_.push_back(std::make_unique<Page>());
+      return storage_.back().get();
+    }
+    auto *page = free_pages_.back();
+    free_pages_.pop_back();
+    return page;
+  }
+
+  OrderId base_id_;
+  std::size_t size_ = 0;
+  std::vector<Page *> pages_;                 // by page number, nullptr = no live ids
+  std::vector<Page *> free_pages_;            // reclaimed pages
+  std::vector<std::unique_ptr<Page>> storage_; // owns every page ever allocated
+};
+
+// Order id -> resting Order*. Direct mode sends ids below the base to the hash map.
+class OrderIndex {
+public:
+  // expected_orders == 0 allocates nothing until the first insert
+  OrderIndex(OrderIndexMode mode, OrderId base_id, std::size_t expected_orders)
+      : mode_(mode), direct_(base_id) {
+    if (mode_ == OrderIndexMode::Hashed) {
+      // Pre-size to avoid rehash spikes
+      hashed_.max_load_factor(0.7f);
+      if (expected_orders != 0)
+        hashed_.reserve(expected_orders);
+    } else if (expected_orders != 0) {
+      direct_.reserve(expected_orders);
+    }
+  }
+
+  Order *find(OrderId id) const {
+    if (mode_ == OrderIndexMode::Direct && direct_.covers(id)) [[likely]]
+      return direct_.find(id);
+    auto it = hashed_.find(id);
+    return it == hashed_.end() ? nullptr : it->second;
+  }
+
+  bool contains(OrderId id) const { return find(id) != nullptr; }
+
+  bool insert(OrderId id, Order *order) {
+    if (mode_ == OrderIndexMode::Direct && direct_.covers(id)) [[likely]]
+      return direct_.insert(id, order);
+    return hashed_.try_emplace(id, order).second;
+  }
+
+  void erase(OrderId id) {
+    if (mode_ == OrderIndexMode::Direct && direct_.covers(id)) [[likely]]
+      direct_.erase(id);
+    else
+      hashed_.erase(id);
+  }
+
+  std::size_t size() const { return direct_.size() + hashed_.size(); }
+
+  // Room for 'orders' more hashed entries; direct pages are added as ids arrive
+  void reserve(std::size_t orders) {
+    if (mode_ == OrderIndexMode::Hashed)
+      hashed_.reserve(hashed_.size() + orders);
+  }
+
+  template <typename Visitor> void for_each(Visitor &&visitor) const {
+    direct_.for_each(visitor);
+    for (const auto &[id, order] : hashed_)
+      visitor(id, order);
+  }
+
+private:
+  OrderIndexMode mode_;
+  DirectOrderIndex direct_;
+  tsl::robin_map<OrderId, Order *> hashed_;
+};
@@ -1,6 +1,7 @@
 #pragma  once
+#include <cstdint>
 
-enum class OrderSide{
+enum class OrderSide : std::uint8_t {
     Buy,
     Sell
 };
\ No newline at end of file
@@ -1,19 +1,21 @@
 
 #pragma once
+#include <cstdint>
 
-enum class OrderType{
+// One byte, like OrderSide, so an Order with both its hooks fits a cache line
+enum class OrderType : std::uint8_t {
     GoodTillCancel,
     FillAndKill,
     Market,
     FillOrKill,
-    GoodForDay
-    
+    GoodForDay,
+    GoodTillDate // rests until filled, cancelled or its expiry (see OrderBook::advance_time)
 };
 
 /*
 GoodTillCancel- Added to the Order book at the given price, may not execute trades immediately but will persist until cancelled or executed completely.
-FillAndKill- When Adding this the OB is already saturated, now we need to check if at all this can be matched, if so we add it and remove it in the end if partially executed
-FillOrKill- ?
-Market - ?
+FillAndKill- Only admitted if it can match at all; trades what it can up to its price and the rest is dropped, it never rests.
+FillOrKill- Only admitted if the whole quantity can trade up to its price; then trades like FillAndKill.
+Market - No price limit; trades what the other side holds and the rest is dropped, it never rests.
 Limit - Same as GoodTillCancel.
 */
\ No newline at end of file
@@ -0,0 +1,238 @@
+#pragma once
+#include "CustomDLL.hpp"
+#include "FenwickTree.hpp"
+#include "LevelInfo.hpp"
+#include "OccupancyBitmap.hpp"
+#include "Order.hpp"
+#include "OrderSide.hpp"
+#include "Usings.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+
+// One price level: its FIFO queue plus the aggregates LevelsInfo reports
+struct PriceLevel {
+  Price price_;
+  Quantity quantity_ = 0; // sum of remaining quantity of the orders queued here
+  std::uint32_t good_for_day_ = 0; // how many of them are GoodForDay
+  OrderPointers orders_;
+
+  explicit PriceLevel(Price price) : price_(price) {}
+
+  int count() const { return static_cast<int>(orders_.size()); }
+  LevelInfo info() const { return LevelInfo{price_, quantity_, count()}; }
+};
+
+// Node storage for the map levels of both ladders of a book. Freed nodes are
+// recycled by a pool resource; new ones are carved from an arena that can be
+// sized up front for expected_levels. Not thread-safe: one per book.
+class LevelMemory {
+public:
+  // Map node for one level, give or take the allocator's bookkeeping
+  static constexpr std::size_t NodeBytes = sizeof(std::pair<const Price, PriceLevel>) + 4 * sizeof(void *);
+
+  LevelMemory(std::size_t expected_levels, bool reserve, bool prefault)
+      : buffer_bytes_(reserve ? 2 * expected_levels * NodeBytes : 0), // pool chunks grow geometrically
+        buffer_(buffer_bytes_ ? new std::byte[buffer_bytes_] : nullptr),
+        arena_(buffer_.get(), buffer_bytes_),
+        pool_(std::pmr::pool_options{expected_levels, NodeBytes}, &arena_) {
+    if (prefault) {
+      for (std::size_t offset = 0; offset < buffer_bytes_; offset += 4096)
+        buffer_[offset] = std::byte{0};
+    }
+  }
+
+  LevelMemory(const LevelMemory &) = delete;
+  LevelMemory &operator=(const LevelMemory &) = delete;
+
+  std::pmr::memory_resource *resource() { return &pool_; }
+
+private:
+  std::size_t buffer_bytes_;
+  std::unique_ptr<std::byte[]> buffer_;
+  std::pmr::monotonic_buffer_resource arena_; // falls back to the heap once buffer_ is used up
+  std::pmr::unsynchronized_pool_resource pool_;
+};
+
+// Price levels of one side of the book. Prices inside
+// [base_price, base_price + levels) live in a contiguous array indexed by tick
+// offset, with an occupancy bitmap to find the best/next non-empty level.
+// Prices outside the band fall back to a sorted map. levels == 0 is map-only.
+// With depth_index, a Fenwick tree over the band answers "quantity at or better
+// than P" in O(log n); out-of-band levels are summed by walking the map.
+template <OrderSide Side>
+class PriceLadder {
+public:
+  using Compare = std::conditional_t<Side == OrderSide::Buy, std::greater<Price>, std::less<Price>>;
+  PriceLadder(Price base_price, std::size_t levels, bool depth_index,
+              std::pmr::memory_resource *level_memory = std::pmr::get_default_resource())
+      : base_price_(base_price), occupied_(levels), sparse_(level_memory),
+        depth_(depth_index ? levels : 0) {
+    dense_.reserve(levels);
+    for (std::size_t i = 0; i < levels; ++i) {
+      dense_.emplace_back(base_price_ + static_cast<Price>(i));
+    }
+  }
+
+  PriceLadder(const PriceLadder &) = delete;
+  PriceLadder &operator=(const PriceLadder &) = delete;
+
+  // True if a ranks ahead of b on this side (higher bid, lower ask)
+  static bool better(Price a, Price b) { return Compare{}(a, b); }
+
+  // Level resting at price, nullptr if there is none
+  PriceLevel *find(Price price) {
+    if (in_band(price)) {
+      auto index = to_index(price);
+      return occupied_.test(index) ? &dense_[index] : nullptr;
+    }
+    auto it = sparse_.find(price);
+    return it == sparse_.end() ? nullptr : &it->second;
+  }
+
+  PriceLevel &find_or_create(Price price) {
+    if (in_band(price)) {
+      auto index = to_index(price);
+      if (!occupied_.test(index)) {
+        occupied_.set(index);
+        ++dense_count_;
+        if (best_index_ == OccupancyBitmap::npos || better(price, dense_[best_index_].price_))
+          best_index_ = index;
+      }
+      return dense_[index];
+    }
+    return sparse_.try_emplace(price, price).first->second;
+  }
+
+  // The level must already be empty
+  void erase(PriceLevel &level) {
+    if (in_band(level.price_)) {
+      auto index = to_index(level.price_);
+      occupied_.reset(index);
+      --dense_count_;
+      if (index == best_index_)
+        best_index_ = Side == OrderSide::Buy ? occupied_.find_prev(index) : occupied_.find_next(index);
+    } else {
+      sparse_.erase(level.price_);
+    }
+  }
+
+  // erase() for the best level, as matching empties them: a map level is
+  // the map's first node, so it goes without a lookup
+  void erase_best(PriceLevel &level) {
+    if (in_band(level.price_))
+      erase(level);
+    else
+      sparse_.erase(sparse_.begin());
+  }
+
+  // Every change to a level's resting quantity goes through here
+  void add_quantity(PriceLevel &level, Quantity delta) {
+    level.quantity_ += delta;
+    if (!depth_.empty() && in_band(level.price_))
+      depth_.add(to_index(level.price_), delta);
+  }
+
+  // Resting quantity at prices at or better than limit. Sparse levels are
+  // walked, so the walk may stop early once 'enough' has been reached.
+  std::int64_t depth_at_or_better(Price limit,
+                                  std::int64_t enough = std::numeric_limits<std::int64_t>::max()) {
+    std::int64_t depth = 0;
+    if (depth_.empty()) {
+      for (auto *level = best(); level != nullptr && !better(limit, level->price_);
+           level = next(*level)) {
+        depth += level->quantity_;
+        if (depth >= enough) return depth;
+      }
+      return depth;
+    }
+    for (auto it = sparse_.begin(); it != sparse_.end() && !better(limit, it->first); ++it) {
+      depth += it->second.quantity_;
+      if (depth >= enough) return depth;
+    }
+    auto top = base_price_ + static_cast<Price>(dense_.size()) - 1;
+    if constexpr (Side == OrderSide::Buy) {
+      if (limit <= base_price_)
+        depth += depth_.total();
+      else if (limit <= top)
+        depth += depth_.total() - depth_.prefix(to_index(limit) - 1);
+    } else {
+      if (limit >= top)
+        depth += depth_.total();
+      else if (limit >= base_price_)
+        depth += depth_.prefix(to_index(limit));
+    }
+    return depth;
+  }
+
+  // Best (top of book) level, nullptr if the side is empty
+  PriceLevel *best() {
+    PriceLevel *dense = best_index_ == OccupancyBitmap::npos ? nullptr : &dense_[best_index_];
+    PriceLevel *sparse = sparse_.empty() ? nullptr : &sparse_.begin()->second;
+    return pick_better(dense, sparse);
+  }
+
+  // Next level after 'level' moving away from the top of book, nullptr at the end
+  PriceLevel *next(const PriceLevel &level) { return next_after(level.price_); }
+
+  // Level at price, or else the first one past it away from the top of book
+  PriceLevel *first_at_or_worse(Price price) {
+    auto *level = find(price);
+    return level != nullptr ? level : next_after(price);
+  }
+
+  std::size_t size() const { return dense_count_ + sparse_.size(); }
+  bool empty() const { return size() == 0; }
+
+private:
+  // First level strictly worse than price, which need not be resting
+  PriceLevel *next_after(Price price) {
+    auto index = OccupancyBitmap::npos;
+    if (!dense_.empty()) {
+      if constexpr (Side == OrderSide::Buy) {
+        if (price >= base_price_ + static_cast<Price>(dense_.size()))
+          index = occupied_.find_last();
+        else if (price > base_price_)
+          index = occupied_.find_prev(to_index(price) - 1);
+      } else {
+        if (price < base_price_)
+          index = occupied_.find_first();
+        else if (in_band(price))
+          index = occupied_.find_next(to_index(price) + 1);
+      }
+    }
+    PriceLevel *dense = index == OccupancyBitmap::npos ? nullptr : &dense_[index];
+    auto it = sparse_.upper_bound(price);
+    PriceLevel *sparse = it == sparse_.end() ? nullptr : &it->second;
+    return pick_better(dense, sparse);
+  }
+
+  bool in_band(Price price) const {
+    return price >= base_price_ &&
+           price - base_price_ < static_cast<Price>(dense_.size());
+  }
+
+  std::size_t to_index(Price price) const {
+    return static_cast<std::size_t>(price - base_price_);
+  }
+
+  static PriceLevel *pick_better(PriceLevel *a, PriceLevel *b) {
+    if (a == nullptr) return b;
+    if (b == nullptr) return a;
+    return better(a->price_, b->price_) ? a : b;
+  }
+
+  Price base_price_;
+  std::vector<PriceLevel> dense_;
+  OccupancyBitmap occupied_;
+  std::size_t dense_count_ = 0;
+  std::size_t best_index_ = OccupancyBitmap::npos; // cached top of the dense band
+  std::pmr::map<Price, PriceLevel, Compare> sparse_; // out-of-band levels
+  FenwickTree depth_;                           // band quantity by tick, if enabled
+};
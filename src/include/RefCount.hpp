@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+
+// Reference count policies for intrusively counted objects (Order). 16 bits:
+// an Order is referenced by its book and a handful of caller handles at most,
+// and the narrow count keeps Order within one cache line. More than
+// MaxRefCount live references would wrap the count and hand the Order back to
+// its pool while still referenced; debug builds assert instead.
+constexpr std::uint32_t MaxRefCount = std::numeric_limits<std::uint16_t>::max();
+
+// Safe when references are taken and dropped on several threads, e.g. a caller
+// keeping an OrderPointer while the book or its GFD prune thread releases its own
+struct AtomicRefCount {
+    std::atomic<std::uint16_t> count_{0};
+
+    void add_ref() {
+        [[maybe_unused]] auto previous = count_.fetch_add(1, std::memory_order_relaxed);
+        assert(previous != MaxRefCount && "Order reference count overflow");
+    }
+    // True when the last reference was dropped
+    bool release() { return count_.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+    std::uint32_t use_count() const { return count_.load(std::memory_order_relaxed); }
+};
+
+// Plain increments: no locked instructions, but every reference to a given
+// object must be taken and dropped on one thread
+struct PlainRefCount {
+    std::uint16_t count_ = 0;
+
+    void add_ref() {
+        assert(count_ != MaxRefCount && "Order reference count overflow");
+        ++count_;
+    }
+    bool release() { return --count_ == 0; }
+    std::uint32_t use_count() const { return count_; }
+};
+
+// Compile-time ownership policy for Order. Define ORDERBOOK_SINGLE_THREADED_ORDERS
+// (CMake option of the same name, or OWNERSHIP=single for the Makefile
+// benchmarks) only when each Order lives and dies on one thread: a
+// MatchingEngine / OrderBookManager deployment, where the matching thread
+// creates and owns every Order, or a single-threaded driver that places no
+// GoodForDay orders on a locked book (its prune thread releases from another thread).
+#ifdef ORDERBOOK_SINGLE_THREADED_ORDERS
+using OrderRefCount = PlainRefCount;
+#else
+using OrderRefCount = AtomicRefCount;
+#endif
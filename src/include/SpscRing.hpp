@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free single-producer/single-consumer queue. Exactly one thread
+// pushes and exactly one thread pops. Each side keeps a cached copy of the
+// other side's index and re-reads the shared one only when the cache says the
+// ring looks full/empty, so the cache lines bounce once per wrap, not per item.
+template<typename T>
+class SpscRing {
+public:
+  // Capacity is rounded up to a power of two
+  explicit SpscRing(std::size_t capacity)
+      : slots_(std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity)),
+        mask_(slots_.size() - 1) {}
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  // Producer side; false when full
+  bool try_push(const T& item) {
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == slots_.size()) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ == slots_.size())
+        return false;
+    }
+    slots_[tail & mask_] = item;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side; false when empty
+  bool try_pop(T& item) {
+    const auto head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_)
+        return false;
+    }
+    item = slots_[head & mask_];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Approximate when called from a third thread
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+  }
+  std::size_t capacity() const { return slots_.size(); }
+
+private:
+  std::vector<T> slots_;
+  std::size_t mask_;
+  // Consumer-owned line
+  alignas(64) std::atomic<std::size_t> head_{0};
+  std::size_t cached_tail_ = 0;
+  // Producer-owned line
+  alignas(64) std::atomic<std::size_t> tail_{0};
+  std::size_t cached_head_ = 0;
+};
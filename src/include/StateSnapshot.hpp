@@ -0,0 +1,67 @@
+#pragma once
+#include "Usings.hpp"
+#include <cstdint>
+#include <type_traits>
+
+// Binary image of a book's resting state, written by OrderBook::save_state()
+// and loaded by OrderBook::restore_state(). Host byte order. Layout:
+//
+//   StateHeader
+//   per level, bids best to worst then asks best to worst:
+//     StateLevel, then level_.orders_ x StateOrder in queue (FIFO) order
+//   timers_ x StateTimer: the expiry of every GoodTillDate order
+//   participants_ x StateParticipant: the participant of every order entered
+//     with one, in each participant's array order
+//
+// Side and price are stored once per level, so an order costs 16 bytes.
+namespace state_snapshot {
+
+constexpr std::uint64_t Magic = 0x3145544154534f42ull; // "BOSTATE1" read as little-endian bytes
+constexpr std::uint32_t Version = 3; // 2: book time and GoodTillDate expiries; 3: participants
+
+struct StateHeader {
+  std::uint64_t magic_ = Magic;
+  std::uint32_t version_ = Version;
+  std::uint32_t reserved_ = 0;
+  std::int64_t tick_nanos_ = 0;  // TickSize the prices are in
+  std::uint64_t sequence_ = 0;   // caller's position, e.g. the journal sequence the state matches
+  std::uint64_t bid_levels_ = 0;
+  std::uint64_t ask_levels_ = 0;
+  std::uint64_t orders_ = 0;
+  std::uint64_t timers_ = 0;
+  Timestamp time_ = 0;           // the book's clock, see OrderBook::advance_time
+  std::uint64_t participants_ = 0;
+};
+
+struct StateLevel {
+  Price price_ = 0;
+  std::uint32_t orders_ = 0;
+  std::uint32_t reserved_ = 0;
+};
+
+struct StateOrder {
+  std::uint32_t order_id_ = 0;
+  std::uint32_t initial_quantity_ = 0;
+  std::uint32_t leaves_ = 0;       // remaining quantity
+  std::uint8_t order_type_ = 0;    // OrderType
+  std::uint8_t reserved_[3] = {};
+};
+
+struct StateTimer {
+  std::uint32_t order_id_ = 0;
+  std::uint32_t reserved_ = 0;
+  Timestamp expiry_ = 0;
+};
+
+struct StateParticipant {
+  std::uint32_t order_id_ = 0;
+  ParticipantId participant_ = 0;
+};
+
+static_assert(sizeof(StateHeader) == 80 && std::is_trivially_copyable_v<StateHeader>);
+static_assert(sizeof(StateLevel) == 16 && std::is_trivially_copyable_v<StateLevel>);
+static_assert(sizeof(StateOrder) == 16 && std::is_trivially_copyable_v<StateOrder>);
+static_assert(sizeof(StateTimer) == 16 && std::is_trivially_copyable_v<StateTimer>);
+static_assert(sizeof(StateParticipant) == 8 && std::is_trivially_copyable_v<StateParticipant>);
+
+} // namespace state_snapshot
@@ -0,0 +1,82 @@
+#pragma once
+#include "Usings.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// Per-instrument tick size. Prices are converted to integer ticks once at the
+// edge (app/test parsers, feed handlers) so the matching core only ever does
+// integer compares and hashing on Price.
+class TickSize{
+    public:
+        static constexpr std::int64_t NanosPerUnit = 1'000'000'000; // tick is stored in 1e-9 units
+
+        // Default tick is 0.01
+        constexpr explicit TickSize(std::int64_t tick_nanos = 10'000'000): tick_nanos_(tick_nanos) {}
+
+        // Parses a tick size such as "0.01" or "0.0005"
+        static TickSize from_string(std::string_view str){
+            auto nanos = parse_nanos(str);
+            if (nanos <= 0)
+                throw std::invalid_argument("Invalid tick size: " + std::string(str));
+            return TickSize(nanos);
+        }
+
+        // Exact decimal parse; rejects prices that are not a multiple of the tick
+        Price to_ticks(std::string_view str) const{
+            auto nanos = parse_nanos(str);
+            if (nanos % tick_nanos_ != 0)
+                throw std::invalid_argument("Price not on tick: " + std::string(str));
+            return nanos / tick_nanos_;
+        }
+
+        // Rounds to the nearest tick, for generated (floating point) prices
+        Price to_ticks(double value) const{
+            return static_cast<Price>(std::llround(value * NanosPerUnit / static_cast<double>(tick_nanos_)));
+        }
+
+        double to_double(Price ticks) const{
+            return static_cast<double>(ticks) * static_cast<double>(tick_nanos_) / NanosPerUnit;
+        }
+
+        std::int64_t get_tick_nanos() const{
+            return tick_nanos_;
+        }
+
+    private:
+        static std::int64_t parse_nanos(std::string_view str){
+            auto dot = str.find('.');
+            auto int_part = str.substr(0, dot);
+            std::int64_t units{};
+            // from_chars reads "-0" as 0, so a sign would turn "-0.50" into 0.50
+            if (!int_part.empty() && (int_part.front() == '-' || int_part.front() == '+'))
+                throw std::invalid_argument("Invalid price: " + std::string(str));
+            auto result = std::from_chars(int_part.data(), int_part.data() + int_part.size(), units);
+            if (int_part.empty() || result.ec != std::errc{} || result.ptr != int_part.data() + int_part.size()
+                || units > std::numeric_limits<std::int64_t>::max() / NanosPerUnit)
+                throw std::invalid_argument("Invalid price: " + std::string(str));
+
+            std::int64_t frac = 0;
+            std::int64_t scale = NanosPerUnit;
+            if (dot != std::string_view::npos){
+                for (char c : str.substr(dot + 1)){
+                    if (c < '0' || c > '9')
+                        throw std::invalid_argument("Invalid price: " + std::string(str));
+                    if (scale == 1){
+                        if (c != '0')
+                            throw std::invalid_argument("Price has too many decimals: " + std::string(str));
+                        continue;
+                    }
+                    scale /= 10;
+                    frac += (c - '0') * scale;
+                }
+            }
+            return units * NanosPerUnit + frac;
+        }
+
+        std::int64_t tick_nanos_;
+};
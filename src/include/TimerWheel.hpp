@@ -0,0 +1,125 @@
+#pragma once
+#include "Usings.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Hierarchical timing wheel over integer ticks. Level l has 64 slots of 64^l
+// ticks each. An entry is filed in the lowest level whose current rotation
+// contains its deadline, and is re-filed one or more levels down when its slot
+// comes up, so each entry moves at most Levels - 1 times: scheduling is O(1)
+// and expiry amortized O(1). advance() reaches the next occupied slot through
+// a 64-bit occupancy word per level; when nothing is due, it costs one compare.
+// Entries cannot be removed. Owners cancel lazily, by ignoring an entry that
+// is no longer current when it fires.
+class TimerWheel {
+public:
+  struct Entry {
+    std::uint64_t deadline_; // ticks
+    OrderId id_;
+  };
+
+  explicit TimerWheel(std::uint64_t now = 0) : elapsed_(now) {}
+
+  std::uint64_t now() const { return elapsed_; }
+  // Pending entries, including the ones their owner has since abandoned
+  std::size_t size() const { return size_; }
+
+  // A deadline at or before now() fires on the next advance()
+  void schedule(std::uint64_t deadline, OrderId id) {
+    file({deadline, id});
+    ++size_;
+  }
+
+  // Moves time to now (never back) and hands fire(id) every entry whose
+  // deadline is at or before it, in deadline order between slots. fire may
+  // call schedule().
+  template <typename Fire> void advance(std::uint64_t now, Fire &&fire) {
+    while (next_ <= now) {
+      const auto level = lowest_occupied_level();
+      const auto slot = next_slot(level);
+      elapsed_ = std::max(elapsed_, next_);
+      occupied_[level] &= ~(std::uint64_t{1} << slot);
+      scratch_.swap(slots_[level][slot]);
+      next_ = std::numeric_limits<std::uint64_t>::max();
+      for (const auto &entry : scratch_) {
+        if (entry.deadline_ <= elapsed_) {
+          --size_;
+          fire(entry.id_);
+        } else {
+          file(entry);
+        }
+      }
+      scratch_.clear();
+      next_ = next_expiration();
+    }
+    elapsed_ = std::max(elapsed_, now);
+  }
+
+private:
+  static constexpr unsigned SlotBits = 6;
+  static constexpr std::size_t Slots = std::size_t{1} << SlotBits;
+  static constexpr unsigned Levels = 6;
+  // Ticks the top level spans in one rotation
+  static constexpr std::uint64_t Span = std::uint64_t{1} << (SlotBits * Levels);
+  static constexpr std::uint64_t TopSlotSpan = Span / Slots;
+
+  static constexpr std::uint64_t slot_span(unsigned level) { return std::uint64_t{1} << (SlotBits * level); }
+
+  void file(const Entry &entry) {
+    // Further out than a top-level rotation (less one slot, so a slot is
+    // never shared by two rotations): parked at the far end and re-filed
+    // when that slot comes up
+    const auto at = std::min(std::max(entry.deadline_, elapsed_), elapsed_ + (Span - TopSlotSpan));
+    const auto differing = std::min((at ^ elapsed_) | (Slots - 1), Span - 1);
+    const auto level = static_cast<unsigned>((63 - std::countl_zero(differing)) / SlotBits);
+    const auto slot = static_cast<unsigned>((at >> (SlotBits * level)) & (Slots - 1));
+    slots_[level][slot].push_back(entry);
+    occupied_[level] |= std::uint64_t{1} << slot;
+    next_ = std::min(next_, at & ~(slot_span(level) - 1));
+  }
+
+  unsigned lowest_occupied_level() const {
+    unsigned level = 0;
+    while (occupied_[level] == 0)
+      ++level;
+    return level;
+  }
+
+  // First occupied slot of level at or after the one now() is in; only the
+  // top level wraps into its next rotation
+  unsigned next_slot(unsigned level) const {
+    const auto current = static_cast<unsigned>((elapsed_ >> (SlotBits * level)) & (Slots - 1));
+    const auto ahead = static_cast<unsigned>(std::countr_zero(std::rotr(occupied_[level], static_cast<int>(current))));
+    return (current + ahead) & (Slots - 1);
+  }
+
+  // Start of the earliest occupied slot: entries in lower levels always come
+  // before any in the levels above
+  std::uint64_t next_expiration() const {
+    for (unsigned level = 0; level < Levels; ++level) {
+      if (occupied_[level] == 0)
+        continue;
+      const auto slot = next_slot(level);
+      const auto rotation = slot_span(level + 1);
+      auto start = (elapsed_ & ~(rotation - 1)) + slot * slot_span(level);
+      if (start + slot_span(level) <= elapsed_)
+        start += rotation;
+      return start;
+    }
+    return std::numeric_limits<std::uint64_t>::max();
+  }
+
+  std::uint64_t elapsed_;
+  std::uint64_t next_ = std::numeric_limits<std::uint64_t>::max();
+  std::size_t size_ = 0;
+  std::array<std::uint64_t, Levels> occupied_{};
+  // Slot vectors keep their capacity: after warm-up, scheduling and advancing
+  // allocate nothing
+  std::array<std::array<std::vector<Entry>, Slots>, Levels> slots_;
+  std::vector<Entry> scratch_;
+};
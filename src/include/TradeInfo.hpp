@@ -1,6 +1,10 @@
 #pragma once
+#include <concepts>
 #include <iostream>
+#include <type_traits>
+#include <utility>
 #include "Usings.hpp"
+#include "TickSize.hpp"
 class TradeInfo{
     public:
     struct SideInfoTrade{
@@ -11,10 +15,15 @@ class TradeInfo{
     TradeInfo(SideInfoTrade buy, SideInfoTrade sell, Price trade_price, Quantity quantity):
     buy_(buy), sell_(sell), trade_price_(trade_price), quantity_(quantity) {}
 
-    void print(){
-        std::cout<<"Trade: Buy Order #"<<buy_.id_<<" matched with sell order #"<<sell_.id_<<" at  Price="<<trade_price_<<" and Quanity="<<quantity_<<std::endl;
+    void print(const TickSize& tick_size = TickSize{}){
+        std::cout<<"Trade: Buy Order #"<<buy_.id_<<" matched with sell order #"<<sell_.id_<<" at  Price="<<tick_size.to_double(trade_price_)<<" and Quanity="<<quantity_<<std::endl;
     }
 
+    const SideInfoTrade& get_buy() const { return buy_; }
+    const SideInfoTrade& get_sell() const { return sell_; }
+    Price get_trade_price() const { return trade_price_; }
+    Quantity get_quantity() const { return quantity_; }
+
     private:
     SideInfoTrade buy_,sell_;
     Quantity quantity_; //the quantity which got traded.
@@ -26,9 +35,9 @@ class TradeInfos{
     public:
     
     void print_stats(){std::cout<<trades_made_.size()<<" numbers of orders executed"<<std::endl;}
-    void print_all_trades(){
+    void print_all_trades(const TickSize& tick_size = TickSize{}){
         for (auto trade: trades_made_){
-            trade.print();
+            trade.print(tick_size);
         }
     }
     template<typename ...Ts>
@@ -37,4 +46,32 @@ class TradeInfos{
     }
     
         std::vector<TradeInfo> trades_made_;
-    };
\ No newline at end of file
+    };
+
+// Where the matcher reports fills: either appended to a caller-owned
+// TradeInfos (reuse it and its capacity stops allocating), or handed one by one
+// to a callback. Non-owning; the target must outlive the call it is passed to.
+class TradeSink {
+    public:
+    TradeSink(TradeInfos& trades)
+    : target_(&trades), on_trade_([](void* target, const TradeInfo& trade) {
+        auto& trades = static_cast<TradeInfos*>(target)->trades_made_;
+        if (trades.capacity() == 0) trades.reserve(10);
+        trades.push_back(trade);
+    }) {}
+
+    template<typename OnTrade>
+        requires (!std::same_as<std::remove_cvref_t<OnTrade>, TradeSink>) &&
+                 std::invocable<std::remove_reference_t<OnTrade>&, const TradeInfo&>
+    TradeSink(OnTrade&& on_trade)
+    : target_(const_cast<void*>(static_cast<const void*>(std::addressof(on_trade)))),
+      on_trade_([](void* target, const TradeInfo& trade) {
+        (*static_cast<std::remove_reference_t<OnTrade>*>(target))(trade);
+    }) {}
+
+    void operator()(const TradeInfo& trade) const { on_trade_(target_, trade); }
+
+    private:
+    void* target_;
+    void (*on_trade_)(void*, const TradeInfo&);
+};
@@ -1,8 +1,12 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 
 
-using Price = double;
+using Price = std::int64_t; // integer ticks, see TickSize.hpp
 using Quantity = int;
 using OrderId = int;
-using OrderIds = std::vector<OrderId> ;
\ No newline at end of file
+using OrderIds = std::vector<OrderId> ;
+using SymbolId = std::uint32_t;
+using ParticipantId = std::uint32_t; // trading session that entered an order; 0 = none
+using Timestamp = std::uint64_t; // nanoseconds since the Unix epoch
@@ -5,5 +5,8 @@
 
 struct Constants
 {
-    static constexpr Price InvalidPrice = std::numeric_limits<Price>::quiet_NaN();
-};
\ No newline at end of file
+    static constexpr Price InvalidPrice = std::numeric_limits<Price>::min();
+    // Prices Market orders are normalized to so they cross every resting level
+    static constexpr Price MarketBuyPrice = std::numeric_limits<Price>::max();
+    static constexpr Price MarketSellPrice = 0;
+};